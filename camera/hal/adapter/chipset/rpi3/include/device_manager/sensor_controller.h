@@ -31,10 +31,12 @@ public:
     RetCode PowerUp();
     RetCode PowerDown();
     RetCode Configure(std::shared_ptr<CameraStandard::CameraMetadata> meta);
-    RetCode Start(int buffCont, DeviceFormat& format);
+    RetCode Start(int buffCont, DeviceFormat& format, enum v4l2_memory memType);
     RetCode Stop();
 
     RetCode SendFrameBuffer(std::shared_ptr<FrameSpec> buffer);
+    // buffer of an index gets the memory and dma-buf fd of the device for V4L2_MEMORY_MMAP, valid until Stop.
+    RetCode MapBuffer(std::shared_ptr<IBuffer> buffer);
 
     void SetNodeCallBack(const NodeBufferCb cb);
     void SetMetaDataCallBack(const MetaDataCb cb);
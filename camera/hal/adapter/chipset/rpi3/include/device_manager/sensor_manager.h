@@ -32,7 +32,7 @@ public:
     std::shared_ptr<IController> GetController(ControllerId controllerId, std::string hardwareName);
 
     void Configure(std::shared_ptr<CameraStandard::CameraMetadata> meta);
-    RetCode Start(std::string hardwareName, int buffCont, DeviceFormat& format);
+    RetCode Start(std::string hardwareName, int buffCont, DeviceFormat& format, enum v4l2_memory memType);
     RetCode Stop(std::string hardwareName);
     RetCode PowerUp(std::string hardwareName);
     RetCode PowerDown(std::string hardwareName);
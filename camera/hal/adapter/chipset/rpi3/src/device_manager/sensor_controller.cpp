@@ -60,7 +60,7 @@ RetCode SensorController::Configure(std::shared_ptr<CameraStandard::CameraMetada
     return SendSensorMetaData(meta);
 };
 
-RetCode SensorController::Start(int buffCont, DeviceFormat& format)
+RetCode SensorController::Start(int buffCont, DeviceFormat& format, enum v4l2_memory memType)
 {
     CAMERA_LOGI("%s Start", __FUNCTION__);
     std::lock_guard<std::mutex> l(startSensorLock_);
@@ -69,6 +69,7 @@ RetCode SensorController::Start(int buffCont, DeviceFormat& format)
         buffCont_ = buffCont;
         sensorVideo_->start(GetName());
         sensorVideo_->ConfigSys(GetName(), CMD_V4L2_SET_FORMAT, format);
+        sensorVideo_->SetMemoryType(GetName(), memType);
         sensorVideo_->ReqBuffers(GetName(), buffCont_);
         startSensorState_ = true;
     }
@@ -104,6 +105,11 @@ RetCode SensorController::SendFrameBuffer(std::shared_ptr<FrameSpec> buffer)
     return RC_OK;
 }
 
+RetCode SensorController::MapBuffer(std::shared_ptr<IBuffer> buffer)
+{
+    return sensorVideo_->MapBuffer(GetName(), buffer);
+}
+
 void SensorController::SetNodeCallBack(const NodeBufferCb cb)
 {
     CAMERA_LOGI("SensorController SetNodeCallBack entry");
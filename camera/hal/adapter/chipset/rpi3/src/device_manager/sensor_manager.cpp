@@ -84,11 +84,12 @@ RetCode SensorManager::PowerDown(std::string hardwareName)
     return RC_ERROR;
 }
 
-RetCode SensorManager::Start(std::string hardwareName, int buffCont, DeviceFormat& format)
+RetCode SensorManager::Start(std::string hardwareName, int buffCont, DeviceFormat& format,
+    enum v4l2_memory memType)
 {
     for (auto iter = sensorList_.cbegin(); iter != sensorList_.cend(); iter++) {
         if ((*iter)->GetName() == hardwareName) {
-            return (*iter)->Start(buffCont, format);
+            return (*iter)->Start(buffCont, format, memType);
         }
     }
     return RC_ERROR;
@@ -13,6 +13,9 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <gtest/gtest.h>
 #include <v4l2_dev.h>
 #include <v4l2_uvc.h>
@@ -187,4 +190,199 @@ HWTEST_F(UtestV4L2Dev, ReleaseAll, TestSize.Level0)
 
     V4L2UVC_->V4L2UvcDetectUnInit();
 }
+
+HWTEST_F(UtestV4L2Dev, VividExportImportDmabuf, TestSize.Level0)
+{
+    constexpr uint32_t width = 640;
+    constexpr uint32_t height = 480;
+    constexpr uint32_t bufferCount = 4;
+
+    // runs against the vivid software driver: buffers exported from mmap are imported back as dma-buf.
+    std::string devname = "vivid";
+    std::vector<std::string> cameraIDs = {devname};
+    EXPECT_EQ(RC_OK, HosV4L2Dev::Init(cameraIDs));
+
+    std::shared_ptr<HosV4L2Dev> dev = std::make_shared<HosV4L2Dev>();
+    int rc = dev->start(devname);
+    EXPECT_EQ(RC_OK, rc);
+    if (rc != RC_OK) {
+        return;
+    }
+
+    DeviceFormat format = {};
+    format.fmtdesc.pixelformat = V4L2_PIX_FMT_YUYV;
+    format.fmtdesc.width = width;
+    format.fmtdesc.height = height;
+    EXPECT_EQ(RC_OK, dev->ConfigSys(devname, CMD_V4L2_SET_FORMAT, format));
+    EXPECT_EQ(RC_OK, dev->ConfigSys(devname, CMD_V4L2_GET_FORMAT, format));
+
+    int dmaFds[bufferCount];
+    EXPECT_EQ(RC_OK, dev->SetMemoryType(devname, V4L2_MEMORY_MMAP));
+    EXPECT_EQ(RC_OK, dev->ReqBuffers(devname, bufferCount));
+    for (uint32_t i = 0; i < bufferCount; ++i) {
+        int exportFd = -1;
+        EXPECT_EQ(RC_OK, dev->ExportBuffer(devname, i, exportFd));
+        dmaFds[i] = dup(exportFd);
+        EXPECT_EQ(true, dmaFds[i] >= 0);
+    }
+    EXPECT_EQ(RC_OK, dev->ReleaseBuffers(devname));
+
+    std::atomic<uint32_t> frameCount = 0;
+    EXPECT_EQ(RC_OK, dev->SetMemoryType(devname, V4L2_MEMORY_DMABUF));
+    EXPECT_EQ(RC_OK, dev->ReqBuffers(devname, bufferCount));
+    EXPECT_EQ(RC_OK, dev->SetCallback([&frameCount](std::shared_ptr<FrameSpec> buffer) {
+        frameCount++;
+    }));
+    for (uint32_t i = 0; i < bufferCount; ++i) {
+        std::shared_ptr<FrameSpec> frameSpec = std::make_shared<FrameSpec>();
+        frameSpec->buffer_ = std::make_shared<IBuffer>();
+        frameSpec->buffer_->SetIndex(i);
+        frameSpec->buffer_->SetSize(format.fmtdesc.sizeimage);
+        frameSpec->buffer_->SetFileDescriptor(dmaFds[i]);
+        frameSpec->bufferPoolId_ = 0;
+        EXPECT_EQ(RC_OK, dev->CreatBuffer(devname, frameSpec));
+    }
+    EXPECT_EQ(RC_OK, dev->StartStream(devname));
+    sleep(1);
+
+    dev->StopStream(devname);
+    dev->ReleaseBuffers(devname);
+    dev->stop(devname);
+    for (uint32_t i = 0; i < bufferCount; ++i) {
+        close(dmaFds[i]);
+    }
+    EXPECT_EQ(true, frameCount > 0);
+}
+
+HWTEST_F(UtestV4L2Dev, VividMmapWithoutCopy, TestSize.Level0)
+{
+    constexpr uint32_t width = 640;
+    constexpr uint32_t height = 480;
+    constexpr uint32_t bufferCount = 4;
+
+    // runs against the vivid software driver: mapped buffers are handed out as they are, without copy.
+    std::string devname = "vivid";
+    std::vector<std::string> cameraIDs = {devname};
+    EXPECT_EQ(RC_OK, HosV4L2Dev::Init(cameraIDs));
+
+    std::shared_ptr<HosV4L2Dev> dev = std::make_shared<HosV4L2Dev>();
+    int rc = dev->start(devname);
+    EXPECT_EQ(RC_OK, rc);
+    if (rc != RC_OK) {
+        return;
+    }
+
+    DeviceFormat format = {};
+    format.fmtdesc.pixelformat = V4L2_PIX_FMT_YUYV;
+    format.fmtdesc.width = width;
+    format.fmtdesc.height = height;
+    EXPECT_EQ(RC_OK, dev->ConfigSys(devname, CMD_V4L2_SET_FORMAT, format));
+
+    std::vector<void*> addrs(bufferCount, nullptr);
+    std::atomic<uint32_t> frameCount = 0;
+    std::atomic<uint32_t> mappedCount = 0;
+    EXPECT_EQ(RC_OK, dev->SetMemoryType(devname, V4L2_MEMORY_MMAP));
+    EXPECT_EQ(RC_OK, dev->ReqBuffers(devname, bufferCount));
+    EXPECT_EQ(RC_OK, dev->SetCallback([&](std::shared_ptr<FrameSpec> buffer) {
+        frameCount++;
+        uint32_t index = static_cast<uint32_t>(buffer->buffer_->GetIndex());
+        if (index < bufferCount && buffer->buffer_->GetVirAddress() == addrs[index]) {
+            mappedCount++;
+        }
+    }));
+    for (uint32_t i = 0; i < bufferCount; ++i) {
+        std::shared_ptr<FrameSpec> frameSpec = std::make_shared<FrameSpec>();
+        frameSpec->buffer_ = std::make_shared<IBuffer>();
+        frameSpec->buffer_->SetIndex(i);
+        EXPECT_EQ(RC_OK, dev->MapBuffer(devname, frameSpec->buffer_));
+        addrs[i] = frameSpec->buffer_->GetVirAddress();
+        EXPECT_EQ(true, addrs[i] != nullptr && frameSpec->buffer_->GetSize() > 0);
+        frameSpec->bufferPoolId_ = 0;
+        EXPECT_EQ(RC_OK, dev->CreatBuffer(devname, frameSpec));
+    }
+    EXPECT_EQ(RC_OK, dev->StartStream(devname));
+    sleep(1);
+
+    dev->StopStream(devname);
+    dev->ReleaseBuffers(devname);
+    dev->stop(devname);
+    EXPECT_EQ(true, frameCount > 0);
+    EXPECT_EQ(frameCount.load(), mappedCount.load());
+}
+
+HWTEST_F(UtestV4L2Dev, VividFirstFrameLatency, TestSize.Level1)
+{
+    constexpr uint32_t width = 640;
+    constexpr uint32_t height = 480;
+    constexpr uint32_t bufferCount = 4;
+    constexpr int32_t waitFrameMs = 2000;
+    constexpr int64_t maxLatencyMs = 500;
+
+    std::string devname = "vivid";
+    std::vector<std::string> cameraIDs = {devname};
+    EXPECT_EQ(RC_OK, HosV4L2Dev::Init(cameraIDs));
+
+    std::shared_ptr<HosV4L2Dev> dev = std::make_shared<HosV4L2Dev>();
+    int rc = dev->start(devname);
+    EXPECT_EQ(RC_OK, rc);
+    if (rc != RC_OK) {
+        return;
+    }
+
+    DeviceFormat format = {};
+    format.fmtdesc.pixelformat = V4L2_PIX_FMT_YUYV;
+    format.fmtdesc.width = width;
+    format.fmtdesc.height = height;
+    EXPECT_EQ(RC_OK, dev->ConfigSys(devname, CMD_V4L2_SET_FORMAT, format));
+    EXPECT_EQ(RC_OK, dev->ConfigSys(devname, CMD_V4L2_GET_FORMAT, format));
+    EXPECT_EQ(RC_OK, dev->SetMemoryType(devname, V4L2_MEMORY_MMAP));
+    EXPECT_EQ(RC_OK, dev->ReqBuffers(devname, bufferCount));
+
+    std::vector<std::vector<uint8_t>> memory(bufferCount);
+    std::mutex l;
+    std::condition_variable cv;
+    bool frameArrived = false;
+    std::chrono::steady_clock::time_point firstFrame;
+    EXPECT_EQ(RC_OK, dev->SetCallback([&](std::shared_ptr<FrameSpec> buffer) {
+        std::lock_guard<std::mutex> lock(l);
+        if (!frameArrived) {
+            firstFrame = std::chrono::steady_clock::now();
+            frameArrived = true;
+            cv.notify_one();
+        }
+    }));
+    for (uint32_t i = 0; i < bufferCount; ++i) {
+        std::shared_ptr<FrameSpec> frameSpec = std::make_shared<FrameSpec>();
+        frameSpec->buffer_ = std::make_shared<IBuffer>();
+        frameSpec->buffer_->SetIndex(i);
+        frameSpec->buffer_->SetSize(format.fmtdesc.sizeimage);
+        // mmap frames are copied into the buffer's own memory.
+        memory[i].resize(format.fmtdesc.sizeimage);
+        frameSpec->buffer_->SetVirAddress(memory[i].data());
+        frameSpec->bufferPoolId_ = 0;
+        EXPECT_EQ(RC_OK, dev->CreatBuffer(devname, frameSpec));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(RC_OK, dev->StartStream(devname));
+    {
+        std::unique_lock<std::mutex> lock(l);
+        cv.wait_for(lock, std::chrono::milliseconds(waitFrameMs), [&frameArrived] { return frameArrived; });
+    }
+    EXPECT_EQ(true, frameArrived);
+
+    auto stop = std::chrono::steady_clock::now();
+    dev->StopStream(devname);
+    auto stopped = std::chrono::steady_clock::now();
+    dev->ReleaseBuffers(devname);
+    dev->stop(devname);
+
+    if (frameArrived) {
+        int64_t latency = std::chrono::duration_cast<std::chrono::milliseconds>(firstFrame - start).count();
+        std::cout << "start to first frame latency " << latency << " ms" << std::endl;
+        EXPECT_EQ(true, latency < maxLatencyMs);
+    }
+    std::cout << "stop stream latency " <<
+        std::chrono::duration_cast<std::chrono::microseconds>(stopped - stop).count() << " us" << std::endl;
+}
 } // namespace OHOS::Camera
\ No newline at end of file
@@ -18,9 +18,13 @@
 
 #include <mutex>
 #include <map>
+#include <vector>
 #include <cstring>
 #include <linux/videodev2.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "v4l2_common.h"
 #if defined(V4L2_UTEST) || defined (V4L2_MAIN_TEST)
 #include "v4l2_temp.h"
@@ -43,14 +47,40 @@ public:
 
     RetCode V4L2AllocBuffer(int fd, const std::shared_ptr<FrameSpec>& frameSpec);
 
+    // gives the buffer the mapped memory and the exported fd of the device buffer of its index, frames are
+    // dequeued into it without copy. the memory is unmapped and the fd closed when buffers are released.
+    RetCode V4L2MapBuffer(int fd, const std::shared_ptr<IBuffer>& buffer);
+
+    // dma-buf fd of a mapped buffer, it's owned by HosV4L2Buffers and closed when buffers are released.
+    RetCode V4L2ExportBuffer(int fd, unsigned int index, int& dmaFd);
+
     void SetCallback(BufCallback cb);
 
+    // memory type of the device fd, the one given to constructor is used if it's not set.
+    void SetMemoryType(int fd, enum v4l2_memory memType);
+    enum v4l2_memory GetMemoryType(int fd);
+
+private:
+    RetCode V4L2MmapBuffers(int fd, unsigned int buffCont);
+    void V4L2MunmapBuffers(int fd);
+    RetCode V4L2CopyMmapBuffer(int fd, unsigned int index, unsigned int bytesUsed,
+        const std::shared_ptr<IBuffer>& buffer);
+
 private:
     BufCallback dequeueBuffer_;
 
     using FrameMap = std::map<unsigned int, std::shared_ptr<FrameSpec>>;
     std::map<int, FrameMap> queueBuffers_;
 
+    // planes mapped from driver for V4L2_MEMORY_MMAP, buffer index is the vector index.
+    struct MmapPlane {
+        void* addr = MAP_FAILED;
+        unsigned int length = 0;
+        int dmaFd = -1;
+    };
+    std::map<int, std::vector<MmapPlane>> mmapPlanes_;
+    std::map<int, enum v4l2_memory> memoryTypes_;
+
     std::mutex bufferLock_;
 
     enum v4l2_memory memoryType_;
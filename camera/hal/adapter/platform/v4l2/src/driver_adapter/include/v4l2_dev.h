@@ -15,6 +15,9 @@
 #ifndef HOS_CAMERA_V4L2_DEV_H
 #define HOS_CAMERA_V4L2_DEV_H
 
+#include <atomic>
+#include <condition_variable>
+#include <list>
 #include <map>
 #include <mutex>
 #include <thread>
@@ -61,8 +64,14 @@ public:
 
     RetCode QuerySetting(const std::string& cameraID, AdapterCmd command, int* args);
 
+    RetCode SetMemoryType(const std::string& cameraID, enum v4l2_memory memType);
+
     RetCode ReqBuffers(const std::string& cameraID, unsigned int buffCont);
 
+    RetCode MapBuffer(const std::string& cameraID, const std::shared_ptr<IBuffer>& buffer);
+
+    RetCode ExportBuffer(const std::string& cameraID, unsigned int index, int& dmaFd);
+
     RetCode CreatBuffer(const std::string& cameraID, const std::shared_ptr<FrameSpec>& frameSpec);
 
     RetCode StartStream(const std::string& cameraID);
@@ -98,17 +107,37 @@ public:
 private:
     int GetCurrentFd(const std::string& cameraID);
     void loopBuffers();
-    RetCode CreateEpoll(int fd, const unsigned int streamNumber);
+    void dispatchBuffers();
+    void DispatchBuffer(const std::shared_ptr<FrameSpec>& frameSpec);
+    void WaitDispatched();
+    RetCode CreateEpoll();
+    RetCode AddEpoll(int fd);
+    void ArmEpoll(int fd);
+    bool IsWatched(int fd);
     void EraseEpoll(int fd);
+    RetCode StartLoop();
+    void StopLoop();
     RetCode ConfigFps(const int fd, DeviceFormat& format, V4l2FmtCmd command);
 
-    int eventFd_ = 0;
+    // eventfd wakes up the epoll thread when the loop stops, device fds are added and removed at any time.
+    int eventFd_ = -1;
     std::thread* streamThread_ = nullptr;
+    std::atomic_bool loopRunning_ = false;
     unsigned int streamNumber_ = 0;
 
-    int epollFd_ = 0;
+    int epollFd_ = -1;
     std::vector<epoll_event> epollEvent_;
     std::mutex epollLock_;
+    // held while a frame is dequeued, StopStream waits on it for the frame to be dispatched.
+    std::mutex dequeueLock_;
+
+    // dequeued frames are handed to the callback on dispatch thread, epoll thread only does DQBUF.
+    std::thread* dispatchThread_ = nullptr;
+    std::list<std::shared_ptr<FrameSpec>> dispatchQueue_;
+    std::mutex dispatchLock_;
+    std::condition_variable dispatchCv_;
+    bool dispatching_ = false;
+    BufCallback bufferCb_ = nullptr;
 
     std::shared_ptr<HosV4L2Buffers> myBuffers_ = nullptr;
     std::shared_ptr<HosV4L2Streams> myStreams_ = nullptr;
@@ -48,6 +48,11 @@ public:
         return usage_;
     }
 
+    int32_t GetFileDescriptor()
+    {
+        return fd_;
+    }
+
     void SetIndex(const uint32_t index)
     {
         index_ = index;
@@ -72,11 +77,18 @@ public:
         return;
     }
 
+    void SetFileDescriptor(const int32_t fd)
+    {
+        fd_ = fd;
+        return;
+    }
+
 private:
     int32_t index_ = -1;
     uint32_t size_ = 0;
     void* virAddr_ = nullptr;
     uint64_t usage_ = 0;
+    int32_t fd_ = -1;
 };
 
 struct FrameSpec {
@@ -14,6 +14,7 @@
  */
 
 #include "v4l2_buffer.h"
+#include "securec.h"
 
 namespace OHOS::Camera {
 HosV4L2Buffers::HosV4L2Buffers(enum v4l2_memory memType, enum v4l2_buf_type bufferType)
@@ -26,24 +27,26 @@ HosV4L2Buffers::~HosV4L2Buffers() {}
 RetCode HosV4L2Buffers::V4L2ReqBuffers(int fd, int unsigned buffCont)
 {
     struct v4l2_requestbuffers req = {};
+    enum v4l2_memory memType = GetMemoryType(fd);
 
-    CAMERA_LOGD("V4L2ReqBuffers buffCont %d\n", buffCont);
+    CAMERA_LOGD("V4L2ReqBuffers buffCont %d memory %d\n", buffCont, memType);
 
     req.count = buffCont;
     req.type = bufferType_;
-    req.memory = memoryType_;
+    req.memory = memType;
 
     if (ioctl(fd, VIDIOC_REQBUFS, &req) < 0) {
         CAMERA_LOGE("does not support memory mapping %s\n", strerror(errno));
         return RC_ERROR;
     }
 
-    if (req.count != buffCont) {
+    if (req.count != buffCont || (memType == V4L2_MEMORY_MMAP && buffCont > 0 &&
+        V4L2MmapBuffers(fd, buffCont) == RC_ERROR)) {
         CAMERA_LOGE("error Insufficient buffer memory on \n");
 
         req.count = 0;
         req.type = bufferType_;
-        req.memory = memoryType_;
+        req.memory = memType;
         if (ioctl(fd, VIDIOC_REQBUFS, &req) < 0) {
             CAMERA_LOGE("V4L2ReqBuffers does not release buffer	%s\n", strerror(errno));
             return RC_ERROR;
@@ -55,6 +58,96 @@ RetCode HosV4L2Buffers::V4L2ReqBuffers(int fd, int unsigned buffCont)
     return RC_OK;
 }
 
+RetCode HosV4L2Buffers::V4L2MmapBuffers(int fd, unsigned int buffCont)
+{
+    std::vector<MmapPlane> planes(buffCont);
+    for (unsigned int i = 0; i < buffCont; ++i) {
+        struct v4l2_buffer buf = {};
+        buf.type = bufferType_;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (ioctl(fd, VIDIOC_QUERYBUF, &buf) < 0) {
+            CAMERA_LOGE("error: ioctl VIDIOC_QUERYBUF failed: %s\n", strerror(errno));
+            break;
+        }
+
+        planes[i].addr = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buf.m.offset);
+        if (planes[i].addr == MAP_FAILED) {
+            CAMERA_LOGE("error: mmap buffer %d failed: %s\n", i, strerror(errno));
+            break;
+        }
+        planes[i].length = buf.length;
+
+        // export is optional, drivers without VIDIOC_EXPBUF still stream with mapped memory.
+        struct v4l2_exportbuffer expbuf = {};
+        expbuf.type = bufferType_;
+        expbuf.index = i;
+        expbuf.flags = O_CLOEXEC | O_RDWR;
+        if (ioctl(fd, VIDIOC_EXPBUF, &expbuf) == 0) {
+            planes[i].dmaFd = expbuf.fd;
+        } else {
+            CAMERA_LOGD("VIDIOC_EXPBUF index %d: %s\n", i, strerror(errno));
+        }
+        CAMERA_LOGD("V4L2MmapBuffers index = %d, length = %d, addr = %p, dmaFd = %d\n",
+            i, buf.length, planes[i].addr, planes[i].dmaFd);
+    }
+
+    std::lock_guard<std::mutex> l(bufferLock_);
+    mmapPlanes_[fd] = std::move(planes);
+    for (auto& it : mmapPlanes_[fd]) {
+        if (it.addr == MAP_FAILED) {
+            V4L2MunmapBuffers(fd);
+            return RC_ERROR;
+        }
+    }
+    return RC_OK;
+}
+
+void HosV4L2Buffers::V4L2MunmapBuffers(int fd)
+{
+    auto itr = mmapPlanes_.find(fd);
+    if (itr == mmapPlanes_.end()) {
+        return;
+    }
+
+    for (auto& it : itr->second) {
+        if (it.addr != MAP_FAILED) {
+            munmap(it.addr, it.length);
+        }
+        if (it.dmaFd >= 0) {
+            close(it.dmaFd);
+        }
+    }
+    mmapPlanes_.erase(itr);
+}
+
+RetCode HosV4L2Buffers::V4L2CopyMmapBuffer(int fd, unsigned int index, unsigned int bytesUsed,
+    const std::shared_ptr<IBuffer>& buffer)
+{
+    auto itr = mmapPlanes_.find(fd);
+    if (itr == mmapPlanes_.end() || index >= itr->second.size() || buffer == nullptr ||
+        buffer->GetVirAddress() == nullptr) {
+        CAMERA_LOGE("error: V4L2CopyMmapBuffer buffer %d is not mapped\n", index);
+        return RC_ERROR;
+    }
+
+    // a buffer mapped by V4L2MapBuffer holds the frame already. any other buffer keeps its own memory,
+    // e.g. a surface buffer which goes to the consumer, so the frame is copied into it as a fallback.
+    const MmapPlane& plane = itr->second[index];
+    if (buffer->GetVirAddress() == plane.addr) {
+        return RC_OK;
+    }
+    unsigned int size = bytesUsed > 0 && bytesUsed < plane.length ? bytesUsed : plane.length;
+    if (size > buffer->GetSize()) {
+        size = buffer->GetSize();
+    }
+    if (memcpy_s(buffer->GetVirAddress(), buffer->GetSize(), plane.addr, size) != 0) {
+        CAMERA_LOGE("error: V4L2CopyMmapBuffer buffer %d copy failed\n", index);
+        return RC_ERROR;
+    }
+    return RC_OK;
+}
+
 RetCode HosV4L2Buffers::V4L2QueueBuffer(int fd, const std::shared_ptr<FrameSpec>& frameSpec)
 {
     struct v4l2_buffer buf = {};
@@ -66,10 +159,16 @@ RetCode HosV4L2Buffers::V4L2QueueBuffer(int fd, const std::shared_ptr<FrameSpec>
 
     buf.index = (uint32_t)frameSpec->buffer_->GetIndex();
     buf.type = bufferType_;
-    buf.memory = memoryType_;
-
-    buf.m.userptr = (unsigned long)frameSpec->buffer_->GetVirAddress();
-    buf.length = frameSpec->buffer_->GetSize();
+    buf.memory = GetMemoryType(fd);
+
+    // mmap buffers are owned by driver, only the index is queued.
+    if (buf.memory == V4L2_MEMORY_USERPTR) {
+        buf.m.userptr = (unsigned long)frameSpec->buffer_->GetVirAddress();
+        buf.length = frameSpec->buffer_->GetSize();
+    } else if (buf.memory == V4L2_MEMORY_DMABUF) {
+        buf.m.fd = frameSpec->buffer_->GetFileDescriptor();
+        buf.length = frameSpec->buffer_->GetSize();
+    }
 
     CAMERA_LOGD("V4L2QueueBuffer buf.index = %d, buf.length = %d, buf.m.userptr = %p\n",
         buf.index, buf.length, (void*)buf.m.userptr);
@@ -101,7 +200,7 @@ RetCode HosV4L2Buffers::V4L2DqueueBuffer(int fd)
     struct v4l2_buffer buf = {};
 
     buf.type = bufferType_;
-    buf.memory = memoryType_;
+    buf.memory = GetMemoryType(fd);
 
     int rc = ioctl(fd, VIDIOC_DQBUF, &buf);
     if (rc < 0) {
@@ -130,6 +229,12 @@ RetCode HosV4L2Buffers::V4L2DqueueBuffer(int fd)
         return RC_ERROR;
     }
 
+    // pool buffers are the mapped planes, only a buffer with memory of its own is copied.
+    if (buf.memory == V4L2_MEMORY_MMAP) {
+        std::lock_guard<std::mutex> l(bufferLock_);
+        (void)V4L2CopyMmapBuffer(fd, buf.index, buf.bytesused, Iter->second->buffer_);
+    }
+
     // callback to up
     dequeueBuffer_(Iter->second);
     std::lock_guard<std::mutex> l(bufferLock_);
@@ -148,13 +253,28 @@ RetCode HosV4L2Buffers::V4L2AllocBuffer(int fd, const std::shared_ptr<FrameSpec>
         return RC_ERROR;
     }
 
-    switch (memoryType_) {
-        case V4L2_MEMORY_MMAP:
-            // to do something
+    switch (GetMemoryType(fd)) {
+        case V4L2_MEMORY_MMAP: {
+            std::lock_guard<std::mutex> l(bufferLock_);
+            auto itr = mmapPlanes_.find(fd);
+            uint32_t index = (uint32_t)frameSpec->buffer_->GetIndex();
+            if (itr == mmapPlanes_.end() || index >= itr->second.size()) {
+                CAMERA_LOGE("error: V4L2_MEMORY_MMAP buffer %d is not mapped\n", index);
+                return RC_ERROR;
+            }
+
+            // a buffer which isn't the plane itself gets the frame copied on dequeue, it has to hold one.
+            if (frameSpec->buffer_->GetVirAddress() != itr->second[index].addr &&
+                itr->second[index].length > frameSpec->buffer_->GetSize()) {
+                CAMERA_LOGE("ERROR:user buff %d < V4L2 buf.length %d\n", frameSpec->buffer_->GetSize(),
+                    itr->second[index].length);
+                return RC_ERROR;
+            }
             break;
+        }
         case V4L2_MEMORY_USERPTR:
             buf.type = bufferType_;
-            buf.memory = memoryType_;
+            buf.memory = V4L2_MEMORY_USERPTR;
             buf.index = (uint32_t)frameSpec->buffer_->GetIndex();
             CAMERA_LOGD("V4L2_MEMORY_USERPTR Print the cnt: %d\n", buf.index);
 
@@ -177,7 +297,26 @@ RetCode HosV4L2Buffers::V4L2AllocBuffer(int fd, const std::shared_ptr<FrameSpec>
             break;
 
         case V4L2_MEMORY_DMABUF:
-            // to do something
+            buf.type = bufferType_;
+            buf.memory = V4L2_MEMORY_DMABUF;
+            buf.index = (uint32_t)frameSpec->buffer_->GetIndex();
+            CAMERA_LOGD("V4L2_MEMORY_DMABUF index: %d fd: %d\n", buf.index, frameSpec->buffer_->GetFileDescriptor());
+
+            // the pipeline buffer must be backed by a dma-buf, memfd needs to be wrapped by udmabuf first.
+            if (frameSpec->buffer_->GetFileDescriptor() < 0) {
+                CAMERA_LOGE("error: V4L2_MEMORY_DMABUF buffer %d has no fd\n", buf.index);
+                return RC_ERROR;
+            }
+
+            if (ioctl(fd, VIDIOC_QUERYBUF, &buf) < 0) {
+                CAMERA_LOGE("error: ioctl VIDIOC_QUERYBUF failed: %s\n", strerror(errno));
+                return RC_ERROR;
+            }
+
+            if (buf.length > frameSpec->buffer_->GetSize()) {
+                CAMERA_LOGE("ERROR:dmabuf size %d < V4L2 buf.length %d\n", frameSpec->buffer_->GetSize(), buf.length);
+                return RC_ERROR;
+            }
             break;
 
         default:
@@ -188,10 +327,44 @@ RetCode HosV4L2Buffers::V4L2AllocBuffer(int fd, const std::shared_ptr<FrameSpec>
     return RC_OK;
 }
 
-RetCode HosV4L2Buffers::V4L2ReleaseBuffers(int fd)
+RetCode HosV4L2Buffers::V4L2MapBuffer(int fd, const std::shared_ptr<IBuffer>& buffer)
 {
     std::lock_guard<std::mutex> l(bufferLock_);
-    queueBuffers_.erase(fd);
+    auto itr = mmapPlanes_.find(fd);
+    if (buffer == nullptr || itr == mmapPlanes_.end() || buffer->GetIndex() < 0 ||
+        static_cast<size_t>(buffer->GetIndex()) >= itr->second.size()) {
+        CAMERA_LOGE("error: V4L2MapBuffer buffer is not mapped\n");
+        return RC_ERROR;
+    }
+
+    // the exported fd lets consumers import the frame, it's -1 if the driver can't export.
+    const MmapPlane& plane = itr->second[buffer->GetIndex()];
+    buffer->SetVirAddress(plane.addr);
+    buffer->SetSize(plane.length);
+    buffer->SetFileDescriptor(plane.dmaFd);
+    return RC_OK;
+}
+
+RetCode HosV4L2Buffers::V4L2ExportBuffer(int fd, unsigned int index, int& dmaFd)
+{
+    std::lock_guard<std::mutex> l(bufferLock_);
+    auto itr = mmapPlanes_.find(fd);
+    if (itr == mmapPlanes_.end() || index >= itr->second.size() || itr->second[index].dmaFd < 0) {
+        CAMERA_LOGE("error: V4L2ExportBuffer buffer %d is not exported\n", index);
+        return RC_ERROR;
+    }
+
+    dmaFd = itr->second[index].dmaFd;
+    return RC_OK;
+}
+
+RetCode HosV4L2Buffers::V4L2ReleaseBuffers(int fd)
+{
+    {
+        std::lock_guard<std::mutex> l(bufferLock_);
+        queueBuffers_.erase(fd);
+        V4L2MunmapBuffers(fd);
+    }
 
     return V4L2ReqBuffers(fd, 0);
 }
@@ -201,4 +374,20 @@ void HosV4L2Buffers::SetCallback(BufCallback cb)
     CAMERA_LOGD("HosV4L2Buffers::SetCallback OK.");
     dequeueBuffer_ = cb;
 }
+
+void HosV4L2Buffers::SetMemoryType(int fd, enum v4l2_memory memType)
+{
+    std::lock_guard<std::mutex> l(bufferLock_);
+    memoryTypes_[fd] = memType;
+}
+
+enum v4l2_memory HosV4L2Buffers::GetMemoryType(int fd)
+{
+    std::lock_guard<std::mutex> l(bufferLock_);
+    auto itr = memoryTypes_.find(fd);
+    if (itr == memoryTypes_.end()) {
+        return memoryType_;
+    }
+    return itr->second;
+}
 } // namespace OHOS::Camera
@@ -14,6 +14,7 @@
  */
 
 #include "v4l2_dev.h"
+#include <algorithm>
 #include <sys/prctl.h>
 
 namespace OHOS::Camera {
@@ -21,8 +22,6 @@ std::map<std::string, std::string> HosV4L2Dev::deviceMatch = HosV4L2Dev::CreateD
 std::map<std::string, int> HosV4L2Dev::fdMatch = HosV4L2Dev::CreateFdMap();
 std::mutex HosV4L2Dev::deviceFdLock_ = {};
 
-static constexpr uint32_t WATING_TIME = 1000 * 100;
-
 HosV4L2Dev::HosV4L2Dev() {}
 HosV4L2Dev::~HosV4L2Dev() {}
 
@@ -115,6 +114,31 @@ RetCode HosV4L2Dev::Init(std::vector<std::string>& cameraIDs)
     return RC_OK;
 }
 
+RetCode HosV4L2Dev::SetMemoryType(const std::string& cameraID, enum v4l2_memory memType)
+{
+    int fd = GetCurrentFd(cameraID);
+    if (fd < 0) {
+        CAMERA_LOGE("error: SetMemoryType: GetCurrentFd error\n");
+        return RC_ERROR;
+    }
+
+    if (memType != V4L2_MEMORY_USERPTR && memType != V4L2_MEMORY_MMAP && memType != V4L2_MEMORY_DMABUF) {
+        CAMERA_LOGE("error: SetMemoryType: memory type %d is not supported\n", memType);
+        return RC_ERROR;
+    }
+
+    if (myBuffers_ == nullptr) {
+        myBuffers_ = std::make_shared<HosV4L2Buffers>(V4L2_MEMORY_USERPTR, V4L2_BUF_TYPE_VIDEO_CAPTURE);
+        if (myBuffers_ == nullptr) {
+            CAMERA_LOGE("error: SetMemoryType: myBuffers_ make_shared is NULL\n");
+            return RC_ERROR;
+        }
+    }
+
+    myBuffers_->SetMemoryType(fd, memType);
+    return RC_OK;
+}
+
 RetCode HosV4L2Dev::ReqBuffers(const std::string& cameraID, unsigned int buffCont)
 {
     int rc, fd;
@@ -142,6 +166,38 @@ RetCode HosV4L2Dev::ReqBuffers(const std::string& cameraID, unsigned int buffCon
     return RC_OK;
 }
 
+RetCode HosV4L2Dev::MapBuffer(const std::string& cameraID, const std::shared_ptr<IBuffer>& buffer)
+{
+    int fd = GetCurrentFd(cameraID);
+    if (fd < 0) {
+        CAMERA_LOGE("error: MapBuffer: GetCurrentFd error\n");
+        return RC_ERROR;
+    }
+
+    if (myBuffers_ == nullptr) {
+        CAMERA_LOGE("error: MapBuffer: myBuffers_ is NULL\n");
+        return RC_ERROR;
+    }
+
+    return myBuffers_->V4L2MapBuffer(fd, buffer);
+}
+
+RetCode HosV4L2Dev::ExportBuffer(const std::string& cameraID, unsigned int index, int& dmaFd)
+{
+    int fd = GetCurrentFd(cameraID);
+    if (fd < 0) {
+        CAMERA_LOGE("error: ExportBuffer: GetCurrentFd error\n");
+        return RC_ERROR;
+    }
+
+    if (myBuffers_ == nullptr) {
+        CAMERA_LOGE("error: ExportBuffer: myBuffers_ is NULL\n");
+        return RC_ERROR;
+    }
+
+    return myBuffers_->V4L2ExportBuffer(fd, index, dmaFd);
+}
+
 RetCode HosV4L2Dev::CreatBuffer(const std::string& cameraID, const std::shared_ptr<FrameSpec>& frameSpec)
 {
     int rc, fd;
@@ -194,6 +250,7 @@ RetCode HosV4L2Dev::QueueBuffer(const std::string& cameraID, const std::shared_p
         CAMERA_LOGE("QueueBuffer: V4L2QueueBuffer error\n");
         return RC_ERROR;
     }
+    ArmEpoll(fd);
 
     return RC_OK;
 }
@@ -226,88 +283,222 @@ RetCode HosV4L2Dev::ReleaseBuffers(const std::string& cameraID)
 void HosV4L2Dev::loopBuffers()
 {
     int nfds, rc;
-    struct epoll_event events[MAXSTREAMCOUNT];
+    struct epoll_event events[MAXSTREAMCOUNT + 1];
 
     CAMERA_LOGD("!!! loopBuffers enter\n");
     prctl(PR_SET_NAME, "v4l2_loopbuffer");
 
-    while (streamNumber_ > 0) {
-        nfds = epoll_wait(epollFd_, events, MAXSTREAMCOUNT, -1);
-        CAMERA_LOGD("loopBuffers: epoll_wait rc = %d streamNumber_ == %d\n", nfds, streamNumber_);
+    while (loopRunning_) {
+        nfds = epoll_wait(epollFd_, events, MAXSTREAMCOUNT + 1, -1);
+        if (nfds < 0) {
+            if (errno != EINTR) {
+                CAMERA_LOGE("loopBuffers: epoll_wait failed: %s\n", strerror(errno));
+            }
+            continue;
+        }
+
+        for (int n = 0; n < nfds; ++n) {
+            int fd = events[n].data.fd;
+            if (fd == eventFd_) {
+                uint64_t value = 0;
+                read(eventFd_, &value, sizeof(value));
+                continue;
+            }
 
-        for (int n = 0; nfds > 0; ++n, --nfds) {
-            if ((events[n].events & EPOLLIN) && (events[n].data.fd != eventFd_)) {
-                if (myBuffers_ == nullptr) {
-                    CAMERA_LOGE("loopBuffers: myBuffers_ is not init\n");
-                    break;
-                }
+            // device fds are oneshot. vb2 reports error while no buffer is queued, the fd is left
+            // disarmed until QueueBuffer arms it again.
+            if (events[n].events & (EPOLLERR | EPOLLHUP)) {
+                CAMERA_LOGD("loopBuffers: fd %d is starved, events = 0x%x\n", fd, events[n].events);
+                continue;
+            }
 
-                rc = myBuffers_->V4L2DqueueBuffer(events[n].data.fd);
+            if ((events[n].events & EPOLLIN) && myBuffers_ != nullptr) {
+                // the fd may be erased by StopStream after the event is reported, don't dequeue it then.
+                std::lock_guard<std::mutex> l(dequeueLock_);
+                if (!IsWatched(fd)) {
+                    continue;
+                }
+                rc = myBuffers_->V4L2DqueueBuffer(fd);
                 if (rc == RC_ERROR) {
                     CAMERA_LOGE("loopBuffers: myBuffers_->V4L2DqueueBuffer return error == %d\n", rc);
-                    continue;
                 }
-            } else {
-                CAMERA_LOGD("loopBuffers: epoll invalid events = 0x%x or eventFd exit = %d\n",
-                    events[n].events, (events[n].data.fd == eventFd_));
-                usleep(WATING_TIME);
             }
+            ArmEpoll(fd);
         }
     }
     CAMERA_LOGD("!!! loopBuffers exit\n");
 }
 
-RetCode HosV4L2Dev::CreateEpoll(int fd, const unsigned int streamNumber)
+void HosV4L2Dev::dispatchBuffers()
 {
-    struct epoll_event epollevent = {};
+    prctl(PR_SET_NAME, "v4l2_dispatch");
+
+    while (true) {
+        std::shared_ptr<FrameSpec> frameSpec = nullptr;
+        {
+            std::unique_lock<std::mutex> l(dispatchLock_);
+            dispatchCv_.wait(l, [this] {
+                return !dispatchQueue_.empty() || !loopRunning_;
+            });
+            // frames dequeued before stop are still handed up, so their buffers go back to pool.
+            if (dispatchQueue_.empty()) {
+                break;
+            }
+            frameSpec = dispatchQueue_.front();
+            dispatchQueue_.pop_front();
+            dispatching_ = true;
+        }
 
-    if (streamNumber == 0) {
-        epollFd_ = epoll_create(MAXSTREAMCOUNT);
-        if (epollFd_ < 0) {
-            CAMERA_LOGE("V4L2 StartStream create_epoll failed\n");
-            return RC_ERROR;
+        if (bufferCb_ != nullptr) {
+            bufferCb_(frameSpec);
         }
-        epollevent.events = EPOLLIN;
-        epollevent.data.fd = fd;
-        epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &epollevent);
-
-        std::lock_guard<std::mutex> l(epollLock_);
-        epollEvent_.push_back(epollevent);
-
-        eventFd_ = eventfd(0, 0);
-        epollevent = {};
-        epollevent.events = EPOLLIN;
-        epollevent.data.fd = eventFd_;
-        epoll_ctl(epollFd_, EPOLL_CTL_ADD, eventFd_, &epollevent);
-    } else {
-        epollevent.events = EPOLLIN;
-        epollevent.data.fd = fd;
+        std::lock_guard<std::mutex> l(dispatchLock_);
+        dispatching_ = false;
+        dispatchCv_.notify_all();
+    }
+    CAMERA_LOGD("!!! dispatchBuffers exit\n");
+}
+
+void HosV4L2Dev::DispatchBuffer(const std::shared_ptr<FrameSpec>& frameSpec)
+{
+    std::lock_guard<std::mutex> l(dispatchLock_);
+    dispatchQueue_.push_back(frameSpec);
+    dispatchCv_.notify_all();
+}
+
+void HosV4L2Dev::WaitDispatched()
+{
+    // a dequeue in progress may still hand up a frame of the stopped fd, wait for it first.
+    {
+        std::lock_guard<std::mutex> l(dequeueLock_);
+    }
+    std::unique_lock<std::mutex> l(dispatchLock_);
+    dispatchCv_.wait(l, [this] {
+        return dispatchQueue_.empty() && !dispatching_;
+    });
+}
+
+RetCode HosV4L2Dev::CreateEpoll()
+{
+    struct epoll_event epollevent = {};
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd_ < 0) {
+        CAMERA_LOGE("V4L2 StartStream create_epoll failed\n");
+        return RC_ERROR;
+    }
+
+    eventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd_ < 0) {
+        CAMERA_LOGE("V4L2 StartStream create eventfd failed\n");
+        close(epollFd_);
+        epollFd_ = -1;
+        return RC_ERROR;
+    }
 
-        std::lock_guard<std::mutex> l(epollLock_);
-        epollEvent_.push_back(epollevent);
+    epollevent.events = EPOLLIN;
+    epollevent.data.fd = eventFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, eventFd_, &epollevent);
+    return RC_OK;
+}
+
+RetCode HosV4L2Dev::AddEpoll(int fd)
+{
+    struct epoll_event epollevent = {};
+    epollevent.events = EPOLLIN | EPOLLONESHOT;
+    epollevent.data.fd = fd;
 
-        epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &epollevent);
+    std::lock_guard<std::mutex> l(epollLock_);
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &epollevent) < 0) {
+        CAMERA_LOGE("V4L2 AddEpoll fd %d failed: %s\n", fd, strerror(errno));
+        return RC_ERROR;
     }
+    epollEvent_.push_back(epollevent);
     return RC_OK;
 }
 
+void HosV4L2Dev::ArmEpoll(int fd)
+{
+    // a reported event disarms the oneshot fd, arm it whether or not it's armed already.
+    std::lock_guard<std::mutex> l(epollLock_);
+    if (epollFd_ < 0) {
+        return;
+    }
+    auto itr = std::find_if(epollEvent_.begin(), epollEvent_.end(), [fd](const epoll_event& event) {
+        return event.data.fd == fd;
+    });
+    if (itr != epollEvent_.end()) {
+        struct epoll_event event = *itr;
+        epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event);
+    }
+}
+
+bool HosV4L2Dev::IsWatched(int fd)
+{
+    std::lock_guard<std::mutex> l(epollLock_);
+    return std::any_of(epollEvent_.begin(), epollEvent_.end(), [fd](const epoll_event& event) {
+        return event.data.fd == fd;
+    });
+}
+
 void HosV4L2Dev::EraseEpoll(int fd)
 {
+    std::lock_guard<std::mutex> l(epollLock_);
     auto itr = std::find_if(epollEvent_.begin(), epollEvent_.end(), [fd](const epoll_event& event) {
-        if (event.data.fd == fd) {
-            return true;
-        } else {
-            return false;
-        }
+        return event.data.fd == fd;
     });
     if (itr != epollEvent_.end()) {
         struct epoll_event event = *itr;
         epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, &event);
-        std::lock_guard<std::mutex> l(epollLock_);
         epollEvent_.erase(itr);
     }
 }
 
+RetCode HosV4L2Dev::StartLoop()
+{
+    if (CreateEpoll() == RC_ERROR) {
+        return RC_ERROR;
+    }
+
+    loopRunning_ = true;
+    dispatchThread_ = new (std::nothrow) std::thread(&HosV4L2Dev::dispatchBuffers, this);
+    streamThread_ = new (std::nothrow) std::thread(&HosV4L2Dev::loopBuffers, this);
+    if (dispatchThread_ == nullptr || streamThread_ == nullptr) {
+        CAMERA_LOGE("V4L2 StartStream start thread failed\n");
+        StopLoop();
+        return RC_ERROR;
+    }
+    return RC_OK;
+}
+
+void HosV4L2Dev::StopLoop()
+{
+    loopRunning_ = false;
+    if (streamThread_ != nullptr) {
+        uint64_t one = 1;
+        write(eventFd_, &one, sizeof(one));
+        streamThread_->join();
+        delete streamThread_;
+        streamThread_ = nullptr;
+    }
+    if (dispatchThread_ != nullptr) {
+        {
+            std::lock_guard<std::mutex> l(dispatchLock_);
+            dispatchCv_.notify_all();
+        }
+        dispatchThread_->join();
+        delete dispatchThread_;
+        dispatchThread_ = nullptr;
+    }
+
+    close(eventFd_);
+    eventFd_ = -1;
+    std::lock_guard<std::mutex> l(epollLock_);
+    close(epollFd_);
+    epollFd_ = -1;
+    epollEvent_.clear();
+}
+
 RetCode HosV4L2Dev::StartStream(const std::string& cameraID)
 {
     int rc, fd;
@@ -332,18 +523,19 @@ RetCode HosV4L2Dev::StartStream(const std::string& cameraID)
         return RC_ERROR;
     }
 
-    rc = CreateEpoll(fd, streamNumber_);
-    if (rc == RC_ERROR) {
-        CAMERA_LOGE("StartStream: CreateEpoll error\n");
+    if (streamNumber_ == 0 && StartLoop() == RC_ERROR) {
+        myStreams_->V4L2StreamOff(fd);
         return RC_ERROR;
     }
 
-    if (streamNumber_ == 0) {
-        streamThread_ = new (std::nothrow) std::thread(&HosV4L2Dev::loopBuffers, this);
-        if (streamThread_ == nullptr) {
-            CAMERA_LOGE("V4L2 StartStream start thread failed\n");
-            return RC_ERROR;
+    rc = AddEpoll(fd);
+    if (rc == RC_ERROR) {
+        CAMERA_LOGE("StartStream: AddEpoll error\n");
+        if (streamNumber_ == 0) {
+            StopLoop();
         }
+        myStreams_->V4L2StreamOff(fd);
+        return RC_ERROR;
     }
 
     streamNumber_++;
@@ -365,21 +557,23 @@ RetCode HosV4L2Dev::StopStream(const std::string& cameraID)
         return RC_ERROR;
     }
 
+    fd = GetCurrentFd(cameraID);
+    if (fd < 0) {
+        CAMERA_LOGE("error: ReqBuffers: GetCurrentFd error\n");
+        return RC_ERROR;
+    }
+
+    // stop watching the fd before stream off, or epoll reports the stopped device as error.
+    EraseEpoll(fd);
+
     streamNumber_ -= 1;
     CAMERA_LOGD("HosV4L2Dev::StopStream streamNumber_ = %d\n", streamNumber_);
 
     if (streamNumber_ == 0) {
         CAMERA_LOGD("waiting loopBuffers stop\n");
-        uint64_t one = 1;
-        write(eventFd_, &one, sizeof(one));
-        streamThread_->join();
-        close(eventFd_);
-    }
-
-    fd = GetCurrentFd(cameraID);
-    if (fd < 0) {
-        CAMERA_LOGE("error: ReqBuffers: GetCurrentFd error\n");
-        return RC_ERROR;
+        StopLoop();
+    } else {
+        WaitDispatched();
     }
 
     rc = myStreams_->V4L2StreamOff(fd);
@@ -388,14 +582,6 @@ RetCode HosV4L2Dev::StopStream(const std::string& cameraID)
         return RC_ERROR;
     }
 
-    EraseEpoll(fd);
-
-    if (streamNumber_ == 0) {
-        close(epollFd_);
-        delete streamThread_;
-        streamThread_ = nullptr;
-    }
-
     return RC_OK;
 }
 
@@ -681,7 +867,10 @@ RetCode HosV4L2Dev::SetCallback(BufCallback cb)
         return RC_ERROR;
     }
 
-    myBuffers_->SetCallback(cb);
+    bufferCb_ = cb;
+    myBuffers_->SetCallback([this](std::shared_ptr<FrameSpec> frameSpec) {
+        DispatchBuffer(frameSpec);
+    });
 
     return RC_OK;
 }
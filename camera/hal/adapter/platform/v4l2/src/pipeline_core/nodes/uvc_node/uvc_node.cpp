@@ -13,6 +13,8 @@
 
 #include "uvc_node.h"
 #include <unistd.h>
+#include "image_buffer.h"
+#include "v4l2_source_node.h"
 
 namespace OHOS::Camera {
 UvcNode::UvcNode(const std::string& name, const std::string& type)
@@ -85,12 +87,14 @@ RetCode UvcNode::Start(const int32_t streamId)
     }
     std::vector<std::shared_ptr<IPort>> outPorts = GetOutPorts();
     for (auto& iter : outPorts) {
+        // buffers mapped by the device are added to the pool once they are requested.
+        enum v4l2_memory memType = GetV4L2MemoryType(iter->format_.memoryType_);
         RetCode ret = bufferPool_->Init(iter->format_.w_,
             iter->format_.h_,
             iter->format_.usage_,
             iter->format_.format_,
             iter->format_.bufferCount_,
-            CAMERA_BUFFER_SOURCE_TYPE_HEAP);
+            memType == V4L2_MEMORY_MMAP ? CAMERA_BUFFER_SOURCE_TYPE_EXTERNAL : CAMERA_BUFFER_SOURCE_TYPE_HEAP);
         if (ret == RC_ERROR) {
             CAMERA_LOGE("bufferpool init failed");
             break;
@@ -102,15 +106,34 @@ RetCode UvcNode::Start(const int32_t streamId)
         format.fmtdesc.width = iter->format_.w_;
         format.fmtdesc.height = iter->format_.h_;
         int bufCnt = iter->format_.bufferCount_;
-        ret = sensorController_->Start(bufCnt, format);
+        ret = sensorController_->Start(bufCnt, format, memType);
         if (ret == RC_ERROR) {
             CAMERA_LOGE("start failed.");
             return RC_ERROR;
         }
+        if (memType == V4L2_MEMORY_MMAP && AddMmapBuffers(iter->format_) == RC_ERROR) {
+            CAMERA_LOGE("add mmap buffers failed.");
+            return RC_ERROR;
+        }
     }
     return SourceNode::Start(streamId);
 }
 
+RetCode UvcNode::AddMmapBuffers(const PortFormat& format)
+{
+    // frames are dequeued into the mapped memory without copy, so the pool index is the v4l2 index.
+    for (uint32_t i = 0; i < format.bufferCount_; i++) {
+        std::shared_ptr<IBuffer> buffer = std::make_shared<ImageBuffer>(CAMERA_BUFFER_SOURCE_TYPE_EXTERNAL,
+            format.w_, format.h_, format.usage_, format.format_);
+        buffer->SetIndex(i);
+        if (sensorController_->MapBuffer(buffer) == RC_ERROR) {
+            return RC_ERROR;
+        }
+        bufferPool_->AddBuffer(buffer);
+    }
+    return RC_OK;
+}
+
 RetCode UvcNode::Stop(const int32_t streamId)
 {
     return SourceNode::Stop(streamId);
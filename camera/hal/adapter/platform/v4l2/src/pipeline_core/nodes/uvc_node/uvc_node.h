@@ -36,6 +36,7 @@ public:
     RetCode ProvideBuffers(std::shared_ptr<FrameSpec> frameSpec) override;
 protected:
     RetCode StartCheck(int64_t &bufferPoolId);
+    RetCode AddMmapBuffers(const PortFormat& format);
 private:
     std::shared_ptr<SensorController>       sensorController_ = nullptr;
     std::shared_ptr<IBufferPool>            bufferPool_ = nullptr;
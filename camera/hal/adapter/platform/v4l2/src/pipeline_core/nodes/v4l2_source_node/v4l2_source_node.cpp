@@ -15,6 +15,18 @@
 #include <unistd.h>
 
 namespace OHOS::Camera {
+enum v4l2_memory GetV4L2MemoryType(int32_t memoryType)
+{
+    switch (memoryType) {
+        case MEMORY_TYPE_MMAP:
+            return V4L2_MEMORY_MMAP;
+        case MEMORY_TYPE_DMABUF:
+            return V4L2_MEMORY_DMABUF;
+        default:
+            return V4L2_MEMORY_USERPTR;
+    }
+}
+
 V4L2SourceNode::V4L2SourceNode(const std::string& name, const std::string& type)
     : SourceNode(name, type), NodeBase(name, type)
 {
@@ -58,7 +70,7 @@ RetCode V4L2SourceNode::Start(const int32_t streamId)
         format.fmtdesc.width = it->format_.w_;
         format.fmtdesc.height = it->format_.h_;
         int bufCnt = it->format_.bufferCount_;
-        rc = sensorController_->Start(bufCnt, format);
+        rc = sensorController_->Start(bufCnt, format, GetV4L2MemoryType(it->format_.memoryType_));
         if (rc == RC_ERROR) {
             CAMERA_LOGE("start failed.");
             return RC_ERROR;
@@ -23,6 +23,9 @@
 #include "sensor_manager.h"
 
 namespace OHOS::Camera {
+// v4l2 memory of the memory type of a stream, for the v4l2 source nodes.
+enum v4l2_memory GetV4L2MemoryType(int32_t memoryType);
+
 class V4L2SourceNode : public SourceNode {
 public:
     V4L2SourceNode(const std::string& name, const std::string& type);
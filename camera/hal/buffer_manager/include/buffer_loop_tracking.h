@@ -18,80 +18,115 @@
 
 #include "buffer_trace.h"
 #include "camera.h"
+#include <array>
 #include <atomic>
-#include <condition_variable>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <string>
-#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <algorithm>
 
 namespace OHOS::Camera {
+// fixed buckets with 8 sub-buckets per power of two, up to 2^36 us. Recording is lock free.
+class LatencyHistogram {
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 3;
+    static constexpr uint32_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr uint32_t MAX_MSB = 35;
+    static constexpr uint32_t BUCKET_COUNT = (MAX_MSB - SUB_BUCKET_BITS + 2) * SUB_BUCKET_COUNT;
+    using Buckets = std::array<uint64_t, BUCKET_COUNT>;
+
+    void Record(const uint64_t us);
+    LatencyStatistics GetStatistics() const;
+
+private:
+    static uint32_t BucketIndex(const uint64_t us);
+    static uint64_t BucketUpperBound(const uint32_t index);
+    static uint64_t Percentile(const Buckets& buckets, const uint64_t count, const uint64_t max,
+        const uint32_t percent);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_ = {};
+    std::atomic<uint64_t> max_ = 0;
+};
+
 class TrackingNode {
 public:
     explicit TrackingNode(std::string name);
-    ~TrackingNode();
+    ~TrackingNode() = default;
 
     std::string GetNodeName() const;
-    std::shared_ptr<TrackingBuffer> FindTrackingBuffer(const std::shared_ptr<TrackingBuffer>& buffer);
-    void AttachTrackingBuffer(const std::shared_ptr<TrackingBuffer>& buffer);
-    void DetachTrackingBuffer(const std::shared_ptr<TrackingBuffer>& buffer);
-    bool IsEmpty();
-    std::list<std::shared_ptr<TrackingBuffer>> GetTrackingBuffer() const
+    LatencyHistogram& GetLatency()
     {
-        return trackingBufferList_;
-    }
-
-    bool operator==(const TrackingNode& n)
-    {
-        return this->nodeName_ == n.nodeName_;
+        return latency_;
     }
 
 private:
-    std::mutex lock_;
     std::string nodeName_ = "";
-    std::list<std::shared_ptr<TrackingBuffer>> trackingBufferList_ = {};
+    // residency of buffers in this node.
+    LatencyHistogram latency_;
 
 private:
     TrackingNode() = default;
 };
 
+// Nodes of a stream are fixed once it's complete. Where a frame is lives in a ring indexed by
+// frameNumber modulo its capacity, reporting threads update it with atomics, no lock and no search.
 class TrackingStream {
 public:
+    static constexpr uint32_t RING_SIZE = 256;
+    static constexpr uint64_t RING_MASK = RING_SIZE - 1;
+    static_assert((RING_SIZE & RING_MASK) == 0, "size of the ring should be power of 2");
+
     explicit TrackingStream(const int32_t id);
-    ~TrackingStream();
+    ~TrackingStream() = default;
 
     int32_t GetTrackingStreamId() const;
-    void AttachTrackingNode(const std::shared_ptr<TrackingNode>& node);
-    void DetachTrackingNode(const std::shared_ptr<TrackingNode>& node);
-    void MoveBuffer(std::shared_ptr<TrackingBuffer>& buffer, std::shared_ptr<TrackingNode>& node);
-    void RemoveBuffer(std::shared_ptr<TrackingBuffer>& buffer);
+    void AttachTrackingNode(const std::string& node);
+    void MoveBuffer(const uint64_t frameNumber, const std::string& node, const uint64_t timestamp);
+    void RemoveBuffer(const uint64_t frameNumber, const uint64_t timestamp);
+    int32_t IsEmpty(const std::string& node);
+    int32_t IsEmpty(const std::string& beginNode, const std::string& endNode);
     void DumpTrace(BufferTraceGraph& graph);
+    void GetLatency(BufferLatency& latency);
     bool operator==(const TrackingStream& n)
     {
         return this->trackingId_ == n.trackingId_;
     }
-    std::shared_ptr<TrackingNode> FindTrackingNode(const std::string node);
-    std::shared_ptr<TrackingNode> LocateBuffer(const std::shared_ptr<TrackingBuffer>& buffer);
-    std::list<std::shared_ptr<TrackingNode>> FindTrackingNodePath(const std::string beginNode,
-                                                                  const std::string endNode);
     void NodeAddComplete()
     {
+        std::lock_guard<std::mutex> l(lock_);
         addNodeComplete_ = true;
     }
 
     bool IsNodeComplete() const
     {
-        return addNodeComplete_;
+        return addNodeComplete_.load();
     }
 
+private:
+    struct FrameSlot {
+        // frameNumber + 1 of the frame in the slot, 0 if it's free.
+        std::atomic<uint64_t> tag = 0;
+        std::atomic<int32_t> node = -1;
+        std::atomic<uint64_t> enterTime = 0;
+        std::atomic<uint64_t> beginTime = 0;
+    };
+
+    int32_t FindNodeIndex(const std::string& node) const;
+    bool IsNodeIndexEmpty(const int32_t index) const;
+
 private:
     int32_t trackingId_ = -1;
-    bool addNodeComplete_ = false;
-    std::list<std::shared_ptr<TrackingNode>> trackingNodeList_ = {};
+    std::atomic<bool> addNodeComplete_ = false;
     std::mutex lock_;
-    std::mutex traceLock_;
+    // only changed before the stream is complete, read without lock after.
+    std::vector<std::shared_ptr<TrackingNode>> trackingNodes_ = {};
+    std::unordered_map<std::string, int32_t> nodeIndex_ = {};
+    std::vector<FrameSlot> ring_;
+    LatencyHistogram endToEndLatency_;
 
 private:
     TrackingStream() = default;
@@ -105,11 +140,16 @@ public:
     void DeleteTrackingStream(const int32_t trackingId);
     void AddTrackingNode(const int32_t trackingId, const std::string node);
     void SendBufferMovementMessage(const std::shared_ptr<BufferTrackingMessage>& message);
+    void ReportBufferLocation(const int32_t trackingId, const uint64_t frameNumber, const std::string& node,
+        const bool isReturnBack, const uint64_t timestamp);
     void StartTracking();
     void StopTracking();
     int32_t IsEmpty(const int32_t id, const std::string node);
     int32_t IsEmpty(const int32_t id, const std::string beginNode, const std::string endNode);
     void DumpTrace(const int32_t trackingId, BufferTraceGraph& graph);
+    bool IsTracking() const;
+    RetCode GetLatency(const int32_t trackingId, BufferLatency& latency);
+    RetCode DumpLatency(const int32_t trackingId, const std::string& path);
 
 private:
     BufferLoopTracking() = default;
@@ -120,18 +160,12 @@ private:
     ~BufferLoopTracking();
 
     std::shared_ptr<TrackingStream> FindTrackingStream(const int32_t id);
-    std::shared_ptr<BufferTrackingMessage> ReceiveMessage();
-    void HandleMessage();
 
 private:
     std::mutex lock_;
-    std::mutex messageLock_;
-    std::condition_variable cv_;
     std::atomic<bool> running_ = false;
 
-    std::unique_ptr<std::thread> handler_ = nullptr;
     std::list<std::shared_ptr<TrackingStream>> trackingStreamList_ = {};
-    std::list<std::shared_ptr<BufferTrackingMessage>> messageQueue_ = {};
 };
 } // namespace OHOS::Camera
 #endif
@@ -19,14 +19,18 @@
 #include "buffer_allocator_factory.h"
 #include "ibuffer.h"
 #include "ibuffer_pool.h"
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
-#include <list>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace OHOS::Camera {
-class BufferPool : public IBufferPool {
+// buffers of the pool refer to it weakly, so the pool must be owned by a shared_ptr.
+class BufferPool : public IBufferPool, public std::enable_shared_from_this<BufferPool> {
 public:
     BufferPool();
     virtual ~BufferPool();
@@ -39,17 +43,51 @@ public:
                          const int32_t bufferSourceType) override;
     virtual RetCode AddBuffer(std::shared_ptr<IBuffer>& buffer) override;
     virtual std::shared_ptr<IBuffer> AcquireBuffer(int timeout) override;
+    virtual std::shared_ptr<IBuffer> AcquireBuffer(const std::chrono::microseconds& timeout) override;
     virtual RetCode ReturnBuffer(std::shared_ptr<IBuffer>& buffer) override;
+    virtual std::shared_ptr<IBuffer> ShareBuffer(const std::shared_ptr<IBuffer>& buffer) override;
     virtual void EnableTracking(const int32_t id) override;
     virtual void SetId(const int64_t id) override;
     virtual void NotifyStop() override;
     virtual void NotifyStart() override;
     virtual void ClearBuffers() override;
     virtual uint32_t GetIdleBufferCount() override;
+    virtual RetCode SetElasticPolicy(const uint32_t maxCount, const uint32_t lowWatermark) override;
+    virtual void TrimBuffers() override;
+    virtual BufferPoolStatistics GetStatistics() override;
+    virtual void SetIdleCallback(const std::function<void()>& callback) override;
 
 private:
+    enum SlotState : uint8_t {
+        SLOT_VACANT = 0, // buffer of this slot is trimmed, or external buffer is out of pool
+        SLOT_IDLE,
+        SLOT_BUSY,
+    };
+
+    // every buffer of pool owns a fixed slot, idle slots are linked by next into a fifo free-list,
+    // trimmed slots are linked into a vacant list for reuse.
+    struct BufferSlot {
+        std::shared_ptr<IBuffer> buffer = nullptr;
+        int32_t next = -1;
+        SlotState state = SLOT_VACANT;
+        bool ownerOut = false; // buffer itself is not returned yet
+        uint32_t holders = 0;  // buffer and its views which are not returned yet
+    };
+
     RetCode PrepareBuffer();
     RetCode DestroyBuffer();
+    int32_t FindSlot(const std::shared_ptr<IBuffer>& buffer) const;
+    int32_t NewSlot(const std::shared_ptr<IBuffer>& buffer);
+    int32_t PlaceBuffer(const std::shared_ptr<IBuffer>& buffer);
+    void PushIdleSlot(const int32_t slot);
+    int32_t UnlinkIdleSlot();
+    std::shared_ptr<IBuffer> PopIdleSlot();
+    void MarkBusy(const int32_t slot);
+    void ReleaseSlot(const int32_t slot);
+    void DropView(const IBuffer* view);
+    bool CanGrow() const;
+    std::shared_ptr<IBuffer> GrowBuffer();
+    std::shared_ptr<IBuffer> AllocateBuffer();
 
 private:
     std::mutex lock_;
@@ -64,8 +102,22 @@ private:
     uint32_t bufferFormat_ = CAMERA_FORMAT_INVALID;
     int32_t bufferSourceType_ = CAMERA_BUFFER_SOURCE_TYPE_NONE;
     std::shared_ptr<IBufferAllocator> bufferAllocator_ = nullptr;
-    std::list<std::shared_ptr<IBuffer>> idleList_ = {};
-    std::list<std::shared_ptr<IBuffer>> busyList_ = {};
+    std::vector<BufferSlot> slots_ = {};
+    // buffers whose index doesn't match their slot, e.g. external buffers and shared views.
+    std::unordered_map<const IBuffer*, int32_t> slotMap_ = {};
+    int32_t idleHead_ = -1;
+    int32_t idleTail_ = -1;
+    int32_t vacantHead_ = -1;
+    uint32_t idleCount_ = 0;
+    uint32_t busyCount_ = 0;
+    bool elastic_ = false;
+    uint32_t maxCount_ = 0;
+    uint32_t lowWatermark_ = 0;
+    uint32_t allocatedCount_ = 0;
+    uint32_t peakInUseCount_ = 0;
+    uint32_t windowPeakCount_ = 0;
+    uint32_t trimmedCount_ = 0;
+    std::function<void()> idleCallback_ = nullptr;
 };
 } // namespace OHOS::Camera
 #endif
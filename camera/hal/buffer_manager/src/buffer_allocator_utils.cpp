@@ -14,9 +14,21 @@
  */
 
 #include "buffer_allocator_utils.h"
+#include <atomic>
+#include <mutex>
 #include "buffer_allocator_factory.h"
 
 namespace OHOS::Camera {
+namespace {
+    // allocators resolved from the factory and initialized, by source type.
+    struct CachedAllocator {
+        std::mutex lock;
+        std::atomic<bool> ready = false;
+        std::shared_ptr<IBufferAllocator> allocator = nullptr;
+    };
+    CachedAllocator g_cachedAllocators[CAMERA_BUFFER_SOURCE_TYPE_MAX];
+}
+
 std::shared_ptr<IBufferAllocator> BufferAllocatorUtils::GetBufferAllocator(const int32_t source)
 {
     if (source == CAMERA_BUFFER_SOURCE_TYPE_NONE) {
@@ -27,6 +39,22 @@ std::shared_ptr<IBufferAllocator> BufferAllocatorUtils::GetBufferAllocator(const
         return nullptr;
     }
 
+    if (source < 0 || source >= CAMERA_BUFFER_SOURCE_TYPE_MAX) {
+        CAMERA_LOGE("unknown buffer source %{public}d", source);
+        return nullptr;
+    }
+
+    // allocator is written once before ready is set, no lock is needed after.
+    CachedAllocator& cached = g_cachedAllocators[source];
+    if (cached.ready.load(std::memory_order_acquire)) {
+        return cached.allocator;
+    }
+
+    std::lock_guard<std::mutex> l(cached.lock);
+    if (cached.ready.load(std::memory_order_relaxed)) {
+        return cached.allocator;
+    }
+
     auto factory = BufferAllocatorFactory::GetInstance();
     if (factory == nullptr) {
         CAMERA_LOGE("can't get factory, alloc failed.");
@@ -39,10 +67,13 @@ std::shared_ptr<IBufferAllocator> BufferAllocatorUtils::GetBufferAllocator(const
         return nullptr;
     }
 
+    // a failed Init is tried again on the next call.
     if (allocator->Init() != RC_OK) {
         return nullptr;
     }
 
+    cached.allocator = allocator;
+    cached.ready.store(true, std::memory_order_release);
     return allocator;
 }
 
@@ -69,6 +100,34 @@ std::shared_ptr<IBuffer> BufferAllocatorUtils::AllocBuffer(const int32_t source,
     return allocator->AllocBuffer(width, height, usage, format);
 }
 
+RetCode BufferAllocatorUtils::AllocBuffers(const int32_t source,
+                                           const uint32_t count,
+                                           const uint32_t width,
+                                           const uint32_t height,
+                                           const uint64_t usage,
+                                           const uint32_t format,
+                                           std::vector<std::shared_ptr<IBuffer>>& buffers)
+{
+    auto allocator = GetBufferAllocator(source);
+    CHECK_IF_PTR_NULL_RETURN_VALUE(allocator, RC_ERROR);
+
+    std::vector<std::shared_ptr<IBuffer>> allocated;
+    allocated.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        std::shared_ptr<IBuffer> buffer = allocator->AllocBuffer(width, height, usage, format);
+        if (buffer == nullptr) {
+            CAMERA_LOGE("alloc buffer %{public}u of %{public}u failed", i, count);
+            for (auto& it : allocated) {
+                allocator->FreeBuffer(it);
+            }
+            return RC_ERROR;
+        }
+        allocated.emplace_back(buffer);
+    }
+    buffers.insert(buffers.end(), allocated.begin(), allocated.end());
+    return RC_OK;
+}
+
 RetCode BufferAllocatorUtils::FreeBuffer(std::shared_ptr<IBuffer>& buffer)
 {
     auto allocator = GetAllocator(buffer);
@@ -76,6 +135,17 @@ RetCode BufferAllocatorUtils::FreeBuffer(std::shared_ptr<IBuffer>& buffer)
     return allocator->FreeBuffer(buffer);
 }
 
+RetCode BufferAllocatorUtils::FreeBuffers(std::vector<std::shared_ptr<IBuffer>>& buffers)
+{
+    RetCode rc = RC_OK;
+    for (auto& it : buffers) {
+        if (FreeBuffer(it) != RC_OK) {
+            rc = RC_ERROR;
+        }
+    }
+    return rc;
+}
+
 RetCode BufferAllocatorUtils::MapBuffer(std::shared_ptr<IBuffer>& buffer)
 {
     auto allocator = GetAllocator(buffer);
@@ -14,88 +14,94 @@
  */
 
 #include "buffer_loop_tracking.h"
+#include <fstream>
 #include "buffer_manager.h"
 
 namespace OHOS::Camera {
-TrackingNode::TrackingNode(std::string name)
-{
-    nodeName_ = name;
+namespace {
+    constexpr uint32_t PERCENT_50 = 50;
+    constexpr uint32_t PERCENT_90 = 90;
+    constexpr uint32_t PERCENT_99 = 99;
+    constexpr uint32_t PERCENT_ALL = 100;
 }
 
-TrackingNode::~TrackingNode()
+uint32_t LatencyHistogram::BucketIndex(const uint64_t us)
 {
-    {
-        std::lock_guard<std::mutex> l(lock_);
-        trackingBufferList_.clear();
+    if (us < SUB_BUCKET_COUNT) {
+        return static_cast<uint32_t>(us);
+    }
+    uint32_t msb = 63 - __builtin_clzll(us); // 63: highest bit of uint64_t
+    if (msb > MAX_MSB) {
+        return BUCKET_COUNT - 1;
     }
+    uint32_t sub = static_cast<uint32_t>(us >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1);
+    return (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT + sub;
 }
 
-std::string TrackingNode::GetNodeName() const
+uint64_t LatencyHistogram::BucketUpperBound(const uint32_t index)
 {
-    return nodeName_;
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    uint32_t shift = index / SUB_BUCKET_COUNT - 1;
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT) << shift;
+    return lower + (1ULL << shift) - 1;
 }
 
-std::shared_ptr<TrackingBuffer> TrackingNode::FindTrackingBuffer(const std::shared_ptr<TrackingBuffer>& buffer)
+void LatencyHistogram::Record(const uint64_t us)
 {
-    if (buffer == nullptr) {
-        return nullptr;
-    }
-
-    std::lock_guard<std::mutex> l(lock_);
-    auto it = std::find_if(trackingBufferList_.begin(), trackingBufferList_.end(),
-        [&buffer](const std::shared_ptr<TrackingBuffer>& b) {
-            return b->GetFrameNumber() == buffer->GetFrameNumber();
-        });
-    if (it == trackingBufferList_.end()) {
-        return nullptr;
+    buckets_[BucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (us > max && !max_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
     }
-    return *it;
 }
 
-void TrackingNode::AttachTrackingBuffer(const std::shared_ptr<TrackingBuffer>& buffer)
+uint64_t LatencyHistogram::Percentile(const Buckets& buckets, const uint64_t count, const uint64_t max,
+    const uint32_t percent)
 {
-    {
-        std::lock_guard<std::mutex> l(lock_);
-        trackingBufferList_.emplace_back(buffer);
+    uint64_t rank = (count * percent + PERCENT_ALL - 1) / PERCENT_ALL;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen >= rank && seen > 0) {
+            // the last bucket is open-ended
+            return i == BUCKET_COUNT - 1 ? max : std::min(BucketUpperBound(i), max);
+        }
     }
-
-    return;
+    return max;
 }
 
-void TrackingNode::DetachTrackingBuffer(const std::shared_ptr<TrackingBuffer>& buffer)
+LatencyStatistics LatencyHistogram::GetStatistics() const
 {
-    {
-        std::lock_guard<std::mutex> l(lock_);
-        auto it = std::find_if(trackingBufferList_.begin(), trackingBufferList_.end(),
-            [&buffer](const std::shared_ptr<TrackingBuffer>& b) {
-                return b->GetFrameNumber() == buffer->GetFrameNumber();
-            });
-        if (it != trackingBufferList_.end()) {
-            trackingBufferList_.erase(it);
-        }
+    // a snapshot, samples recorded meanwhile may be partly counted.
+    Buckets buckets = {};
+    LatencyStatistics statistics = {};
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        statistics.count += buckets[i];
     }
-
-    return;
+    statistics.max = max_.load(std::memory_order_relaxed);
+    if (statistics.count > 0) {
+        statistics.p50 = Percentile(buckets, statistics.count, statistics.max, PERCENT_50);
+        statistics.p90 = Percentile(buckets, statistics.count, statistics.max, PERCENT_90);
+        statistics.p99 = Percentile(buckets, statistics.count, statistics.max, PERCENT_99);
+    }
+    return statistics;
 }
 
-bool TrackingNode::IsEmpty()
+TrackingNode::TrackingNode(std::string name)
 {
-    std::lock_guard<std::mutex> l(lock_);
-    return trackingBufferList_.empty();
+    nodeName_ = name;
 }
 
-TrackingStream::TrackingStream(const int32_t id)
+std::string TrackingNode::GetNodeName() const
 {
-    trackingId_ = id;
+    return nodeName_;
 }
 
-TrackingStream::~TrackingStream()
+TrackingStream::TrackingStream(const int32_t id) : ring_(RING_SIZE)
 {
-    {
-        std::lock_guard<std::mutex> l(lock_);
-        trackingNodeList_.clear();
-        CAMERA_LOGD("dtor TrackingStream %{public}p", this);
-    }
+    trackingId_ = id;
 }
 
 int32_t TrackingStream::GetTrackingStreamId() const
@@ -103,154 +109,153 @@ int32_t TrackingStream::GetTrackingStreamId() const
     return trackingId_;
 }
 
-std::shared_ptr<TrackingNode> TrackingStream::FindTrackingNode(const std::string node)
+void TrackingStream::AttachTrackingNode(const std::string& node)
 {
     std::lock_guard<std::mutex> l(lock_);
-    auto it = std::find_if(trackingNodeList_.begin(), trackingNodeList_.end(),
-                           [&node](const std::shared_ptr<TrackingNode>& n) { return n->GetNodeName() == node; });
-    if (it != trackingNodeList_.end()) {
-        return *it;
+    if (addNodeComplete_.load()) {
+        CAMERA_LOGE("stream %{public}d is complete, can't add node %{public}s", trackingId_, node.c_str());
+        return;
+    }
+    if (nodeIndex_.count(node) != 0) {
+        return;
     }
+    nodeIndex_[node] = static_cast<int32_t>(trackingNodes_.size());
+    trackingNodes_.emplace_back(std::make_shared<TrackingNode>(node));
 
-    return nullptr;
+    return;
+}
+
+int32_t TrackingStream::FindNodeIndex(const std::string& node) const
+{
+    auto it = nodeIndex_.find(node);
+    if (it == nodeIndex_.end()) {
+        return -1;
+    }
+    return it->second;
 }
 
-void TrackingStream::AttachTrackingNode(const std::shared_ptr<TrackingNode>& node)
+void TrackingStream::MoveBuffer(const uint64_t frameNumber, const std::string& node, const uint64_t timestamp)
 {
-    if (FindTrackingNode(node->GetNodeName()) != nullptr) {
+    int32_t index = FindNodeIndex(node);
+    if (index < 0) {
+        CAMERA_LOGE("node %{public}s doesn't being tracked", node.c_str());
         return;
     }
 
-    {
-        std::lock_guard<std::mutex> l(lock_);
-        trackingNodeList_.emplace_back(node);
+    // a buffer is reported by one node after another, so a slot is never updated concurrently, unless
+    // more than RING_SIZE frames are in flight.
+    FrameSlot& slot = ring_[frameNumber & RING_MASK];
+    if (slot.tag.load(std::memory_order_acquire) != frameNumber + 1) {
+        slot.enterTime.store(timestamp, std::memory_order_relaxed);
+        slot.beginTime.store(timestamp, std::memory_order_relaxed);
+        slot.node.store(index, std::memory_order_relaxed);
+        slot.tag.store(frameNumber + 1, std::memory_order_release);
+        return;
+    }
+
+    int32_t from = slot.node.exchange(index, std::memory_order_acq_rel);
+    uint64_t enterTime = slot.enterTime.exchange(timestamp, std::memory_order_acq_rel);
+    if (from >= 0 && timestamp >= enterTime) {
+        trackingNodes_[from]->GetLatency().Record(timestamp - enterTime);
     }
 
     return;
 }
 
-void TrackingStream::DetachTrackingNode(const std::shared_ptr<TrackingNode>& node)
+void TrackingStream::RemoveBuffer(const uint64_t frameNumber, const uint64_t timestamp)
 {
-    auto n = FindTrackingNode(node->GetNodeName());
-    if (n == nullptr) {
+    FrameSlot& slot = ring_[frameNumber & RING_MASK];
+    if (slot.tag.load(std::memory_order_acquire) != frameNumber + 1) {
         return;
     }
 
-    {
-        std::lock_guard<std::mutex> l(lock_);
-        auto it = std::find(trackingNodeList_.begin(), trackingNodeList_.end(), node);
-        if (it != trackingNodeList_.end()) {
-            trackingNodeList_.erase(it);
-        }
+    int32_t from = slot.node.exchange(-1, std::memory_order_acq_rel);
+    uint64_t enterTime = slot.enterTime.load(std::memory_order_relaxed);
+    uint64_t beginTime = slot.beginTime.load(std::memory_order_relaxed);
+    slot.tag.store(0, std::memory_order_release);
+    if (from >= 0 && timestamp >= enterTime && enterTime >= beginTime) {
+        trackingNodes_[from]->GetLatency().Record(timestamp - enterTime);
+        endToEndLatency_.Record(timestamp - beginTime);
     }
 
     return;
 }
 
-std::shared_ptr<TrackingNode> TrackingStream::LocateBuffer(const std::shared_ptr<TrackingBuffer>& buffer)
+bool TrackingStream::IsNodeIndexEmpty(const int32_t index) const
 {
-    {
-        std::lock_guard<std::mutex> l(lock_);
-        for (auto& n : trackingNodeList_) {
-            if (n == nullptr) {
-                CAMERA_LOGE("fatal error, tracking node list is corrupt.");
-                return nullptr;
-            }
-            if (n->IsEmpty()) {
-                continue;
-            }
-            if (n->FindTrackingBuffer(buffer) != nullptr) {
-                return n;
-            }
+    for (const auto& slot : ring_) {
+        if (slot.tag.load(std::memory_order_acquire) != 0 && slot.node.load(std::memory_order_relaxed) == index) {
+            return false;
         }
-        return nullptr;
     }
+    return true;
 }
 
-void TrackingStream::MoveBuffer(std::shared_ptr<TrackingBuffer>& buffer, std::shared_ptr<TrackingNode>& node)
+int32_t TrackingStream::IsEmpty(const std::string& node)
 {
-    if (node == nullptr) {
-        CAMERA_LOGE("node is null, cannot track");
-        return;
-    }
-    auto dest = FindTrackingNode(node->GetNodeName());
-    if (dest == nullptr) {
-        CAMERA_LOGE("node %{public}s doesn't being tracked", dest->GetNodeName().c_str());
-        return;
-    }
-
-    {
-        std::lock_guard<std::mutex> tl(traceLock_);
-        auto src = LocateBuffer(buffer);
-        if (src != nullptr) {
-            src->DetachTrackingBuffer(buffer);
-        }
-
-        dest->AttachTrackingBuffer(buffer);
+    int32_t index = FindNodeIndex(node);
+    if (index < 0) {
+        CAMERA_LOGI("node %{public}s doesn't being tracked", node.c_str());
+        return INVALID_TRACKING_ID;
     }
-    return;
+    return IsNodeIndexEmpty(index) ? NODE_IS_EMPTY : NODE_IS_NOT_EMPTY;
 }
 
-void TrackingStream::RemoveBuffer(std::shared_ptr<TrackingBuffer>& buffer)
+int32_t TrackingStream::IsEmpty(const std::string& beginNode, const std::string& endNode)
 {
-    std::lock_guard<std::mutex> tl(traceLock_);
-    auto src = LocateBuffer(buffer);
-    if (src != nullptr) {
-        src->DetachTrackingBuffer(buffer);
+    int32_t begin = FindNodeIndex(beginNode);
+    int32_t end = FindNodeIndex(endNode);
+    if (begin < 0 || end < 0) {
+        CAMERA_LOGI("node %{public}s or %{public}s doesn't being tracked", beginNode.c_str(), endNode.c_str());
+        return INVALID_TRACKING_ID;
     }
-
-    return;
+    if (begin > end) {
+        std::swap(begin, end);
+    }
+    for (const auto& slot : ring_) {
+        int32_t node = slot.node.load(std::memory_order_relaxed);
+        if (slot.tag.load(std::memory_order_acquire) != 0 && node >= begin && node <= end) {
+            return NODE_IS_NOT_EMPTY;
+        }
+    }
+    return NODE_IS_EMPTY;
 }
 
 void TrackingStream::DumpTrace(BufferTraceGraph& graph)
 {
     graph.clear();
-    std::lock_guard<std::mutex> tl(traceLock_);
-    std::lock_guard<std::mutex> l(lock_);
-    for (auto& n : trackingNodeList_) {
-        if (n == nullptr) {
-            graph.clear();
-            return;
-        }
-        std::list<TrackingBuffer> buffers = {};
-        auto bufferList = n->GetTrackingBuffer();
-        for (auto& b : bufferList) {
-            if (b == nullptr) {
-                graph.clear();
-                return;
-            }
-            buffers.emplace_back(*b);
+    std::vector<std::list<TrackingBuffer>> buffers(trackingNodes_.size());
+    for (const auto& slot : ring_) {
+        uint64_t tag = slot.tag.load(std::memory_order_acquire);
+        int32_t node = slot.node.load(std::memory_order_relaxed);
+        if (tag == 0 || node < 0 || node >= static_cast<int32_t>(buffers.size())) {
+            continue;
         }
-        graph.emplace_back(std::make_pair(n->GetNodeName(), buffers));
+        TrackingBuffer buffer(tag - 1);
+        buffer.SetTimestamp(slot.enterTime.load(std::memory_order_relaxed),
+            slot.beginTime.load(std::memory_order_relaxed));
+        buffers[node].emplace_back(buffer);
+    }
+    for (uint32_t i = 0; i < trackingNodes_.size(); i++) {
+        buffers[i].sort([](const TrackingBuffer& a, const TrackingBuffer& b) {
+            return a.GetFrameNumber() < b.GetFrameNumber();
+        });
+        graph.emplace_back(std::make_pair(trackingNodes_[i]->GetNodeName(), buffers[i]));
     }
 
     return;
 }
 
-std::list<std::shared_ptr<TrackingNode>> TrackingStream::FindTrackingNodePath(const std::string beginNode,
-                                                                              const std::string endNode)
+void TrackingStream::GetLatency(BufferLatency& latency)
 {
-    std::lock_guard<std::mutex> l(lock_);
-    std::list<std::shared_ptr<TrackingNode>> nodePath = {};
-    bool isInPath = false;
-    for (auto& n : trackingNodeList_) {
-        if (n == nullptr) {
-            return {};
-        }
-        if (n->GetNodeName() == beginNode || n->GetNodeName() == endNode) {
-            if (nodePath.empty()) {
-                isInPath = true;
-            } else {
-                isInPath = false;
-            }
-            nodePath.emplace_back(n);
-            continue;
-        }
-        if (isInPath) {
-            nodePath.emplace_back(n);
+    latency.nodes.clear();
+    for (auto& it : trackingNodes_) {
+        LatencyStatistics statistics = it->GetLatency().GetStatistics();
+        if (statistics.count > 0) {
+            latency.nodes[it->GetNodeName()] = statistics;
         }
     }
-    return nodePath;
+    latency.endToEnd = endToEndLatency_.GetStatistics();
 }
 
 BufferLoopTracking& BufferLoopTracking::GetInstance()
@@ -264,7 +269,6 @@ BufferLoopTracking::~BufferLoopTracking()
     {
         std::lock_guard<std::mutex> l(lock_);
         trackingStreamList_.clear();
-        handler_ = nullptr;
     }
 }
 
@@ -346,87 +350,52 @@ void BufferLoopTracking::AddTrackingNode(const int32_t trackingId, const std::st
         CAMERA_LOGI("can't add node %{public}s to stream %{public}d", node.c_str(), trackingId);
         return;
     }
-    auto n = std::make_shared<TrackingNode>(node);
-    return stream->AttachTrackingNode(n);
-}
-
-std::shared_ptr<BufferTrackingMessage> BufferLoopTracking::ReceiveMessage()
-{
-    if (messageQueue_.empty()) {
-        std::unique_lock<std::mutex> l(messageLock_);
-        if (messageQueue_.empty()) {
-            cv_.wait(l, [this] { return !(running_.load() && messageQueue_.empty()); });
-        }
-    }
-
-    if (!running_.load()) {
-        return nullptr;
-    }
-
-    std::shared_ptr<BufferTrackingMessage> message = nullptr;
-    if (!messageQueue_.empty()) {
-        std::unique_lock<std::mutex> l(messageLock_);
-        if (!messageQueue_.empty()) {
-            message = messageQueue_.front();
-            messageQueue_.pop_front();
-            return message;
-        }
-    }
-
-    return message;
+    return stream->AttachTrackingNode(node);
 }
 
 void BufferLoopTracking::SendBufferMovementMessage(const std::shared_ptr<BufferTrackingMessage>& message)
 {
-    std::unique_lock<std::mutex> l(messageLock_);
-    messageQueue_.emplace_back(message);
-    cv_.notify_one();
+    if (message == nullptr) {
+        return;
+    }
+    ReportBufferLocation(message->trackingId, message->frameNumber, message->nodeName, message->isReturnBack,
+        message->timestamp);
 
     return;
 }
 
-void BufferLoopTracking::HandleMessage()
+void BufferLoopTracking::ReportBufferLocation(const int32_t trackingId, const uint64_t frameNumber,
+    const std::string& node, const bool isReturnBack, const uint64_t timestamp)
 {
-    auto message = ReceiveMessage();
-    if (message == nullptr) {
+    if (!running_.load()) {
         return;
     }
 
-    auto stream = FindTrackingStream(message->trackingId);
+    // handled right on the reporting thread, the cost doesn't depend on frame rate or depth of the pipeline.
+    auto stream = FindTrackingStream(trackingId);
     if (stream == nullptr) {
-        CAMERA_LOGE("cannot handle stream %{public}d", message->trackingId);
+        CAMERA_LOGE("cannot handle stream %{public}d", trackingId);
         return;
     }
 
     if (!stream->IsNodeComplete()) {
-        CAMERA_LOGW("tracking node in stream %{public}d is incomplete", message->trackingId);
+        CAMERA_LOGW("tracking node in stream %{public}d is incomplete", trackingId);
         return;
     }
 
-    auto buffer = std::make_shared<TrackingBuffer>(message->frameNumber);
-    if (message->isReturnBack) {
-        stream->RemoveBuffer(buffer);
-        CAMERA_LOGI("buffer %{public}llu return back to pool.", message->frameNumber);
+    if (isReturnBack) {
+        stream->RemoveBuffer(frameNumber, timestamp);
+        CAMERA_LOGV("buffer %{public}llu return back to pool.", frameNumber);
         return;
     }
 
-    auto node = std::make_shared<TrackingNode>(message->nodeName);
-    stream->MoveBuffer(buffer, node);
+    stream->MoveBuffer(frameNumber, node, timestamp);
 
     return;
 }
 
 void BufferLoopTracking::StartTracking()
 {
-    handler_ = std::make_unique<std::thread>([this] {
-        prctl(PR_SET_NAME, "buffertracking");
-        do {
-            HandleMessage();
-        } while (running_.load() == true);
-    });
-    if (handler_ == nullptr) {
-        return;
-    }
     running_ = true;
     return;
 }
@@ -434,8 +403,6 @@ void BufferLoopTracking::StartTracking()
 void BufferLoopTracking::StopTracking()
 {
     running_ = false;
-    cv_.notify_one();
-    handler_->join();
     return;
 }
 
@@ -446,8 +413,7 @@ int32_t BufferLoopTracking::IsEmpty(const int32_t id, const std::string node)
         CAMERA_LOGI("stream %{public}d doesn't exist", id);
         return INVALID_TRACKING_ID;
     }
-    auto n = stream->FindTrackingNode(node);
-    return n->IsEmpty() ? NODE_IS_EMPTY : NODE_IS_NOT_EMPTY;
+    return stream->IsEmpty(node);
 }
 
 int32_t BufferLoopTracking::IsEmpty(const int32_t id, const std::string beginNode, const std::string endNode)
@@ -457,19 +423,7 @@ int32_t BufferLoopTracking::IsEmpty(const int32_t id, const std::string beginNod
         CAMERA_LOGI("stream %{public}d doesn't exist", id);
         return INVALID_TRACKING_ID;
     }
-    auto nodePath = stream->FindTrackingNodePath(beginNode, endNode);
-    for (auto& n : nodePath) {
-        if (n == nullptr) {
-            continue;
-        }
-        if (n->IsEmpty() != true) {
-            return NODE_IS_NOT_EMPTY;
-        } else {
-            return NODE_IS_EMPTY;
-        }
-    }
-
-    return true;
+    return stream->IsEmpty(beginNode, endNode);
 }
 
 void BufferLoopTracking::DumpTrace(const int32_t id, BufferTraceGraph& graph)
@@ -483,4 +437,45 @@ void BufferLoopTracking::DumpTrace(const int32_t id, BufferTraceGraph& graph)
     stream->DumpTrace(graph);
     return;
 }
+
+bool BufferLoopTracking::IsTracking() const
+{
+    return running_.load();
+}
+
+RetCode BufferLoopTracking::GetLatency(const int32_t id, BufferLatency& latency)
+{
+    auto stream = FindTrackingStream(id);
+    if (stream == nullptr) {
+        CAMERA_LOGI("stream %{public}d doesn't exist, can't get latency", id);
+        return RC_ERROR;
+    }
+
+    stream->GetLatency(latency);
+    return RC_OK;
+}
+
+RetCode BufferLoopTracking::DumpLatency(const int32_t id, const std::string& path)
+{
+    BufferLatency latency = {};
+    if (GetLatency(id, latency) != RC_OK) {
+        return RC_ERROR;
+    }
+
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        CAMERA_LOGE("can't open %{public}s to dump latency", path.c_str());
+        return RC_ERROR;
+    }
+    auto dump = [&file](const std::string& name, const LatencyStatistics& s) {
+        file << name << ": count " << s.count << ", p50 " << s.p50 << "us, p90 " << s.p90 << "us, p99 " <<
+            s.p99 << "us, max " << s.max << "us" << std::endl;
+    };
+    file << "stream " << id << " buffer latency" << std::endl;
+    for (auto& [name, statistics] : latency.nodes) {
+        dump(name, statistics);
+    }
+    dump("end to end", latency.endToEnd);
+    return file.good() ? RC_OK : RC_ERROR;
+}
 } // namespace OHOS::Camera
@@ -14,45 +14,110 @@
  */
 
 #include "buffer_manager.h"
-#include <sys/time.h>
+#include <vector>
 #include "buffer_pool.h"
 
 namespace OHOS::Camera {
+namespace {
+    constexpr uint32_t BUFFER_TRIM_INTERVAL_MS = 1000;
+}
+
 BufferManager* BufferManager::GetInstance()
 {
     static BufferManager manager;
     return &manager;
 }
 
-int64_t BufferManager::GenerateBufferPoolId()
+BufferManager::~BufferManager()
 {
-    std::lock_guard<std::mutex> l(lock_);
+    {
+        std::unique_lock<std::mutex> l(trimLock_);
+        trimRunning_ = false;
+        trimCv_.notify_all();
+    }
+    if (trimThread_ != nullptr) {
+        trimThread_->join();
+        delete trimThread_;
+        trimThread_ = nullptr;
+    }
+}
 
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    int64_t id = tv.tv_sec * 1000 * 1000 + tv.tv_usec; // 1000:뻻΢
+int64_t BufferManager::GenerateBufferPoolId()
+{
+    int64_t id = nextPoolId_.fetch_add(1, std::memory_order_relaxed);
 
-    std::shared_ptr<IBufferPool> bufferPool = nullptr;
-    bufferPoolMap_[id] = bufferPool;
+    PoolShard& shard = GetShard(id);
+    std::lock_guard<std::mutex> l(shard.lock);
+    shard.pools[id].reset();
 
     return id;
 }
 
+BufferManager::PoolShard& BufferManager::GetShard(const int64_t id)
+{
+    return shards_[static_cast<uint64_t>(id) % POOL_SHARD_COUNT];
+}
+
 std::shared_ptr<IBufferPool> BufferManager::GetBufferPool(int64_t id)
 {
-    std::lock_guard<std::mutex> l(lock_);
+    PoolShard& shard = GetShard(id);
+    std::lock_guard<std::mutex> l(shard.lock);
 
-    if (bufferPoolMap_.find(id) == bufferPoolMap_.end()) {
+    auto it = shard.pools.find(id);
+    if (it == shard.pools.end()) {
         return nullptr;
     }
 
-    if (bufferPoolMap_[id].expired()) {
-        std::shared_ptr<IBufferPool> bufferPool = std::make_shared<BufferPool>();
-        bufferPoolMap_[id] = bufferPool;
+    std::shared_ptr<IBufferPool> bufferPool = it->second.lock();
+    if (bufferPool == nullptr) {
+        bufferPool = std::make_shared<BufferPool>();
+        it->second = bufferPool;
         bufferPool->SetId(id);
-        return bufferPool;
     }
 
-    return bufferPoolMap_[id].lock();
+    return bufferPool;
+}
+
+void BufferManager::StartTrimming()
+{
+    std::unique_lock<std::mutex> l(trimLock_);
+    if (trimThread_ != nullptr) {
+        return;
+    }
+
+    trimRunning_ = true;
+    trimThread_ = new std::thread([this] {
+        prctl(PR_SET_NAME, "buffertrimming");
+        std::unique_lock<std::mutex> trimLock(trimLock_);
+        while (trimRunning_) {
+            trimCv_.wait_for(trimLock, std::chrono::milliseconds(BUFFER_TRIM_INTERVAL_MS), [this] {
+                return !trimRunning_;
+            });
+            if (!trimRunning_) {
+                break;
+            }
+            trimLock.unlock();
+            TrimBufferPools();
+            trimLock.lock();
+        }
+    });
+}
+
+void BufferManager::TrimBufferPools()
+{
+    std::vector<std::shared_ptr<IBufferPool>> pools = {};
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> l(shard.lock);
+        for (auto& it : shard.pools) {
+            auto pool = it.second.lock();
+            if (pool != nullptr) {
+                pools.emplace_back(pool);
+            }
+        }
+    }
+
+    for (auto& it : pools) {
+        it->TrimBuffers();
+    }
 }
 } // namespace OHOS::Camera
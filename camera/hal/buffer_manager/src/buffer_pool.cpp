@@ -14,8 +14,11 @@
  */
 
 #include "buffer_pool.h"
+#include <algorithm>
 #include <chrono>
 #include "buffer_adapter.h"
+#include "buffer_allocator_utils.h"
+#include "buffer_manager.h"
 #include "image_buffer.h"
 #include "buffer_tracking.h"
 
@@ -44,27 +47,23 @@ RetCode BufferPool::Init(const uint32_t width,
     bufferCount_ = count;
     bufferSourceType_ = bufferSourceType;
 
+    if (elastic_ && maxCount_ < bufferCount_) {
+        CAMERA_LOGE("max count %{public}u of elastic pool is less than count %{public}u", maxCount_, bufferCount_);
+        return RC_ERROR;
+    }
+
     if (bufferSourceType_ == CAMERA_BUFFER_SOURCE_TYPE_EXTERNAL) {
         CAMERA_LOGI("buffers are from external source");
         return RC_OK;
     }
 
-    BufferAllocatorFactory* factory = BufferAllocatorFactory::GetInstance();
-    if (factory == nullptr) {
-        CAMERA_LOGE("buffer allocator factory is null");
-        return RC_ERROR;
-    }
-
-    bufferAllocator_ = factory->GetBufferAllocator(bufferSourceType_);
+    // the allocator of a source is resolved and initialized once per process.
+    bufferAllocator_ = BufferAllocatorUtils::GetBufferAllocator(bufferSourceType_);
     if (bufferAllocator_ == nullptr) {
         CAMERA_LOGI("can't find buffer allocator");
         return RC_ERROR;
     }
 
-    if (bufferAllocator_->Init() != RC_OK) {
-        return RC_ERROR;
-    }
-
     return PrepareBuffer();
 }
 
@@ -80,35 +79,73 @@ RetCode BufferPool::PrepareBuffer()
         return RC_ERROR;
     }
 
-    for (uint32_t i = 0; i < bufferCount_; i++) {
-        std::shared_ptr<IBuffer> buffer =
-            bufferAllocator_->AllocBuffer(bufferWidth_, bufferHeight_, bufferUsage_, bufferFormat_);
-        if (buffer == nullptr) {
-            CAMERA_LOGE("alloc buffer failed");
-            return RC_ERROR;
-        }
-        if (RC_OK != bufferAllocator_->MapBuffer(buffer)) {
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        slots_.reserve(elastic_ ? maxCount_ : bufferCount_);
+    }
+
+    if (elastic_) {
+        CAMERA_LOGI("buffers are allocated on demand, max count = %{public}u", maxCount_);
+        return RC_OK;
+    }
+
+    std::vector<std::shared_ptr<IBuffer>> buffers;
+    if (BufferAllocatorUtils::AllocBuffers(bufferSourceType_, bufferCount_, bufferWidth_, bufferHeight_,
+        bufferUsage_, bufferFormat_, buffers) != RC_OK) {
+        CAMERA_LOGE("alloc %{public}u buffers failed", bufferCount_);
+        return RC_ERROR;
+    }
+    for (uint32_t i = 0; i < buffers.size(); i++) {
+        if (RC_OK != bufferAllocator_->MapBuffer(buffers[i])) {
             CAMERA_LOGE("map buffer failed");
+            for (uint32_t j = 0; j < i; j++) {
+                bufferAllocator_->UnmapBuffer(buffers[j]);
+            }
+            BufferAllocatorUtils::FreeBuffers(buffers);
             return RC_ERROR;
         }
-        buffer->SetIndex(i);
-        buffer->SetPoolId(poolId_);
+        buffers[i]->SetPoolId(poolId_);
+        buffers[i]->SetPool(weak_from_this());
+    }
 
-        {
-            std::unique_lock<std::mutex> l(lock_);
-            idleList_.emplace_back(buffer);
-        }
+    std::unique_lock<std::mutex> l(lock_);
+    for (auto& it : buffers) {
+        PushIdleSlot(PlaceBuffer(it));
+        allocatedCount_++;
     }
 
     return RC_OK;
 }
 
+std::shared_ptr<IBuffer> BufferPool::AllocateBuffer()
+{
+    std::shared_ptr<IBuffer> buffer =
+        bufferAllocator_->AllocBuffer(bufferWidth_, bufferHeight_, bufferUsage_, bufferFormat_);
+    if (buffer == nullptr) {
+        CAMERA_LOGE("alloc buffer failed");
+        return nullptr;
+    }
+    if (RC_OK != bufferAllocator_->MapBuffer(buffer)) {
+        CAMERA_LOGE("map buffer failed");
+        bufferAllocator_->FreeBuffer(buffer);
+        return nullptr;
+    }
+    buffer->SetPoolId(poolId_);
+    buffer->SetPool(weak_from_this());
+    return buffer;
+}
+
 RetCode BufferPool::DestroyBuffer()
 {
     if (bufferSourceType_ == CAMERA_BUFFER_SOURCE_TYPE_EXTERNAL) {
         std::unique_lock<std::mutex> l(lock_);
-        idleList_.clear();
-        busyList_.clear();
+        slots_.clear();
+        slotMap_.clear();
+        idleHead_ = -1;
+        idleTail_ = -1;
+        vacantHead_ = -1;
+        idleCount_ = 0;
+        busyCount_ = 0;
         return RC_OK;
     }
 
@@ -120,87 +157,219 @@ RetCode BufferPool::DestroyBuffer()
     {
         std::unique_lock<std::mutex> l(lock_);
 
-        for (auto it : idleList_) {
-            RetCode ret = bufferAllocator_->UnmapBuffer(it);
-            if (ret != RC_OK) {
-                CAMERA_LOGE("unmap (%{public}d) buffer failed", it->GetIndex());
-            }
-            ret = bufferAllocator_->FreeBuffer(it);
-            if (ret != RC_OK) {
-                CAMERA_LOGE("free (%{public}d) buffer failed", it->GetIndex());
-            }
-        }
-        idleList_.clear();
-
-        if (busyList_.size() > 0) {
-            CAMERA_LOGE("%{public}u buffer(s) is/are in use.", busyList_.size());
+        if (busyCount_ > 0) {
+            CAMERA_LOGE("%{public}u buffer(s) is/are in use.", busyCount_);
         }
-        for (auto it : busyList_) {
-            RetCode ret = bufferAllocator_->UnmapBuffer(it);
+        for (auto& it : slots_) {
+            if (it.buffer == nullptr) {
+                continue;
+            }
+            RetCode ret = bufferAllocator_->UnmapBuffer(it.buffer);
             if (ret != RC_OK) {
-                CAMERA_LOGE("unmap (%{public}d) buffer failed", it->GetIndex());
+                CAMERA_LOGE("unmap (%{public}d) buffer failed", it.buffer->GetIndex());
             }
-            ret = bufferAllocator_->FreeBuffer(it);
+            ret = bufferAllocator_->FreeBuffer(it.buffer);
             if (ret != RC_OK) {
-                CAMERA_LOGE("free (%{public}d) buffer failed", it->GetIndex());
+                CAMERA_LOGE("free (%{public}d) buffer failed", it.buffer->GetIndex());
             }
         }
-        busyList_.clear();
+        slots_.clear();
+        slotMap_.clear();
+        idleHead_ = -1;
+        idleTail_ = -1;
+        vacantHead_ = -1;
+        idleCount_ = 0;
+        busyCount_ = 0;
+        allocatedCount_ = 0;
+        windowPeakCount_ = 0;
     }
 
     return RC_OK;
 }
 
+int32_t BufferPool::FindSlot(const std::shared_ptr<IBuffer>& buffer) const
+{
+    // buffers allocated by pool use their index as slot, so the common path needs no lookup.
+    int32_t index = buffer->GetIndex();
+    if (index >= 0 && static_cast<size_t>(index) < slots_.size() && slots_[index].buffer == buffer) {
+        return index;
+    }
+
+    auto it = slotMap_.find(buffer.get());
+    if (it == slotMap_.end()) {
+        return -1;
+    }
+    return it->second;
+}
+
+int32_t BufferPool::NewSlot(const std::shared_ptr<IBuffer>& buffer)
+{
+    int32_t slot = static_cast<int32_t>(slots_.size());
+    slots_.emplace_back();
+    slots_[slot].buffer = buffer;
+    if (buffer->GetIndex() != slot) {
+        slotMap_[buffer.get()] = slot;
+    }
+    return slot;
+}
+
+int32_t BufferPool::PlaceBuffer(const std::shared_ptr<IBuffer>& buffer)
+{
+    // reuse a slot released by trimming, so that index of buffer stays in [0, maxCount).
+    if (vacantHead_ < 0) {
+        buffer->SetIndex(static_cast<int32_t>(slots_.size()));
+        return NewSlot(buffer);
+    }
+
+    int32_t slot = vacantHead_;
+    vacantHead_ = slots_[slot].next;
+    buffer->SetIndex(slot);
+    slots_[slot].buffer = buffer;
+    slots_[slot].next = -1;
+    return slot;
+}
+
+void BufferPool::PushIdleSlot(const int32_t slot)
+{
+    slots_[slot].state = SLOT_IDLE;
+    slots_[slot].next = -1;
+    if (idleTail_ >= 0) {
+        slots_[idleTail_].next = slot;
+    } else {
+        idleHead_ = slot;
+    }
+    idleTail_ = slot;
+    idleCount_++;
+    if (idleCallback_ != nullptr) {
+        idleCallback_();
+    }
+}
+
+int32_t BufferPool::UnlinkIdleSlot()
+{
+    int32_t slot = idleHead_;
+    idleHead_ = slots_[slot].next;
+    if (idleHead_ < 0) {
+        idleTail_ = -1;
+    }
+    slots_[slot].next = -1;
+    idleCount_--;
+    return slot;
+}
+
+void BufferPool::MarkBusy(const int32_t slot)
+{
+    slots_[slot].state = SLOT_BUSY;
+    slots_[slot].ownerOut = true;
+    slots_[slot].holders = 1;
+    busyCount_++;
+    peakInUseCount_ = std::max(peakInUseCount_, busyCount_);
+    windowPeakCount_ = std::max(windowPeakCount_, busyCount_);
+}
+
+std::shared_ptr<IBuffer> BufferPool::PopIdleSlot()
+{
+    int32_t slot = UnlinkIdleSlot();
+    MarkBusy(slot);
+    return slots_[slot].buffer;
+}
+
+bool BufferPool::CanGrow() const
+{
+    if (!elastic_ || bufferAllocator_ == nullptr) {
+        return false;
+    }
+
+    // allocate rather than wait or drop the frame, up to max count.
+    return allocatedCount_ < maxCount_;
+}
+
+std::shared_ptr<IBuffer> BufferPool::GrowBuffer()
+{
+    // allocator is used with pool locked, so trimming or clearing can't free the buffers under it.
+    std::shared_ptr<IBuffer> buffer = AllocateBuffer();
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+
+    allocatedCount_++;
+    int32_t slot = PlaceBuffer(buffer);
+    MarkBusy(slot);
+    CAMERA_LOGI("pool %{public}lld grows to %{public}u buffers", poolId_, allocatedCount_);
+    return buffer;
+}
+
 RetCode BufferPool::AddBuffer(std::shared_ptr<IBuffer>& buffer)
 {
     std::unique_lock<std::mutex> l(lock_);
     buffer->SetPoolId(poolId_);
-    idleList_.emplace_back(buffer);
+    buffer->SetPool(weak_from_this());
+
+    // external buffers keep their slot after they are returned, and reuse it when they are added again.
+    int32_t slot = FindSlot(buffer);
+    if (slot < 0) {
+        slot = NewSlot(buffer);
+    }
+    if (slots_[slot].state == SLOT_IDLE) {
+        CAMERA_LOGW("buffer %{public}d is already idle in pool", buffer->GetIndex());
+        return RC_OK;
+    }
+    if (slots_[slot].state == SLOT_BUSY) {
+        busyCount_--;
+    }
+    slots_[slot].ownerOut = false;
+    slots_[slot].holders = 0;
+    PushIdleSlot(slot);
     cv_.notify_one();
     return RC_OK;
 }
 
 std::shared_ptr<IBuffer> BufferPool::AcquireBuffer(int timeout)
+{
+    return AcquireBuffer(std::chrono::microseconds(std::chrono::seconds(timeout)));
+}
+
+std::shared_ptr<IBuffer> BufferPool::AcquireBuffer(const std::chrono::microseconds& timeout)
 {
     std::unique_lock<std::mutex> l(lock_);
 
     // return buffer immediately, if idle buffer is avaliable;
-    if (!idleList_.empty()) {
-        auto it = idleList_.begin();
-        auto buffer = *it;
-        busyList_.splice(busyList_.begin(), idleList_, it);
+    if (idleCount_ > 0) {
+        auto buffer = PopIdleSlot();
         CAMERA_LOGV("acquire buffer immediately, index = %{public}d", buffer->GetIndex());
-        return *it;
+        return buffer;
+    }
+
+    // allocate a new buffer rather than wait, if pool is elastic and not full.
+    if (CanGrow()) {
+        return GrowBuffer();
     }
 
     // wait all the time, till idle list is avaliable.
-    if (timeout < 0) {
+    if (timeout.count() < 0) {
         cv_.wait(l, [this] {
-            return !idleList_.empty() || stop_;
+            return idleCount_ > 0 || stop_;
             });
-        if (!idleList_.empty()) {
-            auto it = idleList_.begin();
-            auto buffer = *it;
-            busyList_.splice(busyList_.begin(), idleList_, it);
+        if (idleCount_ > 0) {
+            auto buffer = PopIdleSlot();
             CAMERA_LOGV("acquire buffer wait all the time, index = %{public}d", buffer->GetIndex());
-            return *it;
+            return buffer;
         }
     }
 
     // wait for timeout, or idle list is avaliable.
-    if (timeout > 0) {
-        if (cv_.wait_for(l, std::chrono::seconds(timeout), [this] {
-            return !idleList_.empty() || stop_;
+    if (timeout.count() > 0) {
+        if (cv_.wait_for(l, timeout, [this] {
+            return idleCount_ > 0 || stop_;
             }) == false) {
             CAMERA_LOGE("wait idle buffer timeout");
             return nullptr;
         }
-        if (!idleList_.empty()) {
-            auto it = idleList_.begin();
-            auto buffer = *it;
-            busyList_.splice(busyList_.begin(), idleList_, it);
-            CAMERA_LOGV("acquire buffer wait %{public}ds, index = %{public}d", timeout, buffer->GetIndex());
-            return *it;
+        if (idleCount_ > 0) {
+            auto buffer = PopIdleSlot();
+            CAMERA_LOGV("acquire buffer wait %{public}lldus, index = %{public}d",
+                static_cast<long long>(timeout.count()), buffer->GetIndex());
+            return buffer;
         }
     }
 
@@ -212,28 +381,182 @@ RetCode BufferPool::ReturnBuffer(std::shared_ptr<IBuffer>& buffer)
 {
     std::unique_lock<std::mutex> l(lock_);
 
-    auto it = std::find(busyList_.begin(), busyList_.end(), buffer);
-    if (it == busyList_.end()) {
-        CAMERA_LOGE("fatal error, busy list is empty, cannot return buffer.");
+    int32_t slot = FindSlot(buffer);
+    if (slot < 0 || slots_[slot].state != SLOT_BUSY) {
+        CAMERA_LOGE("fatal error, buffer is not in use, cannot return buffer.");
+        return RC_ERROR;
+    }
+
+    BufferSlot& bufferSlot = slots_[slot];
+    if (bufferSlot.buffer != buffer) {
+        // a shared view is returned, it can't be returned twice.
+        slotMap_.erase(buffer.get());
+    } else if (bufferSlot.ownerOut) {
+        bufferSlot.ownerOut = false;
+    } else {
+        CAMERA_LOGE("fatal error, buffer %{public}d is returned twice.", buffer->GetIndex());
         return RC_ERROR;
     }
 
+    if (--bufferSlot.holders > 0) {
+        return RC_OK;
+    }
+    ReleaseSlot(slot);
+
+    return RC_OK;
+}
+
+void BufferPool::ReleaseSlot(const int32_t slot)
+{
+    busyCount_--;
+
     if (bufferSourceType_ == CAMERA_BUFFER_SOURCE_TYPE_EXTERNAL) {
-        busyList_.erase(it);
+        slots_[slot].state = SLOT_VACANT;
         cv_.notify_one();
-        return RC_OK;
+        return;
     }
 
     if (trackingId_ >= 0) {
-        POOL_REPORT_BUFFER_LOCATION(trackingId_, buffer->GetFrameNumber());
+        POOL_REPORT_BUFFER_LOCATION(trackingId_, slots_[slot].buffer->GetFrameNumber());
     }
 
-    idleList_.splice(idleList_.end(), busyList_, it);
+    PushIdleSlot(slot);
     cv_.notify_one();
+}
+
+std::shared_ptr<IBuffer> BufferPool::ShareBuffer(const std::shared_ptr<IBuffer>& buffer)
+{
+    CHECK_IF_PTR_NULL_RETURN_VALUE(buffer, nullptr);
+    std::unique_lock<std::mutex> l(lock_);
+
+    int32_t slot = FindSlot(buffer);
+    if (slot < 0 || slots_[slot].state != SLOT_BUSY) {
+        CAMERA_LOGE("buffer is not in use, cannot share it.");
+        return nullptr;
+    }
+
+    // the view describes the same memory, meta data is copied so that consumer can change it freely.
+    // a view which is dropped without being returned gives up its hold when the last reference goes.
+    std::shared_ptr<IBuffer> source = slots_[slot].buffer;
+    std::weak_ptr<BufferPool> pool = weak_from_this();
+    std::shared_ptr<IBuffer> view(new ImageBuffer(source->GetSourceType(), source->GetWidth(),
+        source->GetHeight(), source->GetUsage(), source->GetFormat()), [pool](IBuffer* p) {
+            std::shared_ptr<BufferPool> self = pool.lock();
+            if (self != nullptr) {
+                self->DropView(p);
+            }
+            delete p;
+        });
+    view->SetIndex(source->GetIndex());
+    view->SetStride(source->GetStride());
+    view->SetSize(source->GetSize());
+    view->SetVirAddress(source->GetVirAddress());
+    view->SetPhyAddress(source->GetPhyAddress());
+    view->SetFileDescriptor(source->GetFileDescriptor());
+    view->SetTimestamp(buffer->GetTimestamp());
+    view->SetFrameNumber(buffer->GetFrameNumber());
+    view->SetPoolId(poolId_);
+    view->SetPool(weak_from_this());
+    view->SetCaptureId(buffer->GetCaptureId());
+    view->SetBufferStatus(buffer->GetBufferStatus());
+    view->SetEncodeType(buffer->GetEncodeType());
+    view->SetStreamId(buffer->GetStreamId());
+
+    slotMap_[view.get()] = slot;
+    slots_[slot].holders++;
+    return view;
+}
 
+void BufferPool::DropView(const IBuffer* view)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    auto it = slotMap_.find(view);
+    if (it == slotMap_.end()) {
+        return;
+    }
+
+    int32_t slot = it->second;
+    slotMap_.erase(it);
+    CAMERA_LOGW("view of buffer %{public}d is dropped without return", slot);
+    if (--slots_[slot].holders > 0) {
+        return;
+    }
+    ReleaseSlot(slot);
+}
+
+RetCode BufferPool::SetElasticPolicy(const uint32_t maxCount, const uint32_t lowWatermark)
+{
+    if (maxCount == 0 || lowWatermark > maxCount) {
+        CAMERA_LOGE("invalid elastic policy, max count = %{public}u, low watermark = %{public}u",
+            maxCount, lowWatermark);
+        return RC_ERROR;
+    }
+
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        elastic_ = true;
+        maxCount_ = maxCount;
+        lowWatermark_ = lowWatermark;
+    }
+
+    BufferManager* manager = BufferManager::GetInstance();
+    if (manager != nullptr) {
+        manager->StartTrimming();
+    }
     return RC_OK;
 }
 
+void BufferPool::TrimBuffers()
+{
+    std::unique_lock<std::mutex> l(lock_);
+    if (!elastic_ || bufferSourceType_ == CAMERA_BUFFER_SOURCE_TYPE_EXTERNAL || bufferAllocator_ == nullptr) {
+        return;
+    }
+
+    // keep as many buffers as were in use at the same time since last trimming.
+    std::vector<std::shared_ptr<IBuffer>> trimList = {};
+    uint32_t keepCount = std::max(lowWatermark_, windowPeakCount_);
+    windowPeakCount_ = busyCount_;
+    while (allocatedCount_ > keepCount && idleCount_ > 0) {
+        int32_t slot = UnlinkIdleSlot();
+        trimList.emplace_back(slots_[slot].buffer);
+        slots_[slot].buffer = nullptr;
+        slots_[slot].state = SLOT_VACANT;
+        slots_[slot].next = vacantHead_;
+        vacantHead_ = slot;
+        allocatedCount_--;
+        trimmedCount_++;
+    }
+
+    for (auto& it : trimList) {
+        if (bufferAllocator_->UnmapBuffer(it) != RC_OK) {
+            CAMERA_LOGE("unmap (%{public}d) buffer failed", it->GetIndex());
+        }
+        if (bufferAllocator_->FreeBuffer(it) != RC_OK) {
+            CAMERA_LOGE("free (%{public}d) buffer failed", it->GetIndex());
+        }
+    }
+    if (!trimList.empty()) {
+        CAMERA_LOGI("pool %{public}lld trims %{public}u buffers", poolId_, trimList.size());
+    }
+}
+
+BufferPoolStatistics BufferPool::GetStatistics()
+{
+    std::unique_lock<std::mutex> l(lock_);
+    BufferPoolStatistics statistics = {};
+    statistics.allocatedCount = allocatedCount_;
+    statistics.peakInUseCount = peakInUseCount_;
+    statistics.trimmedCount = trimmedCount_;
+    return statistics;
+}
+
+void BufferPool::SetIdleCallback(const std::function<void()>& callback)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    idleCallback_ = callback;
+}
+
 void BufferPool::EnableTracking(const int32_t id)
 {
     trackingId_ = id;
@@ -265,6 +588,6 @@ void BufferPool::ClearBuffers()
 uint32_t BufferPool::GetIdleBufferCount()
 {
     std::unique_lock<std::mutex> l(lock_);
-    return idleList_.size();
+    return idleCount_;
 }
 } // namespace OHOS::Camera
@@ -14,6 +14,7 @@
  */
 
 #include "buffer_tracking.h"
+#include <chrono>
 #include "buffer_loop_tracking.h"
 
 namespace OHOS::Camera {
@@ -49,11 +50,28 @@ void BufferTracking::AddTrackingNode(const int32_t trackingId, const std::string
 
 void BufferTracking::ReportBufferLocation(const std::shared_ptr<BufferTrackingMessage>& message)
 {
+    if (message == nullptr) {
+        return;
+    }
+    if (message->timestamp == 0) {
+        message->timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
     BufferLoopTracking& stalker = BufferLoopTracking::GetInstance();
     stalker.SendBufferMovementMessage(message);
     return;
 }
 
+void BufferTracking::ReportBufferLocation(const int32_t trackingId, const uint64_t frameNumber,
+    const std::string& node, const bool isReturnBack)
+{
+    uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    BufferLoopTracking& stalker = BufferLoopTracking::GetInstance();
+    stalker.ReportBufferLocation(trackingId, frameNumber, node, isReturnBack, timestamp);
+    return;
+}
+
 void BufferTracking::StartTracking()
 {
     BufferLoopTracking& stalker = BufferLoopTracking::GetInstance();
@@ -68,6 +86,12 @@ void BufferTracking::StopTracking()
     return;
 }
 
+bool BufferTracking::IsTracking()
+{
+    BufferLoopTracking& stalker = BufferLoopTracking::GetInstance();
+    return stalker.IsTracking();
+}
+
 int32_t BufferTracking::IsNodeEmpty(const int32_t id, const std::string node)
 {
     BufferLoopTracking& stalker = BufferLoopTracking::GetInstance();
@@ -86,4 +110,16 @@ void BufferTracking::DumpBufferTrace(const int32_t id, BufferTraceGraph& graph)
     stalker.DumpTrace(id, graph);
     return;
 }
+
+RetCode BufferTracking::GetBufferLatency(const int32_t id, BufferLatency& latency)
+{
+    BufferLoopTracking& stalker = BufferLoopTracking::GetInstance();
+    return stalker.GetLatency(id, latency);
+}
+
+RetCode BufferTracking::DumpBufferLatency(const int32_t id, const std::string& path)
+{
+    BufferLoopTracking& stalker = BufferLoopTracking::GetInstance();
+    return stalker.DumpLatency(id, path);
+}
 } // namespace OHOS::Camera
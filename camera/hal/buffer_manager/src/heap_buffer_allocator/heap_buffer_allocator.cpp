@@ -14,9 +14,129 @@
  */
 
 #include "heap_buffer_allocator.h"
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <sys/mman.h>
 #include "image_buffer.h"
 
 namespace OHOS::Camera {
+namespace {
+    constexpr size_t ARENA_PAGE_SIZE = 4096;
+    constexpr size_t ARENA_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    // a block is only rounded up to huge pages if it wastes no more than 1/8 of its size.
+    constexpr size_t ARENA_HUGE_PAGE_WASTE_RATIO = 8;
+    // idle blocks kept for the next pool, beyond this they're unmapped, largest first.
+    constexpr size_t ARENA_IDLE_LIMIT = 64 * 1024 * 1024;
+    constexpr uint32_t BYTES_PER_PIXEL_2 = 2;
+    constexpr uint32_t BYTES_PER_PIXEL_3 = 3;
+    constexpr uint32_t BYTES_PER_PIXEL_4 = 4;
+
+    size_t AlignUp(const size_t value, const size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+// Memory of heap buffers is mapped page aligned, blocks of 2M or more are backed by huge pages where
+// possible and rounded up to them when that costs little. Freed blocks are kept and handed out again
+// for the same size, so pools which are torn down and re-created on stream reconfiguration don't
+// mmap/munmap again.
+class HeapBufferArena {
+public:
+    static HeapBufferArena& GetInstance();
+    void* Alloc(const size_t size);
+    void Free(void* addr);
+
+private:
+    HeapBufferArena() = default;
+    ~HeapBufferArena() = default;
+    static size_t BlockSize(const size_t size);
+
+private:
+    std::mutex lock_;
+    // blocks in use, address -> size of the block
+    std::unordered_map<void*, size_t> busyBlocks_ = {};
+    std::multimap<size_t, void*> idleBlocks_ = {};
+    size_t idleBytes_ = 0;
+};
+
+HeapBufferArena& HeapBufferArena::GetInstance()
+{
+    // never destroyed, buffers may be freed by static objects at exit.
+    static HeapBufferArena* arena = new HeapBufferArena();
+    return *arena;
+}
+
+size_t HeapBufferArena::BlockSize(const size_t size)
+{
+    size_t blockSize = AlignUp(size, ARENA_PAGE_SIZE);
+    if (size >= ARENA_HUGE_PAGE_SIZE) {
+        size_t hugeSize = AlignUp(size, ARENA_HUGE_PAGE_SIZE);
+        if (hugeSize - size <= size / ARENA_HUGE_PAGE_WASTE_RATIO) {
+            blockSize = hugeSize;
+        }
+    }
+    return blockSize;
+}
+
+void* HeapBufferArena::Alloc(const size_t size)
+{
+    size_t blockSize = BlockSize(size);
+    {
+        std::lock_guard<std::mutex> l(lock_);
+        auto it = idleBlocks_.find(blockSize);
+        if (it != idleBlocks_.end()) {
+            void* addr = it->second;
+            idleBlocks_.erase(it);
+            idleBytes_ -= blockSize;
+            busyBlocks_[addr] = blockSize;
+            return addr;
+        }
+    }
+
+    void* addr = mmap(nullptr, blockSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        CAMERA_LOGE("map %{public}zu bytes failed", blockSize);
+        return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    if (blockSize >= ARENA_HUGE_PAGE_SIZE) {
+        // only a hint, it's fine if transparent huge pages are disabled.
+        (void)madvise(addr, blockSize, MADV_HUGEPAGE);
+    }
+#endif
+    std::lock_guard<std::mutex> l(lock_);
+    busyBlocks_[addr] = blockSize;
+    return addr;
+}
+
+void HeapBufferArena::Free(void* addr)
+{
+    std::vector<std::pair<void*, size_t>> unmapList = {};
+    {
+        std::lock_guard<std::mutex> l(lock_);
+        auto it = busyBlocks_.find(addr);
+        if (it == busyBlocks_.end()) {
+            CAMERA_LOGE("%{public}p isn't allocated by heap buffer arena", addr);
+            return;
+        }
+        idleBlocks_.emplace(it->second, addr);
+        idleBytes_ += it->second;
+        busyBlocks_.erase(it);
+        while (idleBytes_ > ARENA_IDLE_LIMIT && !idleBlocks_.empty()) {
+            auto largest = std::prev(idleBlocks_.end());
+            unmapList.emplace_back(largest->second, largest->first);
+            idleBytes_ -= largest->first;
+            idleBlocks_.erase(largest);
+        }
+    }
+    for (auto& it : unmapList) {
+        munmap(it.first, it.second);
+    }
+}
+
 HeapBufferAllocator::HeapBufferAllocator()
 {
     CAMERA_LOGD("buffer allocator construct, instance = %{public}p", this);
@@ -35,9 +155,9 @@ std::shared_ptr<IBuffer> HeapBufferAllocator::AllocBuffer(const uint32_t width,
                                                           const uint32_t format)
 {
     uint32_t size = CalculateSize(width, height, usage, format);
-    char* heap = nullptr;
+    void* heap = nullptr;
     if (size > 0) {
-        heap = new (std::nothrow) char[size];
+        heap = HeapBufferArena::GetInstance().Alloc(size);
     }
     if (heap == nullptr) {
         CAMERA_LOGE("Alloc buffer failed");
@@ -47,7 +167,7 @@ std::shared_ptr<IBuffer> HeapBufferAllocator::AllocBuffer(const uint32_t width,
         buffer->SetSize(size);
         buffer->SetUsage(usage);
         buffer->SetVirAddress(heap);
-        buffer->SetStride(width);
+        buffer->SetStride(CalculateStride(width, format));
         buffer->SetWidth(width);
         buffer->SetHeight(height);
         buffer->SetFormat(format);
@@ -64,10 +184,9 @@ RetCode HeapBufferAllocator::FreeBuffer(std::shared_ptr<IBuffer>& buffer)
         return RC_ERROR;
     }
 
-    char* addr = reinterpret_cast<char*>(buffer->GetVirAddress());
+    void* addr = buffer->GetVirAddress();
     if (addr != nullptr) {
-        delete[] addr;
-        addr = nullptr;
+        HeapBufferArena::GetInstance().Free(addr);
     }
     buffer->Free();
     return RC_OK;
@@ -83,6 +202,7 @@ RetCode HeapBufferAllocator::UnmapBuffer(std::shared_ptr<IBuffer>&)
     return RC_OK;
 }
 
+// heap buffers are only touched by the cpu, there is no cache to maintain.
 RetCode HeapBufferAllocator::FlushCache(std::shared_ptr<IBuffer>&)
 {
     return RC_OK;
@@ -93,12 +213,56 @@ RetCode HeapBufferAllocator::InvalidateCache(std::shared_ptr<IBuffer>&)
     return RC_OK;
 }
 
+uint32_t HeapBufferAllocator::CalculateStride(const uint32_t width, const uint32_t format) const
+{
+    uint32_t bytesPerPixel = 1;
+    switch (format) {
+        case CAMERA_FORMAT_RGB_565:
+        case CAMERA_FORMAT_RGBX_4444:
+        case CAMERA_FORMAT_RGBA_4444:
+        case CAMERA_FORMAT_RGB_444:
+        case CAMERA_FORMAT_RGBX_5551:
+        case CAMERA_FORMAT_RGBA_5551:
+        case CAMERA_FORMAT_RGB_555:
+        case CAMERA_FORMAT_BGR_565:
+        case CAMERA_FORMAT_BGRX_4444:
+        case CAMERA_FORMAT_BGRA_4444:
+        case CAMERA_FORMAT_BGRX_5551:
+        case CAMERA_FORMAT_BGRA_5551:
+        case CAMERA_FORMAT_YUV_422_I:
+        case CAMERA_FORMAT_YUYV_422_PKG:
+        case CAMERA_FORMAT_UYVY_422_PKG:
+        case CAMERA_FORMAT_YVYU_422_PKG:
+        case CAMERA_FORMAT_VYUY_422_PKG:
+            bytesPerPixel = BYTES_PER_PIXEL_2;
+            break;
+        case CAMERA_FORMAT_RGBA_5658:
+        case CAMERA_FORMAT_RGB_888:
+            bytesPerPixel = BYTES_PER_PIXEL_3;
+            break;
+        case CAMERA_FORMAT_RGBX_8888:
+        case CAMERA_FORMAT_RGBA_8888:
+        case CAMERA_FORMAT_BGRX_8888:
+        case CAMERA_FORMAT_BGRA_8888:
+            bytesPerPixel = BYTES_PER_PIXEL_4;
+            break;
+        default:
+            // planar and semi-planar yuv, the luma plane has a byte per pixel.
+            break;
+    }
+    // rows are packed, devices which fill heap buffers (e.g. v4l2 userptr) write them per their own
+    // bytesperline and don't honour a padded stride.
+    return width * bytesPerPixel;
+}
+
 uint32_t HeapBufferAllocator::CalculateSize(const uint32_t width,
                                             const uint32_t height,
                                             const uint64_t usage,
                                             const uint32_t format) const
 {
     (void)usage;
+    uint32_t stride = CalculateStride(width, format);
+    uint32_t chromaHeight = (height + 1) / 2; // 2: chroma of yuv420 is subsampled vertically
     switch (format) {
         case CAMERA_FORMAT_RGB_565:
         case CAMERA_FORMAT_RGBA_5658:
@@ -118,37 +282,32 @@ uint32_t HeapBufferAllocator::CalculateSize(const uint32_t width,
         case CAMERA_FORMAT_BGRA_5551:
         case CAMERA_FORMAT_BGRX_8888:
         case CAMERA_FORMAT_BGRA_8888:
-            break;
+        case CAMERA_FORMAT_YUV_422_I:
+        case CAMERA_FORMAT_YUYV_422_PKG:
+        case CAMERA_FORMAT_UYVY_422_PKG:
+        case CAMERA_FORMAT_YVYU_422_PKG:
+        case CAMERA_FORMAT_VYUY_422_PKG:
+            // packed, a single plane
+            return stride * height;
         case CAMERA_FORMAT_YCBCR_420_SP:
         case CAMERA_FORMAT_YCRCB_420_SP:
-        case CAMERA_FORMAT_YCRCB_422_P:
+            // luma, then interleaved chroma with the same stride
+            return stride * (height + chromaHeight);
         case CAMERA_FORMAT_YCBCR_420_P:
         case CAMERA_FORMAT_YCRCB_420_P:
-        /*
-            yuv的固定计算公式
-            yuv420 size= w * h * 3 / 2
-        */
-            return width * height * 3 / 2; // 3:yuv的固定计算值 2:yuv的固定计算值
-            break;
-        case CAMERA_FORMAT_YCBCR_422_P:
-        case CAMERA_FORMAT_YUV_422_I:
+            // luma, then two chroma planes of half the stride
+            return stride * height + stride * chromaHeight;
         case CAMERA_FORMAT_YCBCR_422_SP:
         case CAMERA_FORMAT_YCRCB_422_SP:
-        case CAMERA_FORMAT_YUYV_422_PKG:
-        case CAMERA_FORMAT_UYVY_422_PKG:
-        case CAMERA_FORMAT_YVYU_422_PKG:
-        case CAMERA_FORMAT_VYUY_422_PKG:
-        /*
-            yuv的固定计算公式
-            yuv422 size= w * h * 2
-        */
-            return width * height * 2; // 2:yuv的固定计算值
-            break;
+        case CAMERA_FORMAT_YCBCR_422_P:
+        case CAMERA_FORMAT_YCRCB_422_P:
+            // chroma has as many rows as luma
+            return stride * height * 2; // 2: luma and chroma planes
         default:
             break;
     }
+    CAMERA_LOGE("unsupported format %{public}u", format);
     return 0;
 }
 REGISTER_BUFFER_ALLOCATOR(HeapBufferAllocator, CAMERA_BUFFER_SOURCE_TYPE_HEAP);
 } // namespace OHOS::Camera
-
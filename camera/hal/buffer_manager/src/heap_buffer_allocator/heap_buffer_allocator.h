@@ -41,6 +41,8 @@ public:
 private:
     const int32_t sourceType_ = CAMERA_BUFFER_SOURCE_TYPE_HEAP;
 private:
+    // bytes of a row of the first plane, rows are packed without padding.
+    uint32_t CalculateStride(const uint32_t width, const uint32_t format) const;
     uint32_t CalculateSize(const uint32_t width,
                            const uint32_t height,
                            const uint64_t usage,
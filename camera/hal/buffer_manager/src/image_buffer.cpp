@@ -111,6 +111,13 @@ int64_t ImageBuffer::GetPoolId() const
     return poolId_;
 }
 
+std::shared_ptr<IBufferPool> ImageBuffer::GetPool() const
+{
+    // the weak pointer is rewritten by SetPool, it can't be read without the lock.
+    std::lock_guard<std::mutex> l(l_);
+    return pool_.lock();
+}
+
 int32_t ImageBuffer::GetCaptureId() const
 {
     return captureId_;
@@ -237,6 +244,13 @@ void ImageBuffer::SetPoolId(const int64_t id)
     return;
 }
 
+void ImageBuffer::SetPool(const std::weak_ptr<IBufferPool>& pool)
+{
+    std::lock_guard<std::mutex> l(l_);
+    pool_ = pool;
+    return;
+}
+
 void ImageBuffer::SetCaptureId(const int32_t id)
 {
     std::lock_guard<std::mutex> l(l_);
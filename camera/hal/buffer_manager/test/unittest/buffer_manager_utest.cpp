@@ -16,6 +16,7 @@
 #include "buffer_manager_utest.h"
 #include <chrono>
 #include <iostream>
+#include <set>
 #include <sys/wait.h>
 #include <unistd.h>
 #include "buffer_adapter.h"
@@ -133,6 +134,48 @@ HWTEST_F(BufferManagerTest, TestGetBufferPool, TestSize.Level0)
     EXPECT_EQ(true, nullbufferPool == nullptr);
 }
 
+HWTEST_F(BufferManagerTest, TestBufferPoolRegistry, TestSize.Level0)
+{
+    Camera::BufferManager* manager = Camera::BufferManager::GetInstance();
+    EXPECT_EQ(true, manager != nullptr);
+
+    // pools created at the same time get different ids.
+    const uint32_t threadCount = 4;
+    const uint32_t idCount = 100;
+    std::vector<std::vector<int64_t>> ids(threadCount);
+    std::vector<std::thread> users;
+    for (uint32_t i = 0; i < threadCount; i++) {
+        users.emplace_back([&manager, &ids, i, idCount] {
+            for (uint32_t j = 0; j < idCount; j++) {
+                ids[i].emplace_back(manager->GenerateBufferPoolId());
+            }
+        });
+    }
+    std::set<int64_t> allIds;
+    for (uint32_t i = 0; i < threadCount; i++) {
+        users[i].join();
+        allIds.insert(ids[i].begin(), ids[i].end());
+    }
+    EXPECT_EQ(true, allIds.size() == threadCount * idCount);
+
+    // buffers refer to their pool directly, and don't keep it alive.
+    std::shared_ptr<IBufferPool> bufferPool = manager->GetBufferPool(ids[0][0]);
+    EXPECT_EQ(true, bufferPool != nullptr);
+    RetCode rc = bufferPool->Init(640, 480, CAMERA_USAGE_SW_WRITE_OFTEN, CAMERA_FORMAT_YCRCB_420_SP, 2,
+                                  CAMERA_BUFFER_SOURCE_TYPE_HEAP);
+    EXPECT_EQ(true, rc == RC_OK);
+    std::shared_ptr<IBuffer> buffer = bufferPool->AcquireBuffer();
+    EXPECT_EQ(true, buffer != nullptr);
+    EXPECT_EQ(true, buffer->GetPool() == bufferPool);
+    std::shared_ptr<IBuffer> view = bufferPool->ShareBuffer(buffer);
+    EXPECT_EQ(true, view != nullptr);
+    EXPECT_EQ(true, view->GetPool() == bufferPool);
+    EXPECT_EQ(true, view->GetPool()->ReturnBuffer(view) == RC_OK);
+    EXPECT_EQ(true, buffer->GetPool()->ReturnBuffer(buffer) == RC_OK);
+    bufferPool.reset();
+    EXPECT_EQ(true, buffer->GetPool() == nullptr);
+}
+
 HWTEST_F(BufferManagerTest, TestHeapBuffer, TestSize.Level0)
 {
     Camera::BufferManager* manager = Camera::BufferManager::GetInstance();
@@ -157,7 +200,10 @@ HWTEST_F(BufferManagerTest, TestHeapBuffer, TestSize.Level0)
         EXPECT_EQ(true, buffer->GetHeight() == 1);
         EXPECT_EQ(true, buffer->GetUsage() == CAMERA_USAGE_SW_WRITE_OFTEN);
         EXPECT_EQ(true, buffer->GetFormat() == CAMERA_FORMAT_YCBCR_422_P);
+        // rows are packed, memory is aligned to pages.
+        EXPECT_EQ(true, buffer->GetStride() == 2);
         EXPECT_EQ(true, buffer->GetSize() == 4);
+        EXPECT_EQ(true, reinterpret_cast<uintptr_t>(buffer->GetVirAddress()) % 4096 == 0); // 4096: page size
 
         char src[4] = {'t', 'e', 's', 't'};
         char* dest = reinterpret_cast<char*>(buffer->GetVirAddress());
@@ -247,6 +293,252 @@ HWTEST_F(BufferManagerTest, TestInternalBufferLoop, TestSize.Level0)
     EXPECT_EQ(true, id == lastBuffer->GetIndex());
 }
 
+HWTEST_F(BufferManagerTest, TestAcquireBufferMicroseconds, TestSize.Level0)
+{
+    Camera::BufferManager* manager = Camera::BufferManager::GetInstance();
+    EXPECT_EQ(true, manager != nullptr);
+    int64_t bufferPoolId = manager->GenerateBufferPoolId();
+    EXPECT_EQ(true, bufferPoolId != 0);
+    std::shared_ptr<IBufferPool> bufferPool = manager->GetBufferPool(bufferPoolId);
+    EXPECT_EQ(true, bufferPool != nullptr);
+    RetCode rc = bufferPool->Init(2, 1, CAMERA_USAGE_SW_WRITE_OFTEN, CAMERA_FORMAT_YCBCR_422_P, 1,
+                                  CAMERA_BUFFER_SOURCE_TYPE_HEAP);
+    EXPECT_EQ(true, rc == RC_OK);
+
+    auto buffer = bufferPool->AcquireBuffer(std::chrono::microseconds(0));
+    EXPECT_EQ(true, buffer != nullptr);
+
+    auto begin = std::chrono::steady_clock::now();
+    auto nullBuffer = bufferPool->AcquireBuffer(std::chrono::milliseconds(10)); // 10:less than one frame interval
+    auto end = std::chrono::steady_clock::now();
+    auto timeElapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - begin);
+    std::cout << "timeElapsed = " << timeElapsed.count() << std::endl;
+    EXPECT_EQ(true, nullBuffer == nullptr);
+    EXPECT_EQ(true,
+              timeElapsed >= std::chrono::microseconds(10000) && timeElapsed < std::chrono::microseconds(FRAME_INTERVAL_US));
+
+    std::thread task([&bufferPool, &buffer] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5)); // 5:return before acquire timeout
+        bufferPool->ReturnBuffer(buffer);
+    });
+    auto lastBuffer = bufferPool->AcquireBuffer(std::chrono::microseconds(FRAME_INTERVAL_US));
+    task.join();
+    EXPECT_EQ(true, lastBuffer != nullptr);
+    EXPECT_EQ(true, bufferPool->ReturnBuffer(lastBuffer) == RC_OK);
+    EXPECT_EQ(true, bufferPool->ReturnBuffer(lastBuffer) != RC_OK);
+}
+
+HWTEST_F(BufferManagerTest, TestBufferPoolAcquireReturnCost, TestSize.Level1)
+{
+    Camera::BufferManager* manager = Camera::BufferManager::GetInstance();
+    EXPECT_EQ(true, manager != nullptr);
+
+    const uint32_t poolSizes[] = {8, 32, 128};
+    const uint32_t totalCycles = 1000000;
+    for (auto count : poolSizes) {
+        int64_t bufferPoolId = manager->GenerateBufferPoolId();
+        std::shared_ptr<IBufferPool> bufferPool = manager->GetBufferPool(bufferPoolId);
+        EXPECT_EQ(true, bufferPool != nullptr);
+        RetCode rc = bufferPool->Init(2, 1, CAMERA_USAGE_SW_WRITE_OFTEN, CAMERA_FORMAT_YCBCR_422_P, count,
+                                      CAMERA_BUFFER_SOURCE_TYPE_HEAP);
+        EXPECT_EQ(true, rc == RC_OK);
+
+        std::vector<std::shared_ptr<IBuffer>> bufferVector;
+        bufferVector.reserve(count);
+        uint32_t rounds = totalCycles / count;
+        auto begin = std::chrono::steady_clock::now();
+        for (uint32_t r = 0; r < rounds; r++) {
+            for (uint32_t i = 0; i < count; i++) {
+                bufferVector.emplace_back(bufferPool->AcquireBuffer());
+            }
+            // return the oldest buffer first, which is the worst case of a list based busy queue.
+            for (auto& it : bufferVector) {
+                bufferPool->ReturnBuffer(it);
+            }
+            bufferVector.clear();
+        }
+        auto end = std::chrono::steady_clock::now();
+        auto timeElapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin);
+        std::cout << "pool size " << count << ", acquire + return cost = "
+                  << timeElapsed.count() / (rounds * count) << " ns" << std::endl;
+        EXPECT_EQ(true, bufferPool->GetIdleBufferCount() == count);
+    }
+}
+
+HWTEST_F(BufferManagerTest, TestBatchAllocBuffers, TestSize.Level0)
+{
+    std::vector<std::shared_ptr<IBuffer>> buffers;
+    RetCode rc = BufferAllocatorUtils::AllocBuffers(CAMERA_BUFFER_SOURCE_TYPE_HEAP, 4, 640, 480,
+        CAMERA_USAGE_SW_WRITE_OFTEN, CAMERA_FORMAT_YCRCB_420_SP, buffers);
+    EXPECT_EQ(true, rc == RC_OK);
+    EXPECT_EQ(true, buffers.size() == 4);
+    for (auto& it : buffers) {
+        EXPECT_EQ(true, it->GetVirAddress() != nullptr);
+    }
+    // the allocator of a source is resolved once and shared.
+    EXPECT_EQ(true, BufferAllocatorUtils::GetAllocator(buffers[0]) ==
+        BufferAllocatorUtils::GetAllocator(buffers[1]));
+    EXPECT_EQ(true, BufferAllocatorUtils::FreeBuffers(buffers) == RC_OK);
+    for (auto& it : buffers) {
+        EXPECT_EQ(true, it->GetVirAddress() == nullptr);
+    }
+    EXPECT_EQ(true, BufferAllocatorUtils::AllocBuffers(CAMERA_BUFFER_SOURCE_TYPE_EXTERNAL, 1, 640, 480,
+        CAMERA_USAGE_SW_WRITE_OFTEN, CAMERA_FORMAT_YCRCB_420_SP, buffers) != RC_OK);
+}
+
+HWTEST_F(BufferManagerTest, TestPrepare4kPoolCost, TestSize.Level1)
+{
+    Camera::BufferManager* manager = Camera::BufferManager::GetInstance();
+    EXPECT_EQ(true, manager != nullptr);
+
+    // stream reconfiguration tears down and re-creates the pools.
+    const uint32_t loops = 10;
+    int64_t totalUs = 0;
+    for (uint32_t i = 0; i < loops; i++) {
+        int64_t bufferPoolId = manager->GenerateBufferPoolId();
+        std::shared_ptr<IBufferPool> bufferPool = manager->GetBufferPool(bufferPoolId);
+        EXPECT_EQ(true, bufferPool != nullptr);
+        auto begin = std::chrono::steady_clock::now();
+        RetCode rc = bufferPool->Init(3840, 2160, CAMERA_USAGE_SW_WRITE_OFTEN, CAMERA_FORMAT_YCRCB_420_SP, 16,
+                                      CAMERA_BUFFER_SOURCE_TYPE_HEAP);
+        auto end = std::chrono::steady_clock::now();
+        EXPECT_EQ(true, rc == RC_OK);
+        totalUs += std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+    }
+    std::cout << "prepare 16 x 4K buffers cost = " << totalUs / loops << " us" << std::endl;
+}
+
+HWTEST_F(BufferManagerTest, TestElasticBufferPool, TestSize.Level0)
+{
+    Camera::BufferManager* manager = Camera::BufferManager::GetInstance();
+    EXPECT_EQ(true, manager != nullptr);
+    int64_t bufferPoolId = manager->GenerateBufferPoolId();
+    EXPECT_EQ(true, bufferPoolId != 0);
+    std::shared_ptr<IBufferPool> bufferPool = manager->GetBufferPool(bufferPoolId);
+    EXPECT_EQ(true, bufferPool != nullptr);
+
+    const uint32_t count = 4;
+    const uint32_t maxCount = 8;
+    const uint32_t lowWatermark = 2;
+    EXPECT_EQ(true, bufferPool->SetElasticPolicy(maxCount, lowWatermark) == RC_OK);
+    RetCode rc = bufferPool->Init(1280, 720, CAMERA_USAGE_SW_WRITE_OFTEN, CAMERA_FORMAT_YCBCR_422_P, count,
+                                  CAMERA_BUFFER_SOURCE_TYPE_HEAP);
+    EXPECT_EQ(true, rc == RC_OK);
+    EXPECT_EQ(true, bufferPool->GetStatistics().allocatedCount == 0);
+
+    // buffers are allocated on demand up to max count, even without waiting.
+    std::vector<std::shared_ptr<IBuffer>> bufferVector;
+    for (uint32_t i = 0; i < maxCount; i++) {
+        auto buffer = bufferPool->AcquireBuffer();
+        EXPECT_EQ(true, buffer != nullptr);
+        bufferVector.emplace_back(buffer);
+    }
+    EXPECT_EQ(true, bufferPool->AcquireBuffer() == nullptr);
+    EXPECT_EQ(true, bufferPool->AcquireBuffer(std::chrono::milliseconds(1)) == nullptr);
+    BufferPoolStatistics statistics = bufferPool->GetStatistics();
+    EXPECT_EQ(true, statistics.allocatedCount == maxCount);
+    EXPECT_EQ(true, statistics.peakInUseCount == maxCount);
+
+    // buffers in use are never trimmed.
+    bufferPool->TrimBuffers();
+    EXPECT_EQ(true, bufferPool->GetStatistics().trimmedCount == 0);
+
+    for (auto& it : bufferVector) {
+        EXPECT_EQ(true, bufferPool->ReturnBuffer(it) == RC_OK);
+    }
+    bufferVector.clear();
+
+    // the first trimming keeps buffers used since last trimming, the second one trims down to low watermark.
+    bufferPool->TrimBuffers();
+    bufferPool->TrimBuffers();
+    statistics = bufferPool->GetStatistics();
+    EXPECT_EQ(true, statistics.allocatedCount == lowWatermark);
+    EXPECT_EQ(true, statistics.trimmedCount == maxCount - lowWatermark);
+    EXPECT_EQ(true, statistics.peakInUseCount == maxCount);
+    EXPECT_EQ(true, bufferPool->GetIdleBufferCount() == lowWatermark);
+
+    // trimmed slots are reused when pool grows again.
+    for (uint32_t i = 0; i < count; i++) {
+        auto buffer = bufferPool->AcquireBuffer();
+        EXPECT_EQ(true, buffer != nullptr);
+        EXPECT_EQ(true, buffer->GetIndex() >= 0 && buffer->GetIndex() < static_cast<int32_t>(maxCount));
+        bufferVector.emplace_back(buffer);
+    }
+    EXPECT_EQ(true, bufferPool->GetStatistics().allocatedCount == count);
+    for (auto& it : bufferVector) {
+        EXPECT_EQ(true, bufferPool->ReturnBuffer(it) == RC_OK);
+    }
+}
+
+HWTEST_F(BufferManagerTest, TestInvalidElasticPolicy, TestSize.Level0)
+{
+    Camera::BufferManager* manager = Camera::BufferManager::GetInstance();
+    EXPECT_EQ(true, manager != nullptr);
+    int64_t bufferPoolId = manager->GenerateBufferPoolId();
+    EXPECT_EQ(true, bufferPoolId != 0);
+    std::shared_ptr<IBufferPool> bufferPool = manager->GetBufferPool(bufferPoolId);
+    EXPECT_EQ(true, bufferPool != nullptr);
+
+    EXPECT_EQ(true, bufferPool->SetElasticPolicy(0, 0) == RC_ERROR);
+    EXPECT_EQ(true, bufferPool->SetElasticPolicy(2, 4) == RC_ERROR);
+    EXPECT_EQ(true, bufferPool->SetElasticPolicy(2, 1) == RC_OK);
+    // max count must not be less than count of Init.
+    RetCode rc = bufferPool->Init(1280, 720, CAMERA_USAGE_SW_WRITE_OFTEN, CAMERA_FORMAT_YCBCR_422_P, 4,
+                                  CAMERA_BUFFER_SOURCE_TYPE_HEAP);
+    EXPECT_EQ(true, rc == RC_ERROR);
+}
+
+HWTEST_F(BufferManagerTest, TestShareBuffer, TestSize.Level0)
+{
+    Camera::BufferManager* manager = Camera::BufferManager::GetInstance();
+    EXPECT_EQ(true, manager != nullptr);
+    int64_t bufferPoolId = manager->GenerateBufferPoolId();
+    EXPECT_EQ(true, bufferPoolId != 0);
+    std::shared_ptr<IBufferPool> bufferPool = manager->GetBufferPool(bufferPoolId);
+    EXPECT_EQ(true, bufferPool != nullptr);
+    RetCode rc = bufferPool->Init(1280, 720, CAMERA_USAGE_SW_WRITE_OFTEN, CAMERA_FORMAT_YCBCR_420_SP, 1,
+                                  CAMERA_BUFFER_SOURCE_TYPE_HEAP);
+    EXPECT_EQ(true, rc == RC_OK);
+
+    auto buffer = bufferPool->AcquireBuffer();
+    EXPECT_EQ(true, buffer != nullptr);
+    buffer->SetFrameNumber(10); // 10:frame number of test
+    auto view1 = bufferPool->ShareBuffer(buffer);
+    auto view2 = bufferPool->ShareBuffer(view1);
+    EXPECT_EQ(true, view1 != nullptr && view2 != nullptr);
+    EXPECT_EQ(true, view1->GetVirAddress() == buffer->GetVirAddress());
+    EXPECT_EQ(true, view2->GetSize() == buffer->GetSize());
+    EXPECT_EQ(true, view1->GetFrameNumber() == buffer->GetFrameNumber());
+    EXPECT_EQ(true, view1->GetPoolId() == bufferPoolId);
+
+    // meta data of a view doesn't affect the buffer.
+    view1->SetStreamId(1);
+    buffer->SetStreamId(0);
+    EXPECT_EQ(true, view1->GetStreamId() == 1);
+
+    // buffer becomes idle only after the last holder returns it.
+    EXPECT_EQ(true, bufferPool->ReturnBuffer(buffer) == RC_OK);
+    EXPECT_EQ(true, bufferPool->ReturnBuffer(buffer) != RC_OK);
+    EXPECT_EQ(true, bufferPool->GetIdleBufferCount() == 0);
+    EXPECT_EQ(true, bufferPool->ReturnBuffer(view1) == RC_OK);
+    EXPECT_EQ(true, bufferPool->ReturnBuffer(view1) != RC_OK);
+    EXPECT_EQ(true, bufferPool->GetIdleBufferCount() == 0);
+    EXPECT_EQ(true, bufferPool->ReturnBuffer(view2) == RC_OK);
+    EXPECT_EQ(true, bufferPool->GetIdleBufferCount() == 1);
+
+    // idle buffer can't be shared.
+    EXPECT_EQ(true, bufferPool->ShareBuffer(buffer) == nullptr);
+
+    // a view dropped without return doesn't keep the buffer busy.
+    buffer = bufferPool->AcquireBuffer();
+    EXPECT_EQ(true, buffer != nullptr);
+    view1 = bufferPool->ShareBuffer(buffer);
+    EXPECT_EQ(true, view1 != nullptr);
+    view1 = nullptr;
+    EXPECT_EQ(true, bufferPool->ReturnBuffer(buffer) == RC_OK);
+    EXPECT_EQ(true, bufferPool->GetIdleBufferCount() == 1);
+}
+
 HWTEST_F(BufferManagerTest, TestExternalBufferLoop, TestSize.Level0)
 {
     Camera::BufferManager* manager = Camera::BufferManager::GetInstance();
@@ -346,6 +638,9 @@ HWTEST_F(BufferManagerTest, TestTrackingBufferLoop, TestSize.Level0)
     int32_t emptyCheck2 = BufferTracking::IsNodeEmpty(0, "SourceNode", "SinkNode");
     BufferTraceGraph graph{};
     BufferTracking::DumpBufferTrace(0, graph);
+    BufferLatency latency = {};
+    RetCode latencyRet = BufferTracking::GetBufferLatency(0, latency);
+    BufferTracking::DumpBufferLatency(0, "/data/buffer_latency.txt");
     running = false;
     enqueueThread.join();
     pipeline.StopStream();
@@ -357,6 +652,17 @@ HWTEST_F(BufferManagerTest, TestTrackingBufferLoop, TestSize.Level0)
     EXPECT_EQ(true, graph.front().second.size() == 3);
     EXPECT_EQ(true, graph.back().first == "SinkNode");
     EXPECT_EQ(true, graph.back().second.size() < 2);
+    EXPECT_EQ(true, latencyRet == RC_OK);
+    // each node holds a buffer for 5ms at least.
+    EXPECT_EQ(true, latency.nodes["node1"].count > 0);
+    EXPECT_EQ(true, latency.nodes["node1"].p50 >= 5000); // 5000: microseconds
+    EXPECT_EQ(true, latency.nodes["node1"].p50 <= latency.nodes["node1"].p99);
+    EXPECT_EQ(true, latency.nodes["node1"].p99 <= latency.nodes["node1"].max);
+    EXPECT_EQ(true, latency.endToEnd.count > 0);
+    EXPECT_EQ(true, latency.endToEnd.p50 > latency.nodes["node1"].p50);
+    for (auto& [name, statistics] : latency.nodes) {
+        std::cout << "node [" << name << "] p50 " << statistics.p50 << "us, p99 " << statistics.p99 << "us" << std::endl;
+    }
     for (auto it = graph.begin(); it != graph.end(); it++) {
         std::cout << "node [" << it->first << "] has buffer {";
         for (auto& b : it->second) {
@@ -366,6 +672,42 @@ HWTEST_F(BufferManagerTest, TestTrackingBufferLoop, TestSize.Level0)
     }
 }
 
+HWTEST_F(BufferManagerTest, TestTrackingReportCost, TestSize.Level1)
+{
+    // the cost of a report shouldn't grow with the depth of the pipeline or the number of frames in flight.
+    const uint32_t depths[] = {4, 16, 64};
+    const uint32_t frameCount = 10000;
+    const int32_t trackingId = 1;
+    BufferTracking::StartTracking();
+    for (auto depth : depths) {
+        BufferTracking::AddTrackingStreamBegin(trackingId, -1);
+        for (uint32_t n = 0; n < depth; n++) {
+            BufferTracking::AddTrackingNode(trackingId, "node" + std::to_string(n));
+        }
+        BufferTracking::AddTrackingStreamEnd(trackingId);
+
+        auto begin = std::chrono::steady_clock::now();
+        for (uint64_t f = 0; f < frameCount; f++) {
+            for (uint32_t n = 0; n < depth; n++) {
+                PIPELINE_REPORT_BUFFER_LOCATION(trackingId, f, "node" + std::to_string(n));
+            }
+            POOL_REPORT_BUFFER_LOCATION(trackingId, f);
+        }
+        auto end = std::chrono::steady_clock::now();
+        auto timeElapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin);
+        std::cout << "pipeline depth " << depth << ", report cost = "
+                  << timeElapsed.count() / (frameCount * (depth + 1)) << " ns" << std::endl;
+
+        BufferLatency latency = {};
+        EXPECT_EQ(true, BufferTracking::GetBufferLatency(trackingId, latency) == RC_OK);
+        EXPECT_EQ(true, latency.endToEnd.count == frameCount);
+        EXPECT_EQ(true, BufferTracking::IsNodeEmpty(trackingId, "node0", "node" + std::to_string(depth - 1)) ==
+            NODE_IS_EMPTY);
+        BufferTracking::DeleteTrackingStream(trackingId);
+    }
+    BufferTracking::StopTracking();
+}
+
 namespace OHOS::CameraUtest {
 bool BufferManagerTest::Stream::Init(sptr<IBufferProducer>& producer)
 {
@@ -18,7 +18,7 @@
 
 #include "camera.h"
 #include "types.h"
-#include <condition_variable>
+#include <atomic>
 #include <list>
 #include <thread>
 #include <unordered_map>
@@ -135,20 +135,30 @@ public:
     CaptureMessageOperator& operator=(const CaptureMessageOperator& other) = delete;
     CaptureMessageOperator& operator=(CaptureMessageOperator&& other) = delete;
 
+    // lock-free, can be called by any number of producers.
     void SendMessage(std::shared_ptr<ICaptureMessage>& message);
     RetCode StartProcess();
 
 private:
+    struct MessageNode {
+        std::shared_ptr<ICaptureMessage> message;
+        MessageNode* next;
+    };
+
     void HandleMessage();
+    void CollectMessages(MessageNode* nodes);
+    void DeliverMessages();
 
 private:
     MessageOperatorFunc messageOperator_ = nullptr;
     std::atomic<bool> running_ = false;
-    std::atomic<bool> wakeup_ = false;
     std::unique_ptr<std::thread> messageHandler_ = nullptr;
-    std::mutex lock_ = {};
-    std::condition_variable cv_ = {};
+    int eventFd_ = -1;
+    // producers push onto this stack, the handler takes all of them at once.
+    std::atomic<MessageNode*> incoming_ = nullptr;
+    // only accessed by the handler thread.
     std::unordered_map<uint32_t, std::list<MessageGroup>> messageBox_ = {};
+    std::list<MessageGroup> readyMessages_ = {};
 };
 } // namespace OHOS::Camera
 #endif
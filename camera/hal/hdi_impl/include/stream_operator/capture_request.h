@@ -49,6 +49,9 @@ public:
     void SetFirstRequest(bool b);
     bool IsFirstOne() const;
     CaptureMeta GetCaptureSetting() const;
+    // number of frames which one Process of this request captures.
+    void SetBatchCount(uint32_t n);
+    uint32_t GetBatchCount() const;
 
 private:
     class RequestSemaphore final {
@@ -82,6 +85,7 @@ private:
     std::atomic<bool> needCancel_ = false;
     uint32_t ownerCount_ = 0;
     bool isFirstRequest_ = false;
+    uint32_t batchCount_ = 1;
 };
 } // namespace OHOS::Camera
 
@@ -19,6 +19,7 @@
 #include "ibuffer.h"
 #include "ibuffer_pool.h"
 #include "istream.h"
+#include <unordered_map>
 
 namespace OHOS::Camera {
 class StreamBase : public IStream, public std::enable_shared_from_this<StreamBase> {
@@ -57,6 +58,7 @@ public:
     virtual RetCode DeliverBuffer();
     virtual RetCode ReceiveBuffer(std::shared_ptr<IBuffer>& buffer);
     virtual uint64_t GetFrameCount() const;
+    TunnelStatistics GetTunnelStatistics() const;
 
     enum StreamState {
         STREAM_STATE_IDLE = 0,
@@ -65,6 +67,9 @@ public:
         STREAM_STATE_OFFLINE,
     };
 
+protected:
+    void AdjustBufferCount();
+
 protected:
     int32_t streamId_ = -1;
     int32_t streamType_ = -1;
@@ -79,16 +84,30 @@ protected:
     std::shared_ptr<StreamTunnel> tunnel_ = nullptr;
     std::shared_ptr<IBufferPool> bufferPool_ = nullptr;
     uint64_t poolId_ = 0;
+    // adaptive depth of buffer queue, decided by the waits for free buffers in the tunnel.
+    bool adaptiveBufferCount_ = false;
+    std::atomic<uint32_t> adjustFrames_ = 0;
+    std::atomic<uint64_t> lastWaitCount_ = 0;
 
     std::mutex wtLock_ = {};
     std::list<std::shared_ptr<CaptureRequest>> waitingList_ = {};
     std::condition_variable cv_ = {};
 
+    // requests in pipeline by capture id, with the number of their frames not returned yet.
+    struct InTransitRequest {
+        std::shared_ptr<CaptureRequest> request;
+        uint32_t frames;
+    };
     std::mutex tsLock_ = {};
-    std::list<std::shared_ptr<CaptureRequest>> inTransitList_ = {};
+    std::unordered_map<int32_t, InTransitRequest> inTransitList_ = {};
 
     std::unique_ptr<std::thread> handler_ = nullptr;
     std::shared_ptr<CaptureRequest> lastRequest_ = nullptr;
+    // hash of the settings the pipeline is configured with, repeating requests don't config it again.
+    // device settings updated in between override them, so the metadata version they are applied at is kept too.
+    bool settingsApplied_ = false;
+    uint64_t settingsHash_ = 0;
+    uint64_t settingsVersion_ = 0;
 };
 } // end namespace OHOS::Camera
 #endif // STREAM_OPERATOR_STREAM_BASE_H
@@ -69,6 +69,7 @@ private:
     void OnCaptureError(int32_t captureId, const std::vector<std::shared_ptr<CaptureErrorInfo>>& infos);
     void OnFrameShutter(int32_t captureId, const std::vector<int32_t>& streamIds, uint64_t timestamp);
     bool CheckStreamInfo(const std::shared_ptr<StreamInfo>& streamInfo);
+    void DumpState();
     DynamicStreamSwitchMode CheckStreamsSupported(OperationMode mode,
                                                   const std::shared_ptr<CameraStandard::CameraMetadata>& modeSetting,
                                                   const std::vector<std::shared_ptr<StreamInfo>>& infos);
@@ -87,6 +88,7 @@ private:
     std::unordered_map<int32_t, std::shared_ptr<CaptureRequest>> requestMap_ = {};
     OHOS::sptr<OfflineStreamOperator> oflstor_ = nullptr;
     std::function<void()> requestTimeoutCB_ = nullptr;
+    uint32_t dumperId_ = 0;
 };
 } // end namespace OHOS::Camera
 #endif // STREAM_OPERATOR_STREAM_OPERATOR_H
@@ -21,6 +21,7 @@
 #include "surface.h"
 #include "surface_type.h"
 #include <mutex>
+#include <string>
 #include <unordered_map>
 
 namespace OHOS::Camera {
@@ -31,6 +32,14 @@ struct TunnelConfig {
     uint64_t usage;
 };
 
+// buffer queue usage, the counters are accumulated from the creation of the tunnel.
+struct TunnelStatistics {
+    uint64_t requestCount;
+    uint64_t waitCount;
+    uint64_t waitTimeUs;
+    uint32_t maxInUse;
+};
+
 class StreamTunnel {
 public:
     virtual RetCode AttachBufferQueue(OHOS::sptr<OHOS::IBufferProducer>& producer);
@@ -44,6 +53,9 @@ public:
     virtual void NotifyStart();
     virtual void NotifyStop();
     virtual void CleanBuffers();
+    virtual TunnelStatistics GetStatistics() const;
+    // start a new period for the peak number of buffers held by the camera.
+    virtual void ResetMaxInUse();
 
     StreamTunnel() = default;
     virtual ~StreamTunnel();
@@ -59,12 +71,23 @@ protected:
     OHOS::BufferRequestConfig requestConfig_ = {0, 0, 0, 0, 0, 0};
     OHOS::BufferFlushConfig flushConfig_ = {{0, 0, 0, 0}, 0};
     std::unordered_map<std::shared_ptr<IBuffer>, OHOS::sptr<OHOS::SurfaceBuffer>> buffers = {};
+    // reverse index of buffers, the surface buffers are kept alive by the map above.
+    std::unordered_map<OHOS::SurfaceBuffer*, std::shared_ptr<IBuffer>> surfaceBuffers_ = {};
+    // keys of the es frame info, built once instead of for every frame.
+    const std::string dataSizeKey_ = "dataSize";
+    const std::string isKeyFrameKey_ = "isKeyFrame";
+    const std::string timeStampKey_ = "timeStamp";
+    const std::string frameNumKey_ = "frameNum";
     std::mutex lock_ = {};
     std::mutex waitLock_ = {};
     std::condition_variable waitCV_ = {};
     std::atomic<bool> wakeup_ = false;
     std::atomic<bool> stop_ = false;
     std::atomic<uint32_t> restBuffers = 0;
+    std::atomic<uint64_t> requestCount_ = 0;
+    std::atomic<uint64_t> waitCount_ = 0;
+    std::atomic<uint64_t> waitTimeUs_ = 0;
+    std::atomic<uint32_t> maxInUse_ = 0;
     std::mutex finishLock_ = {};
     std::condition_variable finishCV_ = {};
 };
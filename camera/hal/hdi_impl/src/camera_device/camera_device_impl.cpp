@@ -397,6 +397,11 @@ void CameraDeviceImpl::GetCameraId(std::string &cameraId) const
 void CameraDeviceImpl::OnRequestTimeout()
 {
     CAMERA_LOGD("OnRequestTimeout callback success.");
+    // called by watchdogs, the request may time out before a callback is set.
+    if (cameraDeciceCallback_ == nullptr) {
+        CAMERA_LOGE("camera device callback is null.");
+        return;
+    }
     // request error
     cameraDeciceCallback_->OnError(REQUEST_TIMEOUT, 0);
 }
@@ -417,6 +422,10 @@ void CameraDeviceImpl::OnMetadataChanged(const std::shared_ptr<CameraStandard::C
 void CameraDeviceImpl::OnDevStatusErr()
 {
     CAMERA_LOGD("OnDevStatusErr callback success.");
+    if (cameraDeciceCallback_ == nullptr) {
+        CAMERA_LOGE("camera device callback is null.");
+        return;
+    }
     // device error
     cameraDeciceCallback_->OnError(FATAL_ERROR, 0);
 }
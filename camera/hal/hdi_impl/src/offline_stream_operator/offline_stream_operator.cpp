@@ -33,7 +33,7 @@ CamRetCode OfflineStreamOperator::CancelCapture(int captureId)
 {
     CHECK_IF_EQUAL_RETURN_VALUE(captureId < 0, true, INVALID_ARGUMENT);
 
-    PLACE_A_SELFKILL_WATCHDOG;
+    PLACE_A_DUMP_WATCHDOG(nullptr);
     DFX_LOCAL_HITRACE_BEGIN;
 
     std::shared_ptr<OfflineStream> stream = FindStreamByCaptureId(captureId);
@@ -53,7 +53,7 @@ CamRetCode OfflineStreamOperator::CancelCapture(int captureId)
 
 CamRetCode OfflineStreamOperator::ReleaseStreams(const std::vector<int>& streamIds)
 {
-    PLACE_A_SELFKILL_WATCHDOG;
+    PLACE_A_DUMP_WATCHDOG(nullptr);
     DFX_LOCAL_HITRACE_BEGIN;
 
     for (auto it : streamIds) {
@@ -74,7 +74,7 @@ CamRetCode OfflineStreamOperator::ReleaseStreams(const std::vector<int>& streamI
 
 CamRetCode OfflineStreamOperator::Release()
 {
-    PLACE_A_SELFKILL_WATCHDOG;
+    PLACE_A_DUMP_WATCHDOG(nullptr);
     DFX_LOCAL_HITRACE_BEGIN;
 
     {
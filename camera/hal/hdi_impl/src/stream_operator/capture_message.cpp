@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 #include "capture_message.h"
+#include <sys/eventfd.h>
 
 namespace OHOS::Camera {
 ICaptureMessage::ICaptureMessage(int32_t streamId, int32_t captureId, uint64_t time, uint32_t count)
@@ -56,11 +57,23 @@ CaptureMessageOperator::CaptureMessageOperator(MessageOperatorFunc f)
 CaptureMessageOperator::~CaptureMessageOperator()
 {
     running_ = false;
-    cv_.notify_one();
+    if (eventFd_ >= 0) {
+        uint64_t one = 1;
+        write(eventFd_, &one, sizeof(one));
+    }
     if (messageHandler_ != nullptr) {
         messageHandler_->join();
     }
+    if (eventFd_ >= 0) {
+        close(eventFd_);
+    }
+    for (MessageNode* node = incoming_.exchange(nullptr); node != nullptr;) {
+        MessageNode* next = node->next;
+        delete node;
+        node = next;
+    }
     messageBox_.clear();
+    readyMessages_.clear();
 }
 
 void CaptureMessageOperator::SendMessage(std::shared_ptr<ICaptureMessage>& message)
@@ -69,53 +82,33 @@ void CaptureMessageOperator::SendMessage(std::shared_ptr<ICaptureMessage>& messa
         return;
     }
 
-    CAMERA_LOGV("%{public}s, %{public}d, enter", __FUNCTION__, __LINE__);
-    std::unique_lock<std::mutex> l(lock_);
-    CAMERA_LOGV("%{public}s, %{public}d, enter", __FUNCTION__, __LINE__);
-    auto it = messageBox_.find(message->GetMessageType());
-    if (it == messageBox_.end()) {
-        messageBox_[message->GetMessageType()] = {{message}};
-        if (message->GetPeerMessageCount() == 1) {
-            wakeup_ = true;
-            cv_.notify_one();
-        }
-    } else {
-        bool isPeerMessage = false;
-        for (auto& mit : it->second) {
-            if (mit.empty()) {
-                continue;
-            }
-            if (mit[0] == nullptr) {
-                CAMERA_LOGE("unknown error, message is null");
-                continue;
-            }
-            if (message->GetTimestamp() == mit[0]->GetTimestamp() &&
-                message->GetMessageType() == mit[0]->GetMessageType()) {
-                mit.emplace_back(message);
-                if (mit.size() == mit[0]->GetPeerMessageCount()) {
-                    wakeup_ = true;
-                    cv_.notify_one();
-                }
-                isPeerMessage = true;
-                break;
-            }
-        }
-        if (!isPeerMessage) {
-            MessageGroup mg = {message};
-            it->second.emplace_back(mg);
-            if (message->GetPeerMessageCount() == 1) {
-                wakeup_ = true;
-                cv_.notify_one();
-            }
-        }
+    MessageNode* node = new (std::nothrow) MessageNode {message, nullptr};
+    if (node == nullptr) {
+        CAMERA_LOGE("alloc message node failed, message type %{public}d dropped", message->GetMessageType());
+        return;
+    }
+    MessageNode* head = incoming_.load(std::memory_order_relaxed);
+    do {
+        node->next = head;
+    } while (!incoming_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+
+    // only the message which finds the stack empty wakes up the handler, it takes the later ones together.
+    if (head == nullptr && eventFd_ >= 0) {
+        uint64_t one = 1;
+        write(eventFd_, &one, sizeof(one));
     }
-    CAMERA_LOGV("%{public}s, %{public}d, enter", __FUNCTION__, __LINE__);
-
     return;
 }
 
 RetCode CaptureMessageOperator::StartProcess()
 {
+    if (eventFd_ < 0) {
+        eventFd_ = eventfd(0, EFD_CLOEXEC);
+        if (eventFd_ < 0) {
+            CAMERA_LOGE("create eventfd failed");
+            return RC_ERROR;
+        }
+    }
     running_ = true;
     messageHandler_ = std::make_unique<std::thread>([this]() {
         prctl(PR_SET_NAME, "MessageOperator");
@@ -131,41 +124,81 @@ RetCode CaptureMessageOperator::StartProcess()
 
 void CaptureMessageOperator::HandleMessage()
 {
-    {
-        std::unique_lock<std::mutex> l(lock_);
-        cv_.wait(l, [this] { return !running_ || wakeup_; });
-        wakeup_ = false;
+    uint64_t count = 0;
+    if (incoming_.load(std::memory_order_acquire) == nullptr &&
+        read(eventFd_, &count, sizeof(count)) != sizeof(count)) {
+        return;
     }
 
     if (!running_) {
         return;
     }
 
-    std::list<MessageGroup> messages = {};
-    {
-        CAMERA_LOGV("%{public}s, %{public}d, enter", __FUNCTION__, __LINE__);
-        std::unique_lock<std::mutex> l(lock_);
-        for (auto& lit : messageBox_) {
-            for (auto& vit : lit.second) {
-                if (vit.empty()) {
-                    continue;
-                }
-
-                if (vit.size() == vit[0]->GetPeerMessageCount()) {
-                    messages.emplace_back(vit);
-                    vit.clear();
-                }
+    MessageNode* nodes = incoming_.exchange(nullptr, std::memory_order_acquire);
+    if (nodes == nullptr) {
+        return;
+    }
+    CollectMessages(nodes);
+    DeliverMessages();
+    return;
+}
+
+void CaptureMessageOperator::CollectMessages(MessageNode* nodes)
+{
+    // the stack is in reverse order of sending.
+    MessageNode* ordered = nullptr;
+    while (nodes != nullptr) {
+        MessageNode* next = nodes->next;
+        nodes->next = ordered;
+        ordered = nodes;
+        nodes = next;
+    }
+
+    while (ordered != nullptr) {
+        std::shared_ptr<ICaptureMessage> message = ordered->message;
+        MessageNode* next = ordered->next;
+        delete ordered;
+        ordered = next;
+
+        // peer messages of multiple streams are grouped by timestamp, a group is ready when all peers arrive.
+        std::list<MessageGroup>& groups = messageBox_[message->GetMessageType()];
+        auto it = groups.begin();
+        for (; it != groups.end(); it++) {
+            if (!it->empty() && (*it)[0]->GetTimestamp() == message->GetTimestamp()) {
+                break;
             }
-            for (auto it = lit.second.begin(); it != lit.second.end();) {
-                if (it->empty()) {
-                    it = lit.second.erase(it);
-                    continue;
-                }
-                it++;
+        }
+        if (it == groups.end()) {
+            it = groups.emplace(groups.end(), MessageGroup {});
+        }
+        it->emplace_back(message);
+        if (it->size() >= (*it)[0]->GetPeerMessageCount()) {
+            readyMessages_.emplace_back(std::move(*it));
+            groups.erase(it);
+        }
+    }
+}
+
+void CaptureMessageOperator::DeliverMessages()
+{
+    // ready groups of one capture with the same type and timestamp are delivered in one callback.
+    std::list<MessageGroup> messages = {};
+    for (auto& group : readyMessages_) {
+        auto it = messages.begin();
+        for (; it != messages.end(); it++) {
+            if ((*it)[0]->GetMessageType() == group[0]->GetMessageType() &&
+                (*it)[0]->GetCaptureId() == group[0]->GetCaptureId() &&
+                (*it)[0]->GetTimestamp() == group[0]->GetTimestamp()) {
+                it->insert(it->end(), group.begin(), group.end());
+                break;
             }
         }
-        CAMERA_LOGV("%{public}s, %{public}d, enter", __FUNCTION__, __LINE__);
+        if (it == messages.end()) {
+            messages.emplace_back(std::move(group));
+        }
     }
+    readyMessages_.clear();
+
     for (auto it = messages.begin(); it != messages.end();) {
         messageOperator_(*it);
         it = messages.erase(it);
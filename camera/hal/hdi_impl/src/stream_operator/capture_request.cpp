@@ -151,6 +151,16 @@ CaptureMeta CaptureRequest::GetCaptureSetting() const
     return settings_.lock();
 }
 
+void CaptureRequest::SetBatchCount(uint32_t n)
+{
+    batchCount_ = n == 0 ? 1 : n;
+}
+
+uint32_t CaptureRequest::GetBatchCount() const
+{
+    return batchCount_;
+}
+
 CaptureRequest::RequestSemaphore::RequestSemaphore(const int32_t n)
 {
     ownerCount_ = n;
@@ -19,6 +19,50 @@
 #include "watchdog.h"
 
 namespace OHOS::Camera {
+namespace {
+    constexpr uint32_t DEFAULT_BUFFER_COUNT = 3;
+    constexpr uint32_t MIN_BUFFER_COUNT = 2;
+    constexpr uint32_t MAX_BUFFER_COUNT = 8;
+    struct BufferCountSetting {
+        uint32_t bufferCount;
+        uint32_t maxBufferCount; // pools inside the pipeline grow up to it on demand, 0 keeps them fixed
+    };
+    // video needs more buffers at high frame rate, analysis streams are low rate and keep less.
+    const std::map<int32_t, BufferCountSetting> BUFFER_COUNT_SETTINGS = {
+        {PREVIEW, {3, 0}},
+        {VIDEO, {4, MAX_BUFFER_COUNT}},
+        {STILL_CAPTURE, {3, 0}},
+        {POST_VIEW, {3, 0}},
+        {ANALYZE, {2, 0}},
+        {CUSTOM, {3, 0}},
+    };
+    // number of returned buffers between two adjustments of the adaptive depth.
+    constexpr uint32_t ADJUST_FRAME_INTERVAL = 30;
+    // frames which one capture request may cover, they share settings and are submitted together.
+    constexpr int32_t MAX_BATCH_CAPTURE_COUNT = 8;
+    // high speed video (min frame duration in us) is batched to keep requests at about 30 per second.
+    constexpr int32_t HIGH_SPEED_FRAME_DURATION = 1000000 / 120;
+    constexpr int32_t BATCH_REQUEST_DURATION = 1000000 / 30;
+    // 64 bit FNV-1a
+    constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+    // settings are one continuous blob of header, items and data, hash all of it.
+    uint64_t GetSettingsHash(const CaptureMeta& settings)
+    {
+        uint64_t hash = FNV_OFFSET_BASIS;
+        common_metadata_header_t* data = settings == nullptr ? nullptr : settings->get();
+        if (data == nullptr) {
+            return hash;
+        }
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        for (uint32_t i = 0; i < data->size; i++) {
+            hash = (hash ^ bytes[i]) * FNV_PRIME;
+        }
+        return hash;
+    }
+}
+
 std::map<StreamIntent, std::string> IStream::g_avaliableStreamType = {
     {PREVIEW, STREAM_INTENT_TO_STRING(PREVIEW)},
     {VIDEO, STREAM_INTENT_TO_STRING(VIDEO)},
@@ -65,8 +109,30 @@ RetCode StreamBase::ConfigStream(StreamConfiguration& config)
     if (tunnel_ != nullptr) {
         streamConfig_.tunnelMode = true;
     }
-    streamConfig_.bufferCount = GetBufferCount();
-    streamConfig_.maxBatchCaptureCount = 1;
+    // buffer count in config overrides the default of the stream intent.
+    auto setting = BUFFER_COUNT_SETTINGS.find(streamType_);
+    if (config.bufferCount < MIN_BUFFER_COUNT || config.bufferCount > MAX_BUFFER_COUNT) {
+        streamConfig_.bufferCount =
+            setting == BUFFER_COUNT_SETTINGS.end() ? DEFAULT_BUFFER_COUNT : setting->second.bufferCount;
+    }
+    // buffer count is fixed unless the client asks to adapt it.
+    adaptiveBufferCount_ = config.adaptiveBufferCount;
+    if (config.maxBufferCount == 0 && setting != BUFFER_COUNT_SETTINGS.end()) {
+        streamConfig_.maxBufferCount = setting->second.maxBufferCount;
+    }
+    if (streamConfig_.maxBufferCount != 0 && streamConfig_.maxBufferCount < GetBufferCount()) {
+        CAMERA_LOGE("stream [id:%{public}d] max buffer count %{public}u is less than buffer count %{public}u",
+            streamId_, streamConfig_.maxBufferCount, GetBufferCount());
+        return RC_ERROR;
+    }
+    if (config.maxBatchCaptureCount < 1 || config.maxBatchCaptureCount > MAX_BATCH_CAPTURE_COUNT) {
+        streamConfig_.maxBatchCaptureCount = 1;
+        if (streamType_ == VIDEO && config.minFrameDuration > 0 &&
+            config.minFrameDuration <= HIGH_SPEED_FRAME_DURATION) {
+            streamConfig_.maxBatchCaptureCount =
+                std::min(BATCH_REQUEST_DURATION / config.minFrameDuration, MAX_BATCH_CAPTURE_COUNT);
+        }
+    }
     streamConfig_.maxCaptureCount = 1;
     // get device cappability to overide configuration
     return RC_OK;
@@ -94,6 +160,10 @@ RetCode StreamBase::CommitStream()
     info.format_ = streamConfig_.format;
     info.usage_ = streamConfig_.usage;
     info.encodeType_ = streamConfig_.encodeType;
+    info.memoryType_ = static_cast<StreamMemoryType>(streamConfig_.memoryType);
+    info.bufferCount_ = GetBufferCount();
+    info.maxBufferCount_ = streamConfig_.maxBufferCount;
+    info.minFrameDuration_ = streamConfig_.minFrameDuration;
 
     if (streamConfig_.tunnelMode) {
         BufferManager* mgr = BufferManager::GetInstance();
@@ -111,7 +181,6 @@ RetCode StreamBase::CommitStream()
         }
 
         info.bufferPoolId_ = poolId_;
-        info.bufferCount_ = GetBufferCount();
         RetCode rc = bufferPool_->Init(streamConfig_.width, streamConfig_.height, streamConfig_.usage,
                                        streamConfig_.format, GetBufferCount(), CAMERA_BUFFER_SOURCE_TYPE_EXTERNAL);
         if (rc != RC_OK) {
@@ -152,6 +221,7 @@ RetCode StreamBase::StartStream()
         return rc;
     }
 
+    settingsApplied_ = false;
     state_ = STREAM_STATE_BUSY;
     std::string threadName =
         g_avaliableStreamType[static_cast<StreamIntent>(streamType_)] + "#" + std::to_string(streamId_);
@@ -228,7 +298,10 @@ RetCode StreamBase::StopStream()
         messenger_->SendMessage(endMessage);
     }
 
-    CAMERA_LOGI("stop stream [id:%{public}d] end", streamId_);
+    TunnelStatistics stats = tunnel_->GetStatistics();
+    CAMERA_LOGI("stop stream [id:%{public}d] end, buffer count %{public}u, %{public}llu of %{public}llu requests \
+        waited %{public}llu us", streamId_, streamConfig_.bufferCount, stats.waitCount, stats.requestCount,
+        stats.waitTimeUs);
     isFirstRequest = true;
 
     inTransitList_.clear();
@@ -275,7 +348,7 @@ RetCode StreamBase::CancelRequest(const std::shared_ptr<CaptureRequest>& request
 
     {
         // We don't care if this request is continious-capture or single-capture, just erase it.
-        // And those requests in inTransitList_ will be removed in HandleResult.
+        // And those requests in inTransitList_ will be removed in OnFrame.
         std::unique_lock<std::mutex> wl(wtLock_);
         auto it = std::find(waitingList_.begin(), waitingList_.end(), request);
         if (it != waitingList_.end()) {
@@ -288,8 +361,8 @@ RetCode StreamBase::CancelRequest(const std::shared_ptr<CaptureRequest>& request
     if (request->IsContinous()) {
         // may be this is the last request
         std::unique_lock<std::mutex> tl(tsLock_);
-        auto it = std::find(inTransitList_.begin(), inTransitList_.end(), request);
-        if (it == inTransitList_.end()) {
+        auto it = inTransitList_.find(request->GetCaptureId());
+        if (it == inTransitList_.end() || it->second.request != request) {
             std::shared_ptr<ICaptureMessage> endMessage =
                 std::make_shared<CaptureEndedMessage>(streamId_, request->GetCaptureId(), request->GetEndTime(),
                                                       request->GetOwnerCount(), tunnel_->GetFrameCount());
@@ -336,7 +409,13 @@ void StreamBase::HandleRequest()
         if (request->NeedCancel()) {
             return;
         }
-        inTransitList_.emplace_back(request);
+        // one frame for each buffer of the batch, the last returned one ends the capture.
+        InTransitRequest& inTransit = inTransitList_[request->GetCaptureId()];
+        if (inTransit.request != request) {
+            inTransit.request = request;
+            inTransit.frames = 0;
+        }
+        inTransit.frames += request->GetBatchCount();
     }
     request->Process(streamId_);
 
@@ -347,16 +426,31 @@ RetCode StreamBase::Capture(const std::shared_ptr<CaptureRequest>& request)
 {
     CHECK_IF_PTR_NULL_RETURN_VALUE(request, RC_ERROR);
     CHECK_IF_PTR_NULL_RETURN_VALUE(pipeline_, RC_ERROR);
+    CHECK_IF_PTR_NULL_RETURN_VALUE(pipelineCore_, RC_ERROR);
 
     RetCode rc = RC_ERROR;
 
-    rc = pipeline_->Config({streamId_}, request->GetCaptureSetting());
-    if (rc != RC_OK) {
-        CAMERA_LOGE("stream [id:%{public}d] config pipeline failed.", streamId_);
-        return RC_ERROR;
+    CaptureMeta settings = request->GetCaptureSetting();
+    uint64_t settingsHash = GetSettingsHash(settings);
+    uint64_t settingsVersion = pipelineCore_->GetMetadataVersion();
+    if (!settingsApplied_ || settingsHash != settingsHash_ || settingsVersion != settingsVersion_) {
+        rc = pipeline_->Config({streamId_}, settings);
+        if (rc != RC_OK) {
+            CAMERA_LOGE("stream [id:%{public}d] config pipeline failed.", streamId_);
+            settingsApplied_ = false;
+            return RC_ERROR;
+        }
+        settingsApplied_ = true;
+        settingsHash_ = settingsHash;
+        settingsVersion_ = settingsVersion;
     }
 
-    rc = pipeline_->Capture({streamId_}, request->GetCaptureId());
+    uint32_t batchCount = request->GetBatchCount();
+    if (batchCount > 1) {
+        rc = pipeline_->CaptureBatch({streamId_}, request->GetCaptureId(), batchCount);
+    } else {
+        rc = pipeline_->Capture({streamId_}, request->GetCaptureId());
+    }
     if (rc != RC_OK) {
         CAMERA_LOGE("stream [id:%{public}d] take a capture failed.", streamId_);
         return RC_ERROR;
@@ -374,9 +468,11 @@ RetCode StreamBase::Capture(const std::shared_ptr<CaptureRequest>& request)
     }
 
     // DeliverBuffer must be called after Capture, or this capture request will miss a buffer.
-    do {
-        rc = DeliverBuffer();
-    } while (rc != RC_OK && state_ == STREAM_STATE_BUSY);
+    for (uint32_t i = 0; i < batchCount && state_ == STREAM_STATE_BUSY; i++) {
+        do {
+            rc = DeliverBuffer();
+        } while (rc != RC_OK && state_ == STREAM_STATE_BUSY);
+    }
 
     return RC_OK;
 }
@@ -416,13 +512,9 @@ void StreamBase::HandleResult(std::shared_ptr<IBuffer>& buffer)
     std::shared_ptr<CaptureRequest> request = nullptr;
     {
         std::unique_lock<std::mutex> l(tsLock_);
-        for (auto& r : inTransitList_) {
-            if (r == nullptr) {
-                continue;
-            }
-            if (r->GetCaptureId() == captureId) {
-                request = r;
-            }
+        auto it = inTransitList_.find(captureId);
+        if (it != inTransitList_.end()) {
+            request = it->second.request;
         }
     }
     if (request == nullptr) {
@@ -454,12 +546,6 @@ RetCode StreamBase::OnFrame(const std::shared_ptr<CaptureRequest>& request)
             messenger_->SendMessage(errorMessage);
         }
     }
-    if (request->NeedShutterCallback() && messenger_ != nullptr) {
-        std::shared_ptr<ICaptureMessage> shutterMessage = std::make_shared<FrameShutterMessage>(
-            streamId_, request->GetCaptureId(), request->GetEndTime(), request->GetOwnerCount());
-        messenger_->SendMessage(shutterMessage);
-    }
-
     bool isEnded = false;
     if (!request->IsContinous()) {
         isEnded = true;
@@ -468,27 +554,39 @@ RetCode StreamBase::OnFrame(const std::shared_ptr<CaptureRequest>& request)
     }
 
     {
-        // inTransitList_ may have multiple copies of continious-capture request, we just need erase one of them.
+        // continious-capture request may have multiple frames in transit, one of them is returned.
         std::unique_lock<std::mutex> l(tsLock_);
-        for (auto it = inTransitList_.begin(); it != inTransitList_.end(); it++) {
-            if ((*it) == request) {
+        bool inTransit = false;
+        bool batchDone = true;
+        auto it = inTransitList_.find(request->GetCaptureId());
+        if (it != inTransitList_.end() && it->second.request == request) {
+            // each batch adds all of its frames, so the last frame of a batch leaves a multiple of the count.
+            uint32_t batchCount = request->GetBatchCount();
+            batchDone = batchCount <= 1 || it->second.frames % batchCount == 1;
+            if (it->second.frames > 1) {
+                it->second.frames--;
+                inTransit = true;
+            } else {
                 inTransitList_.erase(it);
-                break;
             }
         }
 
-        if (isEnded) {
-            // if this is the last request of capture, send CaptureEndedMessage.
-            auto it = std::find(inTransitList_.begin(), inTransitList_.end(), request);
-            if (it == inTransitList_.end()) {
-                std::shared_ptr<ICaptureMessage> endMessage =
-                    std::make_shared<CaptureEndedMessage>(streamId_, request->GetCaptureId(), request->GetEndTime(),
-                                                          request->GetOwnerCount(), tunnel_->GetFrameCount());
-                CAMERA_LOGV("end of stream [%d], ready to send end message, capture id = %d",
-                    streamId_, request->GetCaptureId());
-                messenger_->SendMessage(endMessage);
-                pipeline_->CancelCapture({streamId_});
-            }
+        // buffers of a batch are returned one by one, but the shutter is reported once for the whole batch.
+        if (request->NeedShutterCallback() && messenger_ != nullptr && batchDone) {
+            std::shared_ptr<ICaptureMessage> shutterMessage = std::make_shared<FrameShutterMessage>(
+                streamId_, request->GetCaptureId(), request->GetEndTime(), request->GetOwnerCount());
+            messenger_->SendMessage(shutterMessage);
+        }
+
+        // if this is the last request of capture, send CaptureEndedMessage.
+        if (isEnded && !inTransit) {
+            std::shared_ptr<ICaptureMessage> endMessage =
+                std::make_shared<CaptureEndedMessage>(streamId_, request->GetCaptureId(), request->GetEndTime(),
+                                                      request->GetOwnerCount(), tunnel_->GetFrameCount());
+            CAMERA_LOGV("end of stream [%d], ready to send end message, capture id = %d",
+                streamId_, request->GetCaptureId());
+            messenger_->SendMessage(endMessage);
+            pipeline_->CancelCapture({streamId_});
         }
     }
 
@@ -506,9 +604,37 @@ RetCode StreamBase::ReceiveBuffer(std::shared_ptr<IBuffer>& buffer)
         streamId_, buffer->GetIndex(), buffer->GetBufferStatus());
     bufferPool_->ReturnBuffer(buffer);
     tunnel_->PutBuffer(buffer);
+    AdjustBufferCount();
     return RC_OK;
 }
 
+void StreamBase::AdjustBufferCount()
+{
+    if (!adaptiveBufferCount_ || ++adjustFrames_ % ADJUST_FRAME_INTERVAL != 0) {
+        return;
+    }
+
+    // grow when requests had to wait for a free buffer, shrink when more than the consumer's one sat idle.
+    TunnelStatistics stats = tunnel_->GetStatistics();
+    uint64_t lastWaitCount = lastWaitCount_.exchange(stats.waitCount);
+    uint32_t bufferCount = streamConfig_.bufferCount;
+    if (stats.waitCount > lastWaitCount && bufferCount < MAX_BUFFER_COUNT) {
+        bufferCount++;
+    } else if (stats.waitCount == lastWaitCount && stats.maxInUse + 1 < bufferCount &&
+        bufferCount > MIN_BUFFER_COUNT) {
+        bufferCount--;
+    }
+    tunnel_->ResetMaxInUse();
+    if (bufferCount == streamConfig_.bufferCount) {
+        return;
+    }
+
+    CAMERA_LOGI("stream [id:%{public}d] buffer count %{public}u -> %{public}u, waits %{public}llu, \
+        max in use %{public}u", streamId_, streamConfig_.bufferCount, bufferCount, stats.waitCount, stats.maxInUse);
+    streamConfig_.bufferCount = bufferCount;
+    tunnel_->SetBufferCount(bufferCount);
+}
+
 uint64_t StreamBase::GetFrameCount() const
 {
     CHECK_IF_PTR_NULL_RETURN_VALUE(tunnel_, 0);
@@ -556,7 +682,19 @@ uint64_t StreamBase::GetUsage()
 
 uint32_t StreamBase::GetBufferCount()
 {
-    return 3; // 3: buffer count
+    if (streamConfig_.bufferCount == 0) {
+        auto setting = BUFFER_COUNT_SETTINGS.find(streamType_);
+        return setting == BUFFER_COUNT_SETTINGS.end() ? DEFAULT_BUFFER_COUNT : setting->second.bufferCount;
+    }
+    return streamConfig_.bufferCount;
+}
+
+TunnelStatistics StreamBase::GetTunnelStatistics() const
+{
+    if (tunnel_ == nullptr) {
+        return {};
+    }
+    return tunnel_->GetStatistics();
 }
 
 StreamConfiguration StreamBase::GetStreamAttribute() const
@@ -33,6 +33,9 @@ StreamOperator::StreamOperator(const OHOS::sptr<IStreamOperatorCallback>& callba
 StreamOperator::~StreamOperator()
 {
     CAMERA_LOGV("enter");
+    if (dumperId_ != 0) {
+        WatchDog::RemoveDumper(dumperId_);
+    }
 }
 
 RetCode StreamOperator::Init()
@@ -62,10 +65,35 @@ RetCode StreamOperator::Init()
     messenger_ = std::make_shared<CaptureMessageOperator>(cb);
     CHECK_IF_PTR_NULL_RETURN_VALUE(messenger_, RC_ERROR);
     messenger_->StartProcess();
+    dumperId_ = WatchDog::AddDumper([this] { DumpState(); });
 
     return RC_OK;
 }
 
+void StreamOperator::DumpState()
+{
+    // called by a timed out watchdog, the hanging request may still hold the locks.
+    std::unique_lock<std::mutex> sl(streamLock_, std::try_to_lock);
+    if (!sl.owns_lock()) {
+        CAMERA_LOGE("stream operator dump: streams are locked");
+    } else {
+        for (auto& it : streamMap_) {
+            StreamConfiguration config = it.second->GetStreamAttribute();
+            CAMERA_LOGE("stream operator dump: stream [id:%{public}d] %{public}ux%{public}u, running:%{public}d, \
+                buffer count:%{public}u", it.first, config.width, config.height, it.second->IsRunning(),
+                config.bufferCount);
+        }
+    }
+    std::unique_lock<std::mutex> rl(requestLock_, std::try_to_lock);
+    if (!rl.owns_lock()) {
+        CAMERA_LOGE("stream operator dump: requests are locked");
+        return;
+    }
+    for (auto& it : requestMap_) {
+        CAMERA_LOGE("stream operator dump: capture [id:%{public}d] is in progress", it.first);
+    }
+}
+
 CamRetCode StreamOperator::IsStreamsSupported(OperationMode mode,
                                               const std::shared_ptr<CameraStandard::CameraMetadata>& modeSetting,
                                               const std::shared_ptr<StreamInfo>& pInfo,
@@ -81,7 +109,7 @@ CamRetCode StreamOperator::IsStreamsSupported(OperationMode mode,
 {
     CHECK_IF_PTR_NULL_RETURN_VALUE(streamPipeline_, DEVICE_ERROR);
     CHECK_IF_PTR_NULL_RETURN_VALUE(modeSetting, INVALID_ARGUMENT);
-    PLACE_A_NOKILL_WATCHDOG(requestTimeoutCB_);
+    PLACE_A_DUMP_WATCHDOG(requestTimeoutCB_);
     DFX_LOCAL_HITRACE_BEGIN;
 
     std::set<int32_t> inputIDSet = {};
@@ -187,6 +215,7 @@ DynamicStreamSwitchMode StreamOperator::CheckStreamsSupported(
         config.tunnelMode = it->tunneledMode_;
         config.minFrameDuration = it->minFrameDuration_;
         config.encodeType = it->encodeType_;
+        config.memoryType = it->memoryType_;
         configs.emplace_back(config);
     }
     // search device capability to check if this configuration is supported.
@@ -195,7 +224,7 @@ DynamicStreamSwitchMode StreamOperator::CheckStreamsSupported(
 
 CamRetCode StreamOperator::CreateStreams(const std::vector<std::shared_ptr<StreamInfo>>& streamInfos)
 {
-    PLACE_A_NOKILL_WATCHDOG(requestTimeoutCB_);
+    PLACE_A_DUMP_WATCHDOG(requestTimeoutCB_);
     DFX_LOCAL_HITRACE_BEGIN;
     for (auto it : streamInfos) {
         CHECK_IF_NOT_EQUAL_RETURN_VALUE(CheckStreamInfo(it), true, INVALID_ARGUMENT);
@@ -220,6 +249,11 @@ CamRetCode StreamOperator::CreateStreams(const std::vector<std::shared_ptr<Strea
         scg.tunnelMode = it->tunneledMode_;
         scg.minFrameDuration = it->minFrameDuration_;
         scg.encodeType = it->encodeType_;
+        scg.memoryType = it->memoryType_;
+        scg.bufferCount = it->bufferCount_ > 0 ? static_cast<uint32_t>(it->bufferCount_) : 0;
+        scg.adaptiveBufferCount = it->adaptiveBufferCount_;
+        scg.maxBufferCount = 0;
+        scg.maxBatchCaptureCount = 0;
 
         RetCode rc = stream->ConfigStream(scg);
         if (rc != RC_OK) {
@@ -253,7 +287,7 @@ CamRetCode StreamOperator::CreateStreams(const std::vector<std::shared_ptr<Strea
 
 CamRetCode StreamOperator::ReleaseStreams(const std::vector<int>& streamIds)
 {
-    PLACE_A_NOKILL_WATCHDOG(requestTimeoutCB_);
+    PLACE_A_DUMP_WATCHDOG(requestTimeoutCB_);
     DFX_LOCAL_HITRACE_BEGIN;
     for (auto id : streamIds) {
         std::lock_guard<std::mutex> l(streamLock_);
@@ -291,7 +325,7 @@ CamRetCode StreamOperator::CommitStreams(OperationMode mode,
 {
     CAMERA_LOGV("enter");
     CHECK_IF_PTR_NULL_RETURN_VALUE(streamPipeline_, DEVICE_ERROR);
-    PLACE_A_NOKILL_WATCHDOG(requestTimeoutCB_);
+    PLACE_A_DUMP_WATCHDOG(requestTimeoutCB_);
     DFX_LOCAL_HITRACE_BEGIN;
 
     std::vector<StreamConfiguration> configs = {};
@@ -338,7 +372,7 @@ CamRetCode StreamOperator::CommitStreams(OperationMode mode,
 
 CamRetCode StreamOperator::GetStreamAttributes(std::vector<std::shared_ptr<StreamAttribute>>& attributes)
 {
-    PLACE_A_NOKILL_WATCHDOG(requestTimeoutCB_);
+    PLACE_A_DUMP_WATCHDOG(requestTimeoutCB_);
     DFX_LOCAL_HITRACE_BEGIN;
 
     attributes.clear();
@@ -352,7 +386,7 @@ CamRetCode StreamOperator::GetStreamAttributes(std::vector<std::shared_ptr<Strea
         attribute->overrideDatasapce_ = configuration.dataspace;
         attribute->producerUsage_ = BufferAdapter::CameraUsageToGrallocUsage(configuration.usage);
         attribute->producerBufferCount_ = configuration.bufferCount;
-        attribute->maxBatchCaptureCount_ = configuration.maxCaptureCount;
+        attribute->maxBatchCaptureCount_ = configuration.maxBatchCaptureCount;
         attribute->maxCaptureCount_ = configuration.maxCaptureCount;
         attributes.emplace_back(attribute);
     }
@@ -364,7 +398,7 @@ CamRetCode StreamOperator::AttachBufferQueue(int streamId, const OHOS::sptr<OHOS
 {
     CHECK_IF_EQUAL_RETURN_VALUE(streamId < 0, true, INVALID_ARGUMENT);
     CHECK_IF_PTR_NULL_RETURN_VALUE(producer, INVALID_ARGUMENT);
-    PLACE_A_NOKILL_WATCHDOG(requestTimeoutCB_);
+    PLACE_A_DUMP_WATCHDOG(requestTimeoutCB_);
     DFX_LOCAL_HITRACE_BEGIN;
 
     std::shared_ptr<IStream> stream = nullptr;
@@ -398,7 +432,7 @@ CamRetCode StreamOperator::AttachBufferQueue(int streamId, const OHOS::sptr<OHOS
 CamRetCode StreamOperator::DetachBufferQueue(int streamId)
 {
     CHECK_IF_EQUAL_RETURN_VALUE(streamId < 0, true, INVALID_ARGUMENT);
-    PLACE_A_NOKILL_WATCHDOG(requestTimeoutCB_);
+    PLACE_A_DUMP_WATCHDOG(requestTimeoutCB_);
     DFX_LOCAL_HITRACE_BEGIN;
 
     std::shared_ptr<IStream> stream = nullptr;
@@ -429,15 +463,18 @@ CamRetCode StreamOperator::DetachBufferQueue(int streamId)
 CamRetCode StreamOperator::Capture(int captureId, const std::shared_ptr<CaptureInfo>& captureInfo, bool isStreaming)
 {
     CHECK_IF_EQUAL_RETURN_VALUE(captureId < 0, true, INVALID_ARGUMENT);
-    PLACE_A_NOKILL_WATCHDOG(requestTimeoutCB_);
+    PLACE_A_DUMP_WATCHDOG(requestTimeoutCB_);
     DFX_LOCAL_HITRACE_BEGIN;
 
+    // frames of a batch are synchronized between streams, so all streams take the smallest batch.
+    int32_t batchCount = INT32_MAX;
     for (auto id : captureInfo->streamIds_) {
         std::lock_guard<std::mutex> l(streamLock_);
         auto it = streamMap_.find(id);
         if (it == streamMap_.end()) {
             return INVALID_ARGUMENT;
         }
+        batchCount = std::min(batchCount, it->second->GetStreamAttribute().maxBatchCaptureCount);
     }
 
     {
@@ -452,6 +489,7 @@ CamRetCode StreamOperator::Capture(int captureId, const std::shared_ptr<CaptureI
     auto request =
         std::make_shared<CaptureRequest>(captureId, captureInfo->streamIds_.size(), setting,
                                          captureInfo->enableShutterCallback_, isStreaming);
+    request->SetBatchCount(batchCount > 1 ? batchCount : 1);
     for (auto id : captureInfo->streamIds_) {
         RetCode rc = streamMap_[id]->AddRequest(request);
         if (rc != RC_OK) {
@@ -469,7 +507,7 @@ CamRetCode StreamOperator::Capture(int captureId, const std::shared_ptr<CaptureI
 CamRetCode StreamOperator::CancelCapture(int captureId)
 {
     CHECK_IF_EQUAL_RETURN_VALUE(captureId < 0, true, INVALID_ARGUMENT);
-    PLACE_A_NOKILL_WATCHDOG(requestTimeoutCB_);
+    PLACE_A_DUMP_WATCHDOG(requestTimeoutCB_);
     DFX_LOCAL_HITRACE_BEGIN;
 
     std::lock_guard<std::mutex> l(requestLock_);
@@ -493,7 +531,7 @@ CamRetCode StreamOperator::ChangeToOfflineStream(const std::vector<int>& streamI
                                                  OHOS::sptr<IStreamOperatorCallback>& callback,
                                                  OHOS::sptr<IOfflineStreamOperator>& offlineOperator)
 {
-    PLACE_A_NOKILL_WATCHDOG(requestTimeoutCB_);
+    PLACE_A_DUMP_WATCHDOG(requestTimeoutCB_);
     DFX_LOCAL_HITRACE_BEGIN;
     CHECK_IF_PTR_NULL_RETURN_VALUE(callback, INVALID_ARGUMENT);
     // offlineOperator should not be null
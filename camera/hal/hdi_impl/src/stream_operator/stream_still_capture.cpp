@@ -75,7 +75,10 @@ RetCode StreamStillCapture::ChangeToOfflineStream(std::shared_ptr<OfflineStream>
     std::lock_guard<std::mutex> l(offlineLock_);
     {
         std::lock_guard<std::mutex> l(tsLock_);
-        context->restRequests = inTransitList_;
+        // offline stream keeps one copy of a request for each frame in transit.
+        for (auto& it : inTransitList_) {
+            context->restRequests.insert(context->restRequests.end(), it.second.frames, it.second.request);
+        }
         state_ = STREAM_STATE_OFFLINE;
         CAMERA_LOGI("there is/are %{public}u request(s) left in stream %{public}d.",
             context->restRequests.size(), streamId_);
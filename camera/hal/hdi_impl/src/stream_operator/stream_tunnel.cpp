@@ -15,6 +15,7 @@
 #include "stream_tunnel.h"
 #include "buffer_adapter.h"
 #include "image_buffer.h"
+#include <chrono>
 
 namespace {
 constexpr uint32_t REQUEST_TIMEOUT = 0;
@@ -52,6 +53,7 @@ void StreamTunnel::CleanBuffers()
 
     std::lock_guard<std::mutex> l(lock_);
     buffers.clear();
+    surfaceBuffers_.clear();
     bufferQueue_->CleanCache();
     index = -1;
 }
@@ -62,14 +64,26 @@ std::shared_ptr<IBuffer> StreamTunnel::GetBuffer()
     OHOS::sptr<OHOS::SurfaceBuffer> sb = nullptr;
     int32_t fence = 0;
     OHOS::SurfaceError sfError = OHOS::SURFACE_ERROR_OK;
+    bool waited = false;
+    std::chrono::steady_clock::time_point waitBegin = {};
     do {
         sfError = bufferQueue_->RequestBuffer(sb, fence, requestConfig_);
         if (sfError == OHOS::SURFACE_ERROR_NO_BUFFER) {
+            if (!waited) {
+                waited = true;
+                waitBegin = std::chrono::steady_clock::now();
+            }
             std::unique_lock<std::mutex> l(waitLock_);
             waitCV_.wait(l, [this] { return wakeup_ == true; });
         }
     } while (!stop_ && sfError == OHOS::SURFACE_ERROR_NO_BUFFER);
     wakeup_ = false;
+    requestCount_++;
+    if (waited) {
+        waitCount_++;
+        waitTimeUs_ += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - waitBegin).count();
+    }
 
     if (stop_) {
         if (sb != nullptr) {
@@ -86,10 +100,9 @@ std::shared_ptr<IBuffer> StreamTunnel::GetBuffer()
     std::shared_ptr<IBuffer> cb = nullptr;
     {
         std::lock_guard<std::mutex> l(lock_);
-        for (auto it = buffers.begin(); it != buffers.end(); it++) {
-            if (it->second == sb) {
-                cb = it->first;
-            }
+        auto it = surfaceBuffers_.find(sb.GetRefPtr());
+        if (it != surfaceBuffers_.end()) {
+            cb = it->second;
         }
     }
     if (cb == nullptr) {
@@ -104,11 +117,18 @@ std::shared_ptr<IBuffer> StreamTunnel::GetBuffer()
         {
             std::lock_guard<std::mutex> l(lock_);
             buffers[cb] = sb;
+            surfaceBuffers_[sb.GetRefPtr()] = cb;
         }
     } else {
         cb->SetBufferStatus(CAMERA_BUFFER_STATUS_OK);
     }
-    restBuffers++;
+    uint32_t inUse = ++restBuffers;
+    uint32_t maxInUse = maxInUse_.load();
+    while (inUse > maxInUse) {
+        if (maxInUse_.compare_exchange_weak(maxInUse, inUse)) {
+            break;
+        }
+    }
     return cb;
 }
 
@@ -131,10 +151,10 @@ RetCode StreamTunnel::PutBuffer(const std::shared_ptr<IBuffer>& buffer)
         int32_t fence = 0;
         EsFrmaeInfo esInfo = buffer->GetEsFrameInfo();
         if (esInfo.size != -1 && esInfo.timestamp != -1) {
-            sb->ExtraSet("dataSize", esInfo.size);
-            sb->ExtraSet("isKeyFrame", esInfo.isKey);
-            sb->ExtraSet("timeStamp", esInfo.timestamp);
-            sb->ExtraSet("frameNum", esInfo.frameNum);
+            sb->ExtraSet(dataSizeKey_, esInfo.size);
+            sb->ExtraSet(isKeyFrameKey_, esInfo.isKey);
+            sb->ExtraSet(timeStampKey_, esInfo.timestamp);
+            sb->ExtraSet(frameNumKey_, esInfo.frameNum);
         }
         bufferQueue_->FlushBuffer(sb, fence, flushConfig_);
         frameCount_++;
@@ -182,6 +202,16 @@ uint64_t StreamTunnel::GetFrameCount() const
     return frameCount_;
 }
 
+TunnelStatistics StreamTunnel::GetStatistics() const
+{
+    return {requestCount_, waitCount_, waitTimeUs_, maxInUse_};
+}
+
+void StreamTunnel::ResetMaxInUse()
+{
+    maxInUse_ = restBuffers.load();
+}
+
 void StreamTunnel::NotifyStop()
 {
     std::unique_lock<std::mutex> l(waitLock_);
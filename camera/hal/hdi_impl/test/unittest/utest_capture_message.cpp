@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utest_capture_message.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace OHOS;
+using namespace testing::ext;
+using namespace OHOS::Camera;
+
+namespace {
+    // every producer node sends 240 messages in one second.
+    constexpr int32_t PRODUCER_COUNT = 4;
+    constexpr uint32_t MESSAGE_COUNT = 240;
+    constexpr uint32_t MESSAGE_INTERVAL_US = 1000000 / MESSAGE_COUNT;
+    constexpr uint32_t WAIT_LOOPS = 200;
+    constexpr uint32_t WAIT_INTERVAL_US = 10000;
+    constexpr int32_t CAPTURE_ID = 100;
+}
+
+void CaptureMessageTest::SetUpTestCase(void)
+{
+    std::cout << "Camera::CaptureMessage SetUpTestCase" << std::endl;
+}
+
+void CaptureMessageTest::TearDownTestCase(void)
+{
+    std::cout << "Camera::CaptureMessage TearDownTestCase" << std::endl;
+}
+
+void CaptureMessageTest::SetUp(void)
+{
+    std::cout << "Camera::CaptureMessage SetUp" << std::endl;
+}
+
+void CaptureMessageTest::TearDown(void)
+{
+    std::cout << "Camera::CaptureMessage TearDown.." << std::endl;
+}
+
+void CaptureMessageTest::Produce(CaptureMessageOperator& messenger, int32_t streamId, uint32_t peerCount)
+{
+    // peer messages share the frame timestamps, single ones have timestamps of their own stream.
+    uint64_t base = peerCount == 1 ? static_cast<uint64_t>(streamId) * MESSAGE_COUNT : 0;
+    int64_t sendNs = 0;
+    for (uint32_t i = 0; i < MESSAGE_COUNT; i++) {
+        std::shared_ptr<ICaptureMessage> message =
+            std::make_shared<FrameShutterMessage>(streamId, CAPTURE_ID, base + i + 1, peerCount);
+        auto begin = std::chrono::steady_clock::now();
+        messenger.SendMessage(message);
+        auto end = std::chrono::steady_clock::now();
+        sendNs += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        usleep(MESSAGE_INTERVAL_US);
+    }
+    std::cout << "stream " << streamId << " SendMessage " << sendNs / MESSAGE_COUNT << " ns" << std::endl;
+}
+
+HWTEST_F(CaptureMessageTest, UTestPeerMessagesStress, TestSize.Level0)
+{
+    std::mutex lock;
+    std::set<uint64_t> timestamps;
+    std::atomic<uint32_t> callbacks = 0;
+    std::atomic<uint32_t> incomplete = 0;
+    CaptureMessageOperator messenger([&](MessageGroup& group) {
+        if (group.size() != PRODUCER_COUNT) {
+            incomplete++;
+        }
+        std::lock_guard<std::mutex> l(lock);
+        timestamps.insert(group[0]->GetTimestamp());
+        callbacks++;
+    });
+    EXPECT_EQ(true, messenger.StartProcess() == RC_OK);
+
+    std::vector<std::thread> producers;
+    for (int32_t i = 0; i < PRODUCER_COUNT; i++) {
+        producers.emplace_back([&messenger, i] { Produce(messenger, i, PRODUCER_COUNT); });
+    }
+    for (auto& it : producers) {
+        it.join();
+    }
+    for (uint32_t i = 0; i < WAIT_LOOPS && callbacks < MESSAGE_COUNT; i++) {
+        usleep(WAIT_INTERVAL_US);
+    }
+
+    // every frame is reported once with the messages of all producers.
+    EXPECT_EQ(true, callbacks == MESSAGE_COUNT);
+    EXPECT_EQ(true, incomplete == 0);
+    std::lock_guard<std::mutex> l(lock);
+    EXPECT_EQ(true, timestamps.size() == MESSAGE_COUNT);
+}
+
+HWTEST_F(CaptureMessageTest, UTestSingleMessagesStress, TestSize.Level0)
+{
+    std::atomic<uint32_t> messages = 0;
+    CaptureMessageOperator messenger([&messages](MessageGroup& group) {
+        messages += group.size();
+    });
+    EXPECT_EQ(true, messenger.StartProcess() == RC_OK);
+
+    std::vector<std::thread> producers;
+    for (int32_t i = 0; i < PRODUCER_COUNT; i++) {
+        producers.emplace_back([&messenger, i] { Produce(messenger, i, 1); });
+    }
+    for (auto& it : producers) {
+        it.join();
+    }
+    for (uint32_t i = 0; i < WAIT_LOOPS && messages < MESSAGE_COUNT * PRODUCER_COUNT; i++) {
+        usleep(WAIT_INTERVAL_US);
+    }
+    EXPECT_EQ(true, messages == MESSAGE_COUNT * PRODUCER_COUNT);
+}
@@ -16,6 +16,9 @@
 #include "utest_stream_operator_impl.h"
 #include "stream_operator_callback.h"
 #include "istream_operator_callback.h"
+#include "stream_tunnel.h"
+#include <chrono>
+#include <ctime>
 
 #define SURFACE_ID (12345 + 666 + 2333)
 const int CAMERA_BUFFER_QUEUE_IPC = 654320;
@@ -182,6 +185,129 @@ HWTEST_F(StreamOperatorImplTest, UTestAttachBufferQueue, TestSize.Level0)
     EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
 }
 
+HWTEST_F(StreamOperatorImplTest, UTestStreamTunnelBenchmark, TestSize.Level1)
+{
+    const int rounds = 100;
+    for (int bufferCount : {4, 8, 16, 32}) {
+        StreamConsumer consumer;
+        OHOS::sptr<OHOS::IBufferProducer> producer = consumer.CreateProducer([](void* addr, uint32_t size) {});
+        std::shared_ptr<StreamTunnel> tunnel = std::make_shared<StreamTunnel>();
+        EXPECT_EQ(true, tunnel->AttachBufferQueue(producer) == RC_OK);
+        EXPECT_EQ(true, tunnel->SetBufferCount(bufferCount) == RC_OK);
+        TunnelConfig config = {640, 480, CAMERA_FORMAT_YCRCB_420_SP,
+            CAMERA_USAGE_SW_READ_OFTEN | CAMERA_USAGE_SW_WRITE_OFTEN};
+        tunnel->Config(config);
+        tunnel->NotifyStart();
+
+        // the first round wraps every surface buffer, later rounds only look them up.
+        std::vector<std::shared_ptr<IBuffer>> buffers;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i <= rounds; i++) {
+            if (i == 1) {
+                begin = std::chrono::steady_clock::now();
+            }
+            for (int j = 0; j < bufferCount; j++) {
+                std::shared_ptr<IBuffer> buffer = tunnel->GetBuffer();
+                EXPECT_EQ(true, buffer != nullptr);
+                buffers.emplace_back(buffer);
+            }
+            for (auto& it : buffers) {
+                it->SetBufferStatus(CAMERA_BUFFER_STATUS_INVALID);
+                EXPECT_EQ(true, tunnel->PutBuffer(it) == RC_OK);
+            }
+            buffers.clear();
+        }
+        auto end = std::chrono::steady_clock::now();
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        std::cout << "tunnel with " << bufferCount << " buffers, GetBuffer + PutBuffer " <<
+            ns / (rounds * bufferCount) << " ns" << std::endl;
+        tunnel->NotifyStop();
+        tunnel->CleanBuffers();
+    }
+}
+
+HWTEST_F(StreamOperatorImplTest, UTestStreamTunnelStatistics, TestSize.Level0)
+{
+    const int bufferCount = 3;
+    StreamConsumer consumer;
+    OHOS::sptr<OHOS::IBufferProducer> producer = consumer.CreateProducer([](void* addr, uint32_t size) {});
+    std::shared_ptr<StreamTunnel> tunnel = std::make_shared<StreamTunnel>();
+    EXPECT_EQ(true, tunnel->AttachBufferQueue(producer) == RC_OK);
+    EXPECT_EQ(true, tunnel->SetBufferCount(bufferCount) == RC_OK);
+    TunnelConfig config = {640, 480, CAMERA_FORMAT_YCRCB_420_SP,
+        CAMERA_USAGE_SW_READ_OFTEN | CAMERA_USAGE_SW_WRITE_OFTEN};
+    tunnel->Config(config);
+    tunnel->NotifyStart();
+
+    std::vector<std::shared_ptr<IBuffer>> buffers;
+    for (int i = 0; i < bufferCount; i++) {
+        buffers.emplace_back(tunnel->GetBuffer());
+    }
+    TunnelStatistics stats = tunnel->GetStatistics();
+    EXPECT_EQ(true, stats.requestCount == bufferCount);
+    EXPECT_EQ(true, stats.waitCount == 0);
+    EXPECT_EQ(true, stats.maxInUse == bufferCount);
+
+    // all buffers are held, the next request waits until one is returned.
+    std::thread returner([&buffers, &tunnel] {
+        usleep(10000); // 10000: wait 10ms before return
+        buffers[0]->SetBufferStatus(CAMERA_BUFFER_STATUS_INVALID);
+        tunnel->PutBuffer(buffers[0]);
+    });
+    std::shared_ptr<IBuffer> buffer = tunnel->GetBuffer();
+    returner.join();
+    EXPECT_EQ(true, buffer != nullptr);
+    stats = tunnel->GetStatistics();
+    EXPECT_EQ(true, stats.waitCount == 1);
+    EXPECT_EQ(true, stats.waitTimeUs > 0);
+
+    buffers[0] = buffer;
+    for (auto& it : buffers) {
+        it->SetBufferStatus(CAMERA_BUFFER_STATUS_INVALID);
+        tunnel->PutBuffer(it);
+    }
+    tunnel->ResetMaxInUse();
+    EXPECT_EQ(true, tunnel->GetStatistics().maxInUse == 0);
+    tunnel->NotifyStop();
+    tunnel->CleanBuffers();
+}
+
+HWTEST_F(StreamOperatorImplTest, UTestStreamBufferCount, TestSize.Level0)
+{
+    // buffer count of stream info overrides the default of the stream type, 0 keeps the default.
+    const int defaultVideoBufferCount = 4;
+    for (int bufferCount : {6, 0}) {
+        std::vector<std::shared_ptr<StreamInfo>> streamInfos;
+        std::shared_ptr<StreamInfo> streamInfo = std::make_shared<StreamInfo>();
+        streamInfo->streamId_ = 1012;
+        streamInfo->width_ = 640;
+        streamInfo->height_ = 480;
+        streamInfo->format_ = PIXEL_FMT_YCRCB_420_SP;
+        streamInfo->datasapce_ = 8;
+        streamInfo->intent_ = VIDEO;
+        streamInfo->bufferCount_ = bufferCount;
+        StreamConsumer videoConsumer;
+        streamInfo->bufferQueue_ = videoConsumer.CreateProducer([](void* addr, uint32_t size) {});
+        streamInfo->tunneledMode_ = 5;
+        streamInfos.push_back(streamInfo);
+        OHOS::Camera::CamRetCode ret = streamOperator_->CreateStreams(streamInfos);
+        EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+
+        std::vector<std::shared_ptr<StreamAttribute>> attributes;
+        ret = streamOperator_->GetStreamAttributes(attributes);
+        EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+        EXPECT_EQ(true, attributes.size() == 1);
+        if (!attributes.empty()) {
+            EXPECT_EQ(bufferCount == 0 ? defaultVideoBufferCount : bufferCount,
+                attributes[0]->producerBufferCount_);
+        }
+
+        std::vector<int> streamIds = {streamInfo->streamId_};
+        ret = streamOperator_->ReleaseStreams(streamIds);
+        EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+    }
+}
+
 HWTEST_F(StreamOperatorImplTest, UTestCapture, TestSize.Level0)
 {
     OperationMode operationMode = NORMAL;
@@ -232,4 +358,188 @@ HWTEST_F(StreamOperatorImplTest, UTestCapture, TestSize.Level0)
     std::vector<int> streamIds = {1005};
     ret = streamOperator_->ReleaseStreams(streamIds);
     EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
-}
\ No newline at end of file
+}
+
+HWTEST_F(StreamOperatorImplTest, UTestUpdateSettingsBetweenCaptures, TestSize.Level0)
+{
+    // settings of the device updated between two captures of the same settings, the second one applies them again.
+    std::atomic<uint32_t> frames = 0;
+    std::vector<std::shared_ptr<StreamInfo>> streamInfos;
+    std::shared_ptr<StreamInfo> streamInfo = std::make_shared<StreamInfo>();
+    streamInfo->streamId_ = 1015;
+    streamInfo->width_ = 640;
+    streamInfo->height_ = 480;
+    streamInfo->format_ = PIXEL_FMT_YCRCB_420_SP;
+    streamInfo->datasapce_ = 8;
+    streamInfo->intent_ = PREVIEW;
+    std::shared_ptr<StreamConsumer> previewConsumer = std::make_shared<StreamConsumer>();
+    streamInfo->bufferQueue_ = previewConsumer->CreateProducer([&frames](void* addr, uint32_t size) {
+        frames++;
+    });
+    streamInfo->bufferQueue_->SetQueueSize(8);
+    streamInfo->tunneledMode_ = 5;
+    streamInfos.push_back(streamInfo);
+    OHOS::Camera::CamRetCode ret = streamOperator_->CreateStreams(streamInfos);
+    EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+
+    std::vector<std::string> cameraIds;
+    ret = cameraHost_->GetCameraIds(cameraIds);
+    EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+    std::shared_ptr<CameraAbility> ability = nullptr;
+    ret = cameraHost_->GetCameraAbility(cameraIds.front(), ability);
+    ret = streamOperator_->CommitStreams(NORMAL, ability);
+    EXPECT_EQ(true, ret == Camera::NO_ERROR);
+
+    std::shared_ptr<CameraStandard::CameraMetadata> deviceSetting =
+        std::make_shared<CameraStandard::CameraMetadata>(2, 128);
+    int64_t expoTime = 0;
+    deviceSetting->addEntry(OHOS_SENSOR_EXPOSURE_TIME, &expoTime, 1);
+    const int captureIdBase = 2004;
+    for (int i = 0; i < 2; i++) { // 2: captures before and after the update
+        std::shared_ptr<OHOS::Camera::CaptureInfo> captureInfo = std::make_shared<OHOS::Camera::CaptureInfo>();
+        captureInfo->streamIds_ = {streamInfo->streamId_};
+        captureInfo->captureSetting_ = ability;
+        captureInfo->enableShutterCallback_ = false;
+        ret = streamOperator_->Capture(captureIdBase + i, captureInfo, false);
+        EXPECT_EQ(true, ret == Camera::NO_ERROR);
+        sleep(1);
+        if (i == 0) {
+            ret = cameraDevice_->UpdateSettings(deviceSetting);
+            EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+        }
+    }
+    EXPECT_EQ(true, frames >= 2); // 2: one frame of each capture
+
+    std::vector<int> streamIds = {streamInfo->streamId_};
+    ret = streamOperator_->ReleaseStreams(streamIds);
+    EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+}
+
+HWTEST_F(StreamOperatorImplTest, UTestBatchCaptureOverhead, TestSize.Level1)
+{
+    // 120fps video, unbatched and batched by the min frame duration (us), compare cpu time of each frame.
+    const int captureSeconds = 3;
+    for (int frameDuration : {0, 1000000 / 120}) {
+        std::atomic<uint32_t> frames = 0;
+        std::vector<std::shared_ptr<StreamInfo>> streamInfos;
+        std::shared_ptr<StreamInfo> streamInfo = std::make_shared<StreamInfo>();
+        streamInfo->streamId_ = 1013;
+        streamInfo->width_ = 640;
+        streamInfo->height_ = 480;
+        streamInfo->format_ = PIXEL_FMT_YCRCB_420_SP;
+        streamInfo->datasapce_ = 8;
+        streamInfo->intent_ = VIDEO;
+        streamInfo->minFrameDuration_ = frameDuration;
+        StreamConsumer videoConsumer;
+        streamInfo->bufferQueue_ = videoConsumer.CreateProducer([&frames](void* addr, uint32_t size) {
+            frames++;
+        });
+        streamInfo->bufferQueue_->SetQueueSize(8);
+        streamInfo->tunneledMode_ = 5;
+        streamInfos.push_back(streamInfo);
+        OHOS::Camera::CamRetCode ret = streamOperator_->CreateStreams(streamInfos);
+        EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+
+        std::vector<std::shared_ptr<StreamAttribute>> attributes;
+        ret = streamOperator_->GetStreamAttributes(attributes);
+        EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+        int batchCount = attributes.empty() ? 1 : attributes[0]->maxBatchCaptureCount_;
+
+        std::vector<std::string> cameraIds;
+        ret = cameraHost_->GetCameraIds(cameraIds);
+        EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+        std::shared_ptr<CameraAbility> ability = nullptr;
+        ret = cameraHost_->GetCameraAbility(cameraIds.front(), ability);
+        ret = streamOperator_->CommitStreams(NORMAL, ability);
+        EXPECT_EQ(true, ret == Camera::NO_ERROR);
+
+        int captureId = 2002;
+        std::shared_ptr<OHOS::Camera::CaptureInfo> captureInfo = std::make_shared<OHOS::Camera::CaptureInfo>();
+        captureInfo->streamIds_ = {streamInfo->streamId_};
+        captureInfo->captureSetting_ = ability;
+        captureInfo->enableShutterCallback_ = true;
+        struct timespec begin = {};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &begin);
+        ret = streamOperator_->Capture(captureId, captureInfo, true);
+        EXPECT_EQ(true, ret == Camera::NO_ERROR);
+        sleep(captureSeconds);
+        ret = streamOperator_->CancelCapture(captureId);
+        EXPECT_EQ(true, ret == Camera::NO_ERROR);
+        struct timespec end = {};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+
+        int64_t us = (end.tv_sec - begin.tv_sec) * 1000000 + (end.tv_nsec - begin.tv_nsec) / 1000;
+        std::cout << "batch " << batchCount << ", " << frames << " frames, cpu time per frame " <<
+            (frames > 0 ? us / frames : 0) << " us" << std::endl;
+        std::vector<int> streamIds = {streamInfo->streamId_};
+        ret = streamOperator_->ReleaseStreams(streamIds);
+        EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+    }
+}
+
+HWTEST_F(StreamOperatorImplTest, UTestRepeatingCaptureResultCost, TestSize.Level1)
+{
+    // one repeating capture on each stream, cpu time of each frame should not grow with the captures in flight.
+    const int captureSeconds = 3;
+    const int streamIdBase = 1014;
+    const int captureIdBase = 2003;
+    for (int captureCount : {1, 2, 4}) {
+        std::atomic<uint32_t> frames = 0;
+        std::vector<std::shared_ptr<StreamInfo>> streamInfos;
+        std::vector<std::shared_ptr<StreamConsumer>> consumers;
+        for (int i = 0; i < captureCount; i++) {
+            std::shared_ptr<StreamInfo> streamInfo = std::make_shared<StreamInfo>();
+            streamInfo->streamId_ = streamIdBase + i;
+            streamInfo->width_ = 640;
+            streamInfo->height_ = 480;
+            streamInfo->format_ = PIXEL_FMT_YCRCB_420_SP;
+            streamInfo->datasapce_ = 8;
+            streamInfo->intent_ = PREVIEW;
+            std::shared_ptr<StreamConsumer> consumer = std::make_shared<StreamConsumer>();
+            streamInfo->bufferQueue_ = consumer->CreateProducer([&frames](void* addr, uint32_t size) {
+                frames++;
+            });
+            streamInfo->bufferQueue_->SetQueueSize(8);
+            streamInfo->tunneledMode_ = 5;
+            streamInfos.push_back(streamInfo);
+            consumers.push_back(consumer);
+        }
+        OHOS::Camera::CamRetCode ret = streamOperator_->CreateStreams(streamInfos);
+        EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+
+        std::vector<std::string> cameraIds;
+        ret = cameraHost_->GetCameraIds(cameraIds);
+        EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+        std::shared_ptr<CameraAbility> ability = nullptr;
+        ret = cameraHost_->GetCameraAbility(cameraIds.front(), ability);
+        ret = streamOperator_->CommitStreams(NORMAL, ability);
+        EXPECT_EQ(true, ret == Camera::NO_ERROR);
+
+        // the same settings for every request, the pipeline is only configured by the first one.
+        struct timespec begin = {};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &begin);
+        for (int i = 0; i < captureCount; i++) {
+            std::shared_ptr<OHOS::Camera::CaptureInfo> captureInfo = std::make_shared<OHOS::Camera::CaptureInfo>();
+            captureInfo->streamIds_ = {streamInfos[i]->streamId_};
+            captureInfo->captureSetting_ = ability;
+            captureInfo->enableShutterCallback_ = false;
+            ret = streamOperator_->Capture(captureIdBase + i, captureInfo, true);
+            EXPECT_EQ(true, ret == Camera::NO_ERROR);
+        }
+        sleep(captureSeconds);
+        std::vector<int> streamIds;
+        for (int i = 0; i < captureCount; i++) {
+            ret = streamOperator_->CancelCapture(captureIdBase + i);
+            EXPECT_EQ(true, ret == Camera::NO_ERROR);
+            streamIds.push_back(streamInfos[i]->streamId_);
+        }
+        struct timespec end = {};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+
+        int64_t us = (end.tv_sec - begin.tv_sec) * 1000000 + (end.tv_nsec - begin.tv_nsec) / 1000;
+        std::cout << captureCount << " repeating captures, " << frames << " frames, cpu time per frame " <<
+            (frames > 0 ? us / frames : 0) << " us" << std::endl;
+        ret = streamOperator_->ReleaseStreams(streamIds);
+        EXPECT_EQ(true, ret == OHOS::Camera::NO_ERROR);
+    }
+}
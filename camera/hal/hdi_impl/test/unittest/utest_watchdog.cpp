@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utest_watchdog.h"
+#include <atomic>
+#include <dirent.h>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace OHOS;
+using namespace testing::ext;
+using namespace OHOS::Camera;
+
+namespace {
+    constexpr int WORKER_COUNT = 8;
+    constexpr int WATCHDOG_PER_WORKER = 50;
+    constexpr int WATCHDOG_TIMEOUT_MS = 50;
+}
+
+void WatchDogTest::SetUpTestCase(void)
+{
+    std::cout << "Camera::WatchDog SetUpTestCase" << std::endl;
+}
+
+void WatchDogTest::TearDownTestCase(void)
+{
+    std::cout << "Camera::WatchDog TearDownTestCase" << std::endl;
+}
+
+void WatchDogTest::SetUp(void)
+{
+    std::cout << "Camera::WatchDog SetUp" << std::endl;
+}
+
+void WatchDogTest::TearDown(void)
+{
+    std::cout << "Camera::WatchDog TearDown.." << std::endl;
+}
+
+int32_t WatchDogTest::GetThreadCount()
+{
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return -1;
+    }
+    int32_t count = 0;
+    for (struct dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+HWTEST_F(WatchDogTest, UTestConcurrentWatchDogs, TestSize.Level0)
+{
+    // the shared timer thread is started by the first watchdog.
+    {
+        WatchDog dog;
+        dog.Init(WATCHDOG_TIMEOUT_MS, nullptr, WATCHDOG_ACTION_LOG);
+    }
+    int32_t threadCount = GetThreadCount();
+
+    // every worker arms its watchdogs and disarms half of them at once, the others time out.
+    std::atomic<int> fired = 0;
+    std::vector<std::vector<std::unique_ptr<WatchDog>>> dogs(WORKER_COUNT);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < WORKER_COUNT; i++) {
+        workers.emplace_back([i, &dogs, &fired] {
+            for (int j = 0; j < WATCHDOG_PER_WORKER; j++) {
+                auto dog = std::make_unique<WatchDog>();
+                dog->Init(WATCHDOG_TIMEOUT_MS + j, [&fired] { fired++; }, WATCHDOG_ACTION_LOG);
+                if (j % 2 == 0) {
+                    dogs[i].emplace_back(std::move(dog));
+                }
+            }
+        });
+    }
+    for (auto& it : workers) {
+        it.join();
+    }
+    EXPECT_EQ(true, GetThreadCount() == threadCount);
+
+    usleep((WATCHDOG_TIMEOUT_MS + WATCHDOG_PER_WORKER) * 1000 * 4); // 1000: ms to us, 4: wait for all timeouts
+    std::cout << "fired " << fired << " of " << WORKER_COUNT * WATCHDOG_PER_WORKER << " watchdogs" << std::endl;
+    EXPECT_EQ(true, fired == WORKER_COUNT * WATCHDOG_PER_WORKER / 2);
+    dogs.clear();
+    EXPECT_EQ(true, fired == WORKER_COUNT * WATCHDOG_PER_WORKER / 2);
+}
+
+HWTEST_F(WatchDogTest, UTestDumpAction, TestSize.Level0)
+{
+    std::atomic<int> dumped = 0;
+    uint32_t dumperId = WatchDog::AddDumper([&dumped] { dumped++; });
+    {
+        WatchDog dog;
+        dog.Init(WATCHDOG_TIMEOUT_MS, nullptr, WATCHDOG_ACTION_DUMP);
+        usleep(WATCHDOG_TIMEOUT_MS * 1000 * 4); // 1000: ms to us, 4: wait for the timeout
+    }
+    EXPECT_EQ(true, dumped == 1);
+
+    // a watchdog which is disarmed in time dumps nothing.
+    {
+        WatchDog dog;
+        dog.Init(WATCHDOG_TIMEOUT_MS, nullptr, WATCHDOG_ACTION_DUMP);
+    }
+    usleep(WATCHDOG_TIMEOUT_MS * 1000 * 2); // 1000: ms to us, 2: wait longer than the timeout
+    EXPECT_EQ(true, dumped == 1);
+    WatchDog::RemoveDumper(dumperId);
+}
+
+HWTEST_F(WatchDogTest, UTestDisarmWaitsForExecutor, TestSize.Level0)
+{
+    std::atomic<bool> started = false;
+    std::atomic<bool> done = false;
+    auto dog = std::make_unique<WatchDog>();
+    dog->Init(WATCHDOG_TIMEOUT_MS, [&started, &done] {
+        started = true;
+        usleep(WATCHDOG_TIMEOUT_MS * 1000); // 1000: ms to us
+        done = true;
+    }, WATCHDOG_ACTION_LOG);
+    while (!started) {
+        usleep(1000); // 1000: poll every 1ms
+    }
+    dog = nullptr;
+    EXPECT_EQ(true, done);
+}
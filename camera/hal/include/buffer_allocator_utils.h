@@ -20,6 +20,7 @@
 #include "ibuffer.h"
 #include "ibuffer_allocator.h"
 #include <memory>
+#include <vector>
 
 namespace OHOS::Camera {
 class BufferAllocatorUtils {
@@ -27,6 +28,9 @@ public:
     // get buffer allocator
     static std::shared_ptr<IBufferAllocator> GetAllocator(std::shared_ptr<IBuffer>& buffer);
 
+    // get the initialized allocator of a source, it's resolved and initialized once per process.
+    static std::shared_ptr<IBufferAllocator> GetBufferAllocator(const int32_t source);
+
     // allocate buffer from source.
     static std::shared_ptr<IBuffer> AllocBuffer(const int32_t source,
                                                 const uint32_t width,
@@ -34,9 +38,21 @@ public:
                                                 const uint64_t usage,
                                                 const uint32_t format);
 
+    // allocate count buffers from source, either all of them or none.
+    static RetCode AllocBuffers(const int32_t source,
+                                const uint32_t count,
+                                const uint32_t width,
+                                const uint32_t height,
+                                const uint64_t usage,
+                                const uint32_t format,
+                                std::vector<std::shared_ptr<IBuffer>>& buffers);
+
     // free the buffer
     static RetCode FreeBuffer(std::shared_ptr<IBuffer>& buffer);
 
+    // free buffers, which may be from different sources.
+    static RetCode FreeBuffers(std::vector<std::shared_ptr<IBuffer>>& buffers);
+
     // Map the buffer
     static RetCode MapBuffer(std::shared_ptr<IBuffer>& buffer);
 
@@ -48,8 +64,6 @@ public:
 
     // invalidate the cache, update cache from memory
     static RetCode InvalidateCache(std::shared_ptr<IBuffer>& buffer);
-private:
-    static std::shared_ptr<IBufferAllocator> GetBufferAllocator(const int32_t source);
 };
 } // namespace OHOS::Camera
 #endif
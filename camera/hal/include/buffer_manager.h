@@ -17,9 +17,12 @@
 #define HOS_CAMERA_BUFFER_MANAGER_H
 
 #include "ibuffer_pool.h"
-#include <map>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace OHOS::Camera {
 class BufferManager {
@@ -28,23 +31,43 @@ public:
     // get a pointer of BufferManager
     static BufferManager* GetInstance();
 
-    // generate a random id for buffer pool.
+    // generate a unique id for buffer pool.
     int64_t GenerateBufferPoolId();
 
-    // get a buffer pool from id.
+    // get a buffer pool from id. buffers in the pipeline should use IBuffer::GetPool instead.
     std::shared_ptr<IBufferPool> GetBufferPool(int64_t id);
 
+    // start trimming idle buffers of elastic pools periodically, only one thread serves all pools.
+    void StartTrimming();
+
 private:
+    void TrimBufferPools();
+
+    // ids start far from small numbers, which are seen as uninitialized pool ids.
+    static constexpr int64_t POOL_ID_BASE = 1000000;
+    static constexpr uint32_t POOL_SHARD_COUNT = 16;
+    // pools are spread over shards by id, so that streams don't contend for one lock.
+    struct PoolShard {
+        std::mutex lock;
+        std::unordered_map<int64_t, std::weak_ptr<IBufferPool>> pools;
+    };
+    PoolShard& GetShard(const int64_t id);
+
     BufferManager() = default;
     BufferManager(const BufferManager&);
     BufferManager& operator=(const BufferManager&);
     BufferManager(BufferManager&&);
     BufferManager& operator=(BufferManager&&);
 
-    ~BufferManager() = default;
+    ~BufferManager();
+
+    std::atomic<int64_t> nextPoolId_ = POOL_ID_BASE;
+    PoolShard shards_[POOL_SHARD_COUNT];
 
-    std::mutex lock_;
-    std::map<int64_t, std::weak_ptr<IBufferPool>> bufferPoolMap_;
+    std::mutex trimLock_;
+    std::condition_variable trimCv_;
+    std::atomic_bool trimRunning_ = false;
+    std::thread* trimThread_ = nullptr;
 };
 } // namespace OHOS::Camera
 #endif
@@ -35,6 +35,9 @@ struct BufferTrackingMessage {
 
     // isReturnBack = true indicate a buffer is recycled.
     bool isReturnBack = false;
+
+    // time of the report in microseconds of the monotonic clock, filled in by ReportBufferLocation.
+    uint64_t timestamp = 0;
 };
 
 class TrackingBuffer {
@@ -55,13 +58,50 @@ public:
         return frameNumber_;
     }
 
+    void SetTimestamp(const uint64_t enterTime, const uint64_t beginTime)
+    {
+        enterTime_ = enterTime;
+        beginTime_ = beginTime;
+    }
+
+    // when the buffer was reported to its current node.
+    uint64_t GetEnterTime() const
+    {
+        return enterTime_;
+    }
+
+    // when the buffer was reported to the first node after it left the pool.
+    uint64_t GetBeginTime() const
+    {
+        return beginTime_;
+    }
+
 private:
     TrackingBuffer() = default;
 
 private:
     uint64_t frameNumber_ = 0;
+    uint64_t enterTime_ = 0;
+    uint64_t beginTime_ = 0;
 };
 
 using BufferTraceGraph = std::list<std::pair<std::string, std::list<TrackingBuffer>>>;
+
+// percentiles are the upper bound of their histogram bucket, which is at most 1/8 above the sample.
+struct LatencyStatistics {
+    uint64_t count = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+};
+
+// latencies of a tracking stream in microseconds.
+struct BufferLatency {
+    // residency of buffers in each node, from the report of the node to the report of the next one.
+    std::map<std::string, LatencyStatistics> nodes;
+    // from the report of the first node to the return back to the pool.
+    LatencyStatistics endToEnd;
+};
 } // namespace OHOS::Camera
 #endif
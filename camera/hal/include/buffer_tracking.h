@@ -23,14 +23,11 @@
 
 #define POOL_REPORT_BUFFER_LOCATION(I, F) TRACKING_REPORT_BUFFER_LOCATION(I, F, "", true);
 
-#define TRACKING_REPORT_BUFFER_LOCATION(I, F, N, R)         \
-    do {                                                    \
-        auto m = std::make_shared<BufferTrackingMessage>(); \
-        m->trackingId = I;                                  \
-        m->frameNumber = F;                                 \
-        m->nodeName = N;                                    \
-        m->isReturnBack = R;                                \
-        BufferTracking::ReportBufferLocation(m);            \
+#define TRACKING_REPORT_BUFFER_LOCATION(I, F, N, R)             \
+    do {                                                        \
+        if (BufferTracking::IsTracking()) {                     \
+            BufferTracking::ReportBufferLocation(I, F, N, R);   \
+        }                                                       \
     } while (0);
 
 namespace OHOS::Camera {
@@ -55,13 +52,18 @@ public:
      * BUFFERPOOL---->SOURCENODE----->NODE----->NODE----->NODE---->SINKNODE---->BUFFERPOOL
      */
     static void ReportBufferLocation(const std::shared_ptr<BufferTrackingMessage>& message);
+    static void ReportBufferLocation(const int32_t trackingId, const uint64_t frameNumber, const std::string& node,
+        const bool isReturnBack);
 
-    // start a thread to tracking buffers of a stream.
+    // start tracking buffers, reports are handled right on the reporting threads.
     static void StartTracking();
 
     // stop stacking
     static void StopTracking();
 
+    // reports are dropped unless tracking is started, it's off by default.
+    static bool IsTracking();
+
     // check if there are buffers in a specific node.
     static int32_t IsNodeEmpty(const int32_t id, const std::string node);
 
@@ -69,6 +71,12 @@ public:
     static int32_t IsNodeEmpty(const int32_t id, const std::string beginNode, const std::string endNode);
 
     static void DumpBufferTrace(const int32_t id, BufferTraceGraph& graph);
+
+    // latency histograms of a stream, collected since it's added to tracking.
+    static RetCode GetBufferLatency(const int32_t id, BufferLatency& latency);
+
+    // write the latencies of a stream to a text file.
+    static RetCode DumpBufferLatency(const int32_t id, const std::string& path);
 };
 } // namespace OHOS::Camera
 #endif
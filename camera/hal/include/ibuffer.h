@@ -17,6 +17,7 @@
 #define HOS_CAMERA_IBUFFER_H
 
 #include "camera.h"
+#include <memory>
 
 namespace OHOS::Camera {
 enum CameraBufferStatus {
@@ -25,6 +26,8 @@ enum CameraBufferStatus {
     CAMERA_BUFFER_STATUS_INVALID,
 };
 
+class IBufferPool;
+
 class IBuffer {
 public:
     virtual ~IBuffer(){};
@@ -50,6 +53,8 @@ public:
     virtual EsFrmaeInfo GetEsFrameInfo() const = 0;
     virtual int32_t GetEncodeType() const = 0;
     virtual int32_t GetStreamId() const = 0;
+    // pool which the buffer belongs to, it's null if the pool is gone. it saves a lookup of pool id.
+    virtual std::shared_ptr<IBufferPool> GetPool() const = 0;
 
     virtual void SetIndex(const int32_t index) = 0;
     virtual void SetWidth(const uint32_t width) = 0;
@@ -74,6 +79,7 @@ public:
     virtual void SetEsKeyFrame(const int32_t isKey) = 0;
     virtual void SetEsFrameNum(const int32_t frameNum) = 0;
     virtual void SetStreamId(const int32_t streamId) = 0;
+    virtual void SetPool(const std::weak_ptr<IBufferPool>& pool) = 0;
 
     virtual void Free() = 0;
 
@@ -17,9 +17,18 @@
 #define HOS_CAMERA_IBUFFER_POOL_H
 
 #include "ibuffer.h"
+#include <chrono>
+#include <functional>
 #include <memory>
 
 namespace OHOS::Camera {
+// counters of buffers owned by a pool, external buffers are not counted as allocated.
+struct BufferPoolStatistics {
+    uint32_t allocatedCount = 0; // buffers allocated at present
+    uint32_t peakInUseCount = 0; // max buffers acquired at the same time
+    uint32_t trimmedCount = 0;   // buffers released by trimming
+};
+
 class IBufferPool {
 public:
     virtual ~IBufferPool(){};
@@ -41,6 +50,14 @@ public:
      * timeout > 0, wait for timeout seconds, if timeout return null.
      */
     virtual std::shared_ptr<IBuffer> AcquireBuffer(int timeout) = 0;
+
+    /* request a idle buffer from pool with sub-second granularity, so that a late frame
+     * can be dropped within one frame interval.
+     * timeout < 0, wait until there is idle buffer in pool.
+     * timeout = 0, no wait, could return null.
+     * timeout > 0, wait for timeout, if timeout return null.
+     */
+    virtual std::shared_ptr<IBuffer> AcquireBuffer(const std::chrono::microseconds& timeout) = 0;
     std::shared_ptr<IBuffer> AcquireBuffer()
     {
         return AcquireBuffer(0);
@@ -49,6 +66,13 @@ public:
     // return a buffer to pool.
     virtual RetCode ReturnBuffer(std::shared_ptr<IBuffer>& buffer) = 0;
 
+    /* share a buffer in use with another consumer without copy. return a view of the same memory,
+     * which carries its own meta data. the view must be returned to this pool like an acquired buffer,
+     * the buffer becomes idle only after itself and all of its views are returned.
+     * a view which is released without return is returned when its last reference goes.
+     */
+    virtual std::shared_ptr<IBuffer> ShareBuffer(const std::shared_ptr<IBuffer>& buffer) = 0;
+
     // enable tracking buffers of pool
     virtual void EnableTracking(const int32_t id) = 0;
     virtual void SetId(const int64_t id) = 0;
@@ -56,6 +80,23 @@ public:
     virtual void NotifyStart() = 0;
     virtual void ClearBuffers() = 0;
     virtual uint32_t GetIdleBufferCount() = 0;
+
+    /* make pool elastic, must be called before Init.
+     * buffers are allocated on demand when no idle buffer is left, up to maxCount,
+     * by acquires without wait too, so callers which drain a pool take only its idle buffers.
+     * idle buffers above lowWatermark are trimmed in background.
+     * return RC_ERROR if maxCount is 0 or less than lowWatermark, Init fails if maxCount is less than count.
+     */
+    virtual RetCode SetElasticPolicy(const uint32_t maxCount, const uint32_t lowWatermark) = 0;
+
+    // release idle buffers of an elastic pool, which are not needed since last trimming.
+    virtual void TrimBuffers() = 0;
+    virtual BufferPoolStatistics GetStatistics() = 0;
+
+    /* callback when a buffer becomes idle, for consumers which wait for buffers in an event loop.
+     * it's called with the pool locked, so it must be short, e.g. a wakeup. null removes it.
+     */
+    virtual void SetIdleCallback(const std::function<void()>& callback) = 0;
 };
 } // namespace OHOS::Camera
 
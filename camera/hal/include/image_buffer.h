@@ -53,6 +53,7 @@ public:
     virtual EsFrmaeInfo GetEsFrameInfo() const override;
     virtual int32_t GetEncodeType() const override;
     virtual int32_t GetStreamId() const override;
+    virtual std::shared_ptr<IBufferPool> GetPool() const override;
 
     virtual void SetIndex(const int32_t index) override;
     virtual void SetWidth(const uint32_t width) override;
@@ -77,6 +78,7 @@ public:
     virtual void SetEsKeyFrame(const int32_t isKey) override;
     virtual void SetEsFrameNum(const int32_t frameNum) override;
     virtual void SetStreamId(const int32_t streamId) override;
+    virtual void SetPool(const std::weak_ptr<IBufferPool>& pool) override;
 
     virtual void Free() override;
     virtual bool operator==(const IBuffer& u) override;
@@ -103,7 +105,8 @@ private:
     int32_t encodeType_ = 0;
     EsFrmaeInfo esInfo_ = {-1, -1, -1, -1, -1};
     int32_t streamId_ = -1;
-    std::mutex l_;
+    std::weak_ptr<IBufferPool> pool_;
+    mutable std::mutex l_;
 };
 } // namespace OHOS::Camera
 #endif
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_SPSC_QUEUE_H
+#define HOS_CAMERA_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace OHOS::Camera {
+// bounded lock-free queue for exactly one producer thread and one consumer thread.
+template<typename T>
+class SpscQueue {
+public:
+    // capacity is rounded up to a power of 2.
+    explicit SpscQueue(const uint32_t capacity)
+    {
+        uint32_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        items_.resize(size);
+        mask_ = size - 1;
+    }
+
+    // called by the producer, false if the queue is full.
+    bool Push(T&& item)
+    {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        items_[tail & mask_] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // called by the consumer, false if the queue is empty.
+    bool Pop(T& item)
+    {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(items_[head & mask_]);
+        items_[head & mask_] = T();
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> items_;
+    uint32_t mask_ = 0;
+    // head and tail are written by different threads, keep them on different cache lines.
+    alignas(64) std::atomic<uint32_t> head_ = 0; // 64: cache line size
+    alignas(64) std::atomic<uint32_t> tail_ = 0; // 64: cache line size
+};
+} // namespace OHOS::Camera
+#endif
@@ -36,8 +36,11 @@ struct StreamConfiguration {
     int32_t minFrameDuration;
     int32_t encodeType;
     uint32_t bufferCount;
+    bool adaptiveBufferCount;
     int32_t maxBatchCaptureCount;
     int32_t maxCaptureCount;
+    int32_t memoryType;
+    uint32_t maxBufferCount;
 };
 
 struct DeviceStreamSetting {
@@ -27,7 +27,10 @@ struct HostStreamInfo {
     uint64_t usage_;
     uint64_t bufferPoolId_;
     uint32_t bufferCount_;
+    uint32_t maxBufferCount_ = 0;
     int32_t encodeType_;
+    StreamMemoryType memoryType_ = MEMORY_TYPE_USERPTR;
+    int32_t minFrameDuration_ = 0;
     bool builed_ = false;
 };
 using HostStreamInfo = struct HostStreamInfo;
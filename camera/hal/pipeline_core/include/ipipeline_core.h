@@ -27,6 +27,8 @@ public:
     virtual std::shared_ptr<HostStreamMgr> GetHostStreamMgr() const = 0;
     virtual std::shared_ptr<IStreamPipelineCore> GetStreamPipelineCore() const = 0;
     virtual void UpdateMetadata(std::shared_ptr<CameraStandard::CameraMetadata> meta)  = 0;
+    // changed by every UpdateMetadata, settings applied by streams before may be overridden since.
+    virtual uint64_t GetMetadataVersion() const = 0;
     virtual ~IPipelineCore() = default;
 };
 }
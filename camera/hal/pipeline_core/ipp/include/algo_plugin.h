@@ -20,7 +20,9 @@
 #include "camera_metadata_info.h"
 #include "ibuffer.h"
 #include "ipp_algo.h"
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -42,9 +44,23 @@ public:
                     std::shared_ptr<CameraStandard::CameraMetadata>& meta);
     RetCode Stop();
     std::string GetName() const;
+    // number of frames the algorithm may process at the same time, 1 if it isn't reentrant.
+    void SetWorkerCount(uint32_t count);
+    uint32_t GetWorkerCount() const;
+    // number of IppAlgoBuffer descriptors allocated since Init, it stays unchanged in steady state.
+    uint32_t GetAlgoBufferAllocCount() const;
 
 private:
+    // descriptors handed to algorithm for one Process call.
+    struct AlgoBufferSet {
+        std::vector<IppAlgoBuffer> inBuffers;
+        std::vector<IppAlgoBuffer*> inBufferList;
+        IppAlgoBuffer outBuffer;
+    };
+
     RetCode CheckLibPath(const char *path);
+    std::unique_ptr<AlgoBufferSet> AcquireAlgoBufferSet(size_t inBufferCount);
+    void ReleaseAlgoBufferSet(std::unique_ptr<AlgoBufferSet>& bufferSet);
 
 public:
     struct IppAlgoHandler {
@@ -57,7 +73,12 @@ private:
     std::string desc_ = "";
     std::string name_ = "";
     int mode_ = -1;
+    uint32_t workerCount_ = 1;
     IppAlgoHandler* algoHandler_ = nullptr;
+
+    std::mutex algoBufferLock_;
+    std::vector<std::unique_ptr<AlgoBufferSet>> algoBufferSets_ = {};
+    std::atomic<uint32_t> algoBufferAllocCount_ = 0;
 };
 } // namespace OHOS::Camera
 #endif
@@ -35,6 +35,7 @@ public:
     virtual void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) override;
     virtual void DeliverBuffers(std::vector<std::shared_ptr<IBuffer>>& buffers) override;
     virtual void ProcessCache(std::vector<std::shared_ptr<IBuffer>>& buffers) override;
+    virtual void DeliverProcessedCache(std::vector<std::shared_ptr<IBuffer>>& buffers) override;
     virtual void DeliverCache(std::vector<std::shared_ptr<IBuffer>>& buffers) override;
     virtual void DeliverCancelCache(std::vector<std::shared_ptr<IBuffer>>& buffers) override;
 
@@ -49,6 +50,7 @@ protected:
 protected:
     std::shared_ptr<AlgoPluginManager> algoPluginManager_ = nullptr;
     std::shared_ptr<AlgoPlugin> algoPlugin_ = nullptr;
+    std::shared_ptr<IBufferPool> outPool_ = nullptr;
 };
 } // namespace OHOS::Camera
 
@@ -21,10 +21,13 @@
 #include <atomic>
 #include <condition_variable>
 #include <functional>
-#include <list>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace OHOS::Camera {
 class OfflinePipeline {
@@ -32,6 +35,8 @@ public:
     OfflinePipeline();
     virtual ~OfflinePipeline();
     void DeliverCacheCheck(std::vector<std::shared_ptr<IBuffer>>& buffers);
+    // number of caches processed at the same time, takes effect at next StartProcess.
+    void SetWorkerCount(uint32_t count);
     RetCode StartProcess();
     RetCode StopProcess();
     void BindOfflineStreamCallback(std::function<void(std::shared_ptr<IBuffer>&)>& callback);
@@ -43,25 +48,42 @@ public:
     bool CheckOwnerOfCaptureId(int32_t captureId);
 
     virtual void DeliverOfflineBuffer(std::shared_ptr<IBuffer>& buffer);
+    // runs on the workers in parallel, buffers hold the result for DeliverProcessedCache afterwards.
     virtual void ProcessCache(std::vector<std::shared_ptr<IBuffer>>& buffers);
+    // called one by one in the order in which caches are received.
+    virtual void DeliverProcessedCache(std::vector<std::shared_ptr<IBuffer>>& buffers);
     virtual void DeliverCache(std::vector<std::shared_ptr<IBuffer>>& buffers);
     virtual void DeliverCancelCache(std::vector<std::shared_ptr<IBuffer>>& buffers);
 
 public:
     std::atomic<bool> offlineMode_ = false;
-    std::list<std::vector<std::shared_ptr<IBuffer>>> bufferCache_ = {};
     std::function<void(std::shared_ptr<IBuffer>&)> callback_ = nullptr;
 
 private:
+    struct OfflineCache {
+        int32_t captureId = -1;
+        std::vector<std::shared_ptr<IBuffer>> buffers = {};
+    };
+
     void HandleBuffers();
+    void DeliverCompletedCaches();
+    void RemoveFromIndex(int32_t captureId, uint64_t sequence);
 
 private:
     std::mutex cbLock_;
     std::mutex queueLock_;
     std::condition_variable cv_;
     std::atomic<bool> running_ = false;
-    std::thread* processThread_ = nullptr;
-    uint64_t frameCount_ = 0;
+    uint32_t workerCount_ = 1;
+    std::vector<std::thread> workers_ = {};
+    uint64_t sequence_ = 0;
+    // caches waiting for a worker, processed by workers and completed out of order, all keyed by receive sequence.
+    std::map<uint64_t, OfflineCache> pendingCaches_ = {};
+    std::set<uint64_t> processingCaches_ = {};
+    std::map<uint64_t, OfflineCache> completedCaches_ = {};
+    // sequences of the caches which are not delivered yet for each capture.
+    std::unordered_map<int32_t, std::set<uint64_t>> captureIndex_ = {};
+    bool delivering_ = false;
 };
 } // namespace OHOS::Camera
 #endif
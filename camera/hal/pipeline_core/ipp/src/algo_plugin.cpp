@@ -16,6 +16,12 @@
 #include <dlfcn.h>
 
 namespace OHOS::Camera {
+namespace {
+    // one set for each Process call running at the same time, more are allocated on demand.
+    constexpr uint32_t ALGO_BUFFER_SET_COUNT = 2;
+    constexpr uint32_t ALGO_IN_BUFFER_COUNT = 4;
+}
+
 AlgoPlugin::AlgoPlugin(std::string name, std::string description, int mode, std::string path)
 {
     name_ = name;
@@ -39,6 +45,19 @@ RetCode AlgoPlugin::Init(std::shared_ptr<CameraStandard::CameraMetadata> meta)
         CAMERA_LOGE("unsupport operation.");
         return RC_ERROR;
     }
+    {
+        std::lock_guard<std::mutex> l(algoBufferLock_);
+        algoBufferSets_.clear();
+        algoBufferSets_.reserve(ALGO_BUFFER_SET_COUNT);
+        for (uint32_t i = 0; i < ALGO_BUFFER_SET_COUNT; i++) {
+            auto bufferSet = std::make_unique<AlgoBufferSet>();
+            bufferSet->inBuffers.resize(ALGO_IN_BUFFER_COUNT);
+            bufferSet->inBufferList.resize(ALGO_IN_BUFFER_COUNT);
+            algoBufferSets_.emplace_back(std::move(bufferSet));
+        }
+        algoBufferAllocCount_ = 0;
+    }
+
     // parse metadata
     int ret = algoHandler_->func.Init(nullptr);
     if (ret == 0) {
@@ -88,44 +107,32 @@ RetCode AlgoPlugin::Process(std::shared_ptr<IBuffer>& outBuffer,
         return RC_ERROR;
     }
 
+    std::unique_ptr<AlgoBufferSet> bufferSet = AcquireAlgoBufferSet(inBuffers.size());
     IppAlgoBuffer* outAlgoBuffer = nullptr;
-    if (outBuffer == nullptr) {
-        outAlgoBuffer = nullptr;
-    } else {
-        outAlgoBuffer = new IppAlgoBuffer();
-        if (outAlgoBuffer != nullptr) {
-            outAlgoBuffer->addr = outBuffer->GetVirAddress();
-            outAlgoBuffer->size = outBuffer->GetSize();
-        }
+    if (outBuffer != nullptr) {
+        outAlgoBuffer = &bufferSet->outBuffer;
+        *outAlgoBuffer = {};
+        outAlgoBuffer->addr = outBuffer->GetVirAddress();
+        outAlgoBuffer->size = outBuffer->GetSize();
     }
 
-    IppAlgoBuffer** inAlgoBuffers = new IppAlgoBuffer* [inBuffers.size()];
     for (int i = 0; i < inBuffers.size(); i++) {
         if (inBuffers[i] == nullptr) {
-            inAlgoBuffers[i] = nullptr;
+            bufferSet->inBufferList[i] = nullptr;
         } else {
-            inAlgoBuffers[i] = new IppAlgoBuffer();
-            inAlgoBuffers[i]->addr = inBuffers[i]->GetVirAddress();
-            inAlgoBuffers[i]->size = inBuffers[i]->GetSize();
-            inAlgoBuffers[i]->width = inBuffers[i]->GetWidth();
-            inAlgoBuffers[i]->height = inBuffers[i]->GetHeight();
-            inAlgoBuffers[i]->stride = inBuffers[i]->GetStride();
-            inAlgoBuffers[i]->id = i;
+            IppAlgoBuffer* inAlgoBuffer = &bufferSet->inBuffers[i];
+            inAlgoBuffer->addr = inBuffers[i]->GetVirAddress();
+            inAlgoBuffer->size = inBuffers[i]->GetSize();
+            inAlgoBuffer->width = inBuffers[i]->GetWidth();
+            inAlgoBuffer->height = inBuffers[i]->GetHeight();
+            inAlgoBuffer->stride = inBuffers[i]->GetStride();
+            inAlgoBuffer->id = i;
+            bufferSet->inBufferList[i] = inAlgoBuffer;
         }
     }
 
-    int ret = algoHandler_->func.Process(inAlgoBuffers, inBuffers.size(), outAlgoBuffer, nullptr);
-    if (outAlgoBuffer != nullptr) {
-        delete outAlgoBuffer;
-        outAlgoBuffer = nullptr;
-    }
-
-    for (int i = 0; i < inBuffers.size(); i++) {
-        if (inAlgoBuffers[i] != nullptr) {
-            delete inAlgoBuffers[i];
-            inAlgoBuffers[i] = nullptr;
-        }
-    }
+    int ret = algoHandler_->func.Process(bufferSet->inBufferList.data(), inBuffers.size(), outAlgoBuffer, nullptr);
+    ReleaseAlgoBufferSet(bufferSet);
 
     if (ret != 0) {
         CAMERA_LOGE("process algo failed, ret = %{public}d", ret);
@@ -134,6 +141,51 @@ RetCode AlgoPlugin::Process(std::shared_ptr<IBuffer>& outBuffer,
     return RC_OK;
 }
 
+std::unique_ptr<AlgoPlugin::AlgoBufferSet> AlgoPlugin::AcquireAlgoBufferSet(size_t inBufferCount)
+{
+    std::unique_ptr<AlgoBufferSet> bufferSet = nullptr;
+    {
+        std::lock_guard<std::mutex> l(algoBufferLock_);
+        if (!algoBufferSets_.empty()) {
+            bufferSet = std::move(algoBufferSets_.back());
+            algoBufferSets_.pop_back();
+        }
+    }
+
+    if (bufferSet == nullptr) {
+        bufferSet = std::make_unique<AlgoBufferSet>();
+        algoBufferAllocCount_++;
+    }
+    if (bufferSet->inBuffers.size() < inBufferCount) {
+        CAMERA_LOGI("algo in buffer count grows to %{public}zu", inBufferCount);
+        bufferSet->inBuffers.resize(inBufferCount);
+        bufferSet->inBufferList.resize(inBufferCount);
+        algoBufferAllocCount_++;
+    }
+    return bufferSet;
+}
+
+void AlgoPlugin::ReleaseAlgoBufferSet(std::unique_ptr<AlgoBufferSet>& bufferSet)
+{
+    std::lock_guard<std::mutex> l(algoBufferLock_);
+    algoBufferSets_.emplace_back(std::move(bufferSet));
+}
+
+void AlgoPlugin::SetWorkerCount(uint32_t count)
+{
+    workerCount_ = count == 0 ? 1 : count;
+}
+
+uint32_t AlgoPlugin::GetWorkerCount() const
+{
+    return workerCount_;
+}
+
+uint32_t AlgoPlugin::GetAlgoBufferAllocCount() const
+{
+    return algoBufferAllocCount_;
+}
+
 RetCode AlgoPlugin::Stop()
 {
     if (algoHandler_->func.Stop == nullptr) {
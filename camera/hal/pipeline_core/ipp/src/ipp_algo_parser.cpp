@@ -130,6 +130,11 @@ std::shared_ptr<AlgoPlugin> IppAlgoParser::ConstructPlugin(const DeviceResourceN
         return nullptr;
     }
 
+    // optional, algorithms which are reentrant may process several captures in parallel.
+    uint32_t workerCount = 1;
+    devResInstance_->GetUint32(node, "workerCount", &workerCount, 1);
+    plugin->SetWorkerCount(workerCount);
+
     return plugin;
 }
 } // namespace OHOS::Camera
@@ -45,11 +45,22 @@ RetCode IppNode::Init(const int32_t streamId)
 RetCode IppNode::Start(const int32_t streamId)
 {
     NodeBase::Start(streamId);
+    // the output pool is resolved once, frames don't look it up in the buffer manager.
+    outPool_ = nullptr;
+    auto outPort = GetOutPortById(0);
+    if (outPort != nullptr) {
+        PortFormat format {};
+        outPort->GetFormat(format);
+        outPool_ = BufferManager::GetInstance()->GetBufferPool(format.bufferPoolId_);
+    }
     // start offline stream process thread
     if (offlineMode_.load()) {
         return RC_OK;
     }
     algoPlugin_ = algoPluginManager_->GetAlgoPlugin(IPP_ALGO_MODE_NORMAL);
+    if (algoPlugin_ != nullptr) {
+        SetWorkerCount(algoPlugin_->GetWorkerCount());
+    }
     StartProcess();
     return RC_OK;
 }
@@ -111,11 +122,12 @@ void IppNode::DeliverBuffers(std::vector<std::shared_ptr<IBuffer>>& buffers)
 
 void IppNode::ProcessCache(std::vector<std::shared_ptr<IBuffer>>& buffers)
 {
-    // process buffers with algorithm
+    // process buffers with algorithm, the product is put in front of the buffers to recycle.
     std::shared_ptr<IBuffer> outBuffer = nullptr;
     RetCode ret = GetOutputBuffer(buffers, outBuffer);
     if (ret != RC_OK) {
         CAMERA_LOGE("fatal error, can't get output buffer, ipp will do nothing.");
+        buffers.insert(buffers.begin(), nullptr);
         return;
     }
     std::shared_ptr<CameraStandard::CameraMetadata> meta = nullptr;
@@ -128,12 +140,27 @@ void IppNode::ProcessCache(std::vector<std::shared_ptr<IBuffer>>& buffers)
     std::vector<std::shared_ptr<IBuffer>> recycleBuffers{};
     ClassifyOutputBuffer(outBuffer, buffers, algoProduct, recycleBuffers);
 
-    DeliverAlgoProductBuffer(algoProduct);
-    DeliverCache(recycleBuffers);
+    buffers.clear();
+    buffers.emplace_back(algoProduct);
+    buffers.insert(buffers.end(), recycleBuffers.begin(), recycleBuffers.end());
     CAMERA_LOGV("process algo completed.");
     return;
 }
 
+void IppNode::DeliverProcessedCache(std::vector<std::shared_ptr<IBuffer>>& buffers)
+{
+    if (buffers.empty()) {
+        return;
+    }
+    std::shared_ptr<IBuffer> algoProduct = buffers[0];
+    std::vector<std::shared_ptr<IBuffer>> recycleBuffers(buffers.begin() + 1, buffers.end());
+    if (algoProduct != nullptr) {
+        DeliverAlgoProductBuffer(algoProduct);
+    }
+    DeliverCache(recycleBuffers);
+    return;
+}
+
 void IppNode::DeliverCache(std::vector<std::shared_ptr<IBuffer>>& buffers)
 {
     OfflinePipeline::DeliverCacheCheck(buffers);
@@ -178,18 +205,12 @@ RetCode IppNode::GetOutputBuffer(std::vector<std::shared_ptr<IBuffer>>& buffers,
         }
     }
 
-    auto bufferManager = BufferManager::GetInstance();
-    if (bufferManager == nullptr) {
-        CAMERA_LOGE("fatal error, can't get buffer manager.");
-        return RC_ERROR;
-    }
-    auto bufferPool = bufferManager->GetBufferPool(id);
-    if (bufferPool == nullptr) {
+    if (outPool_ == nullptr) {
         CAMERA_LOGE("fatal error, can't get buffer pool.");
         return RC_ERROR;
     }
 
-    outBuffer = bufferPool->AcquireBuffer(-1);
+    outBuffer = outPool_->AcquireBuffer(-1);
 
     return RC_OK;
 }
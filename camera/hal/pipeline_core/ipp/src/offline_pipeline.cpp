@@ -16,6 +16,7 @@
 #include "offline_pipeline.h"
 #include "buffer_manager.h"
 #include "ibuffer_pool.h"
+#include <string>
 #include <vector>
 
 namespace OHOS::Camera {
@@ -24,40 +25,70 @@ OfflinePipeline::OfflinePipeline() {}
 OfflinePipeline::~OfflinePipeline()
 {
     StopProcess();
-    bufferCache_.clear();
+}
+
+void OfflinePipeline::SetWorkerCount(uint32_t count)
+{
+    workerCount_ = count == 0 ? 1 : count;
 }
 
 RetCode OfflinePipeline::StartProcess()
 {
+    if (!workers_.empty()) {
+        return RC_OK;
+    }
     running_ = true;
-    processThread_ = new std::thread([this]() {
-        prctl(PR_SET_NAME, "offlinepipeline");
-        while (running_) {
-            HandleBuffers();
-        }
-    });
-    if (processThread_ == nullptr) {
-        return RC_ERROR;
+    CAMERA_LOGI("start offline pipeline with %{public}u workers", workerCount_);
+    for (uint32_t i = 0; i < workerCount_; i++) {
+        workers_.emplace_back([this, i]() {
+            std::string threadName = "offlinepipe#" + std::to_string(i);
+            prctl(PR_SET_NAME, threadName.c_str());
+            while (running_) {
+                HandleBuffers();
+            }
+        });
     }
     return RC_OK;
 }
 
 RetCode OfflinePipeline::StopProcess()
 {
-    if (processThread_ == nullptr) {
+    if (workers_.empty()) {
         CAMERA_LOGE("cannot stop.");
         return RC_ERROR;
     }
 
-    if (running_.load() == false) {
-        return RC_OK;
+    {
+        std::unique_lock<std::mutex> l(queueLock_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    for (auto& it : workers_) {
+        it.join();
     }
+    workers_.clear();
 
-    running_ = false;
-    cv_.notify_one();
-    processThread_->join();
-    delete processThread_;
-    processThread_ = nullptr;
+    // no worker holds a cache any more, the caches left go back to their pools before stop returns.
+    // processed ones are delivered as usual, the others are dropped.
+    std::map<uint64_t, OfflineCache> completedCaches = {};
+    std::map<uint64_t, OfflineCache> pendingCaches = {};
+    {
+        std::unique_lock<std::mutex> l(queueLock_);
+        completedCaches.swap(completedCaches_);
+        pendingCaches.swap(pendingCaches_);
+        captureIndex_.clear();
+    }
+    for (auto& cache : completedCaches) {
+        DeliverProcessedCache(cache.second.buffers);
+    }
+    for (auto& cache : pendingCaches) {
+        for (auto it : cache.second.buffers) {
+            it->SetBufferStatus(CAMERA_BUFFER_STATUS_DROP);
+        }
+        DeliverCancelCache(cache.second.buffers);
+    }
+    CAMERA_LOGI("offline pipeline stopped, %{public}zu caches delivered, %{public}zu dropped",
+        completedCaches.size(), pendingCaches.size());
     return RC_OK;
 }
 
@@ -77,34 +108,35 @@ void OfflinePipeline::SwitchToOfflineMode()
 RetCode OfflinePipeline::CancelCapture(int32_t captureId)
 {
     CAMERA_LOGE("cancel capture begin");
-    if (bufferCache_.empty()) {
-        CAMERA_LOGE("cancel capture failed, capture id = %{public}d doesn't exist", captureId);
-        return RC_ERROR;
-    }
-
-    std::vector<std::shared_ptr<IBuffer>> cache = {};
+    std::vector<OfflineCache> caches = {};
     {
         std::unique_lock<std::mutex> l(queueLock_);
-        auto it = std::find_if(bufferCache_.begin(), bufferCache_.end(),
-            [&captureId](const std::vector<std::shared_ptr<IBuffer>>& c) {
-                for (auto b : c) {
-                    if (b->GetCaptureId() == captureId) {
-                        return true;
-                    }
-                }
-                return false;
-            });
-        if (it == bufferCache_.end()) {
+        auto index = captureIndex_.find(captureId);
+        if (index == captureIndex_.end()) {
             CAMERA_LOGE("cancel capture failed, capture id = %{public}d doesn't exist", captureId);
-            return RC_OK;
+            return captureIndex_.empty() ? RC_ERROR : RC_OK;
+        }
+        // caches already taken by a worker are delivered as usual.
+        for (auto it = index->second.begin(); it != index->second.end();) {
+            auto cache = pendingCaches_.find(*it);
+            if (cache == pendingCaches_.end()) {
+                ++it;
+                continue;
+            }
+            caches.emplace_back(std::move(cache->second));
+            pendingCaches_.erase(cache);
+            it = index->second.erase(it);
+        }
+        if (index->second.empty()) {
+            captureIndex_.erase(index);
         }
-        cache = *it;
-        bufferCache_.erase(it);
     }
-    for (auto it : cache) {
-        it->SetBufferStatus(CAMERA_BUFFER_STATUS_DROP);
+    for (auto& cache : caches) {
+        for (auto it : cache.buffers) {
+            it->SetBufferStatus(CAMERA_BUFFER_STATUS_DROP);
+        }
+        DeliverCancelCache(cache.buffers);
     }
-    DeliverCancelCache(cache);
     CAMERA_LOGE("cancel capture end");
     return RC_OK;
 }
@@ -116,31 +148,39 @@ RetCode OfflinePipeline::FlushOfflineStream()
         return RC_ERROR;
     }
 
-    if (!bufferCache_.empty()) {
+    std::map<uint64_t, OfflineCache> caches = {};
+    {
         std::unique_lock<std::mutex> l(queueLock_);
-        while (!bufferCache_.empty()) {
-            auto cache = bufferCache_.front();
-            bufferCache_.pop_front();
-
-            for (auto it : cache) {
-                it->SetBufferStatus(CAMERA_BUFFER_STATUS_DROP);
-            }
-            DeliverCancelCache(cache);
+        caches.swap(pendingCaches_);
+        for (auto& it : caches) {
+            RemoveFromIndex(it.second.captureId, it.first);
         }
     }
+    for (auto& cache : caches) {
+        for (auto it : cache.second.buffers) {
+            it->SetBufferStatus(CAMERA_BUFFER_STATUS_DROP);
+        }
+        DeliverCancelCache(cache.second.buffers);
+    }
 
     return RC_OK;
 }
 
 void OfflinePipeline::ReceiveCache(std::vector<std::shared_ptr<IBuffer>>& buffers)
 {
-    if (!buffers.empty() && buffers[0]->GetBufferStatus() != CAMERA_BUFFER_STATUS_OK) {
+    if (buffers.empty()) {
+        return;
+    }
+    if (buffers[0]->GetBufferStatus() != CAMERA_BUFFER_STATUS_OK) {
         DeliverCancelCache(buffers);
         return;
     }
 
     std::unique_lock<std::mutex> l(queueLock_);
-    bufferCache_.emplace_back(buffers);
+    uint64_t sequence = sequence_++;
+    int32_t captureId = buffers[0]->GetCaptureId();
+    pendingCaches_.emplace(sequence, OfflineCache {captureId, buffers});
+    captureIndex_[captureId].insert(sequence);
     cv_.notify_one();
 
     return;
@@ -148,51 +188,87 @@ void OfflinePipeline::ReceiveCache(std::vector<std::shared_ptr<IBuffer>>& buffer
 
 void OfflinePipeline::HandleBuffers()
 {
-    if (bufferCache_.empty()) {
+    uint64_t sequence = 0;
+    OfflineCache cache = {};
+    {
         std::unique_lock<std::mutex> l(queueLock_);
-        if (bufferCache_.empty()) {
-            cv_.wait(l, [this] { return !(running_.load() && bufferCache_.empty()); });
+        cv_.wait(l, [this] { return !(running_.load() && pendingCaches_.empty()); });
+        if (running_ == false) {
+            return;
         }
+        auto it = pendingCaches_.begin();
+        sequence = it->first;
+        cache = std::move(it->second);
+        pendingCaches_.erase(it);
+        processingCaches_.insert(sequence);
     }
 
-    if (running_ == false) {
-        return;
+    ProcessCache(cache.buffers);
+    {
+        std::unique_lock<std::mutex> l(queueLock_);
+        processingCaches_.erase(sequence);
+        completedCaches_.emplace(sequence, std::move(cache));
     }
+    DeliverCompletedCaches();
 
-    std::vector<std::shared_ptr<IBuffer>> cache = {};
-    if (!bufferCache_.empty()) {
-        std::unique_lock<std::mutex> l(queueLock_);
-        if (!bufferCache_.empty()) {
-            cache = bufferCache_.front();
-            bufferCache_.pop_front();
+    return;
+}
+
+void OfflinePipeline::DeliverCompletedCaches()
+{
+    std::unique_lock<std::mutex> l(queueLock_);
+    // only one worker delivers at a time, it also picks up the caches completed meanwhile by the others.
+    if (delivering_) {
+        return;
+    }
+    delivering_ = true;
+    while (!completedCaches_.empty()) {
+        auto it = completedCaches_.begin();
+        uint64_t sequence = it->first;
+        if ((!processingCaches_.empty() && *processingCaches_.begin() < sequence) ||
+            (!pendingCaches_.empty() && pendingCaches_.begin()->first < sequence)) {
+            break;
         }
+        OfflineCache cache = std::move(it->second);
+        completedCaches_.erase(it);
+        RemoveFromIndex(cache.captureId, sequence);
+        l.unlock();
+        DeliverProcessedCache(cache.buffers);
+        l.lock();
     }
+    delivering_ = false;
+}
 
-    if (cache.empty()) {
+void OfflinePipeline::RemoveFromIndex(int32_t captureId, uint64_t sequence)
+{
+    auto index = captureIndex_.find(captureId);
+    if (index == captureIndex_.end()) {
         return;
     }
-    ProcessCache(cache);
+    index->second.erase(sequence);
+    if (index->second.empty()) {
+        captureIndex_.erase(index);
+    }
+}
 
+void OfflinePipeline::ProcessCache(std::vector<std::shared_ptr<IBuffer>>& buffers)
+{
     return;
 }
 
-void OfflinePipeline::ProcessCache(std::vector<std::shared_ptr<IBuffer>>& buffers)
+void OfflinePipeline::DeliverProcessedCache(std::vector<std::shared_ptr<IBuffer>>& buffers)
 {
     DeliverCache(buffers);
     return;
 }
+
 void OfflinePipeline::DeliverCacheCheck(std::vector<std::shared_ptr<IBuffer>>& buffers)
 {
     for (auto it : buffers) {
         if (it == nullptr) {
             continue;
         }
-        auto bufferManager = BufferManager::GetInstance();
-        if (bufferManager == nullptr) {
-            CAMERA_LOGE("can't get buffer manager");
-            continue;
-        }
-        auto bufferPool = bufferManager->GetBufferPool(it->GetPoolId());
+        auto bufferPool = it->GetPool();
         if (bufferPool == nullptr) {
             CAMERA_LOGE("can't get buffer pool");
             return;
@@ -236,19 +312,12 @@ void OfflinePipeline::DeliverOfflineBuffer(std::shared_ptr<IBuffer>& buffer)
 bool OfflinePipeline::CacheQueueDry()
 {
     std::unique_lock<std::mutex> l(queueLock_);
-    return bufferCache_.empty();
+    return pendingCaches_.empty() && processingCaches_.empty() && completedCaches_.empty();
 }
 
 bool OfflinePipeline::CheckOwnerOfCaptureId(int32_t captureId)
 {
     std::unique_lock<std::mutex> l(queueLock_);
-    for (auto it : bufferCache_) {
-        for (auto buffer : it) {
-            if (captureId == buffer->GetCaptureId()) {
-                return true;
-            }
-        }
-    }
-    return false;
+    return captureIndex_.find(captureId) != captureIndex_.end();
 }
 } // namespace OHOS::Camera
@@ -25,6 +25,11 @@
 #include <functional>
 
 namespace OHOS::Camera {
+enum PortDirection : int32_t {
+    PORT_DIRECTION_IN = 0,
+    PORT_DIRECTION_OUT = 1,
+};
+
 class INode;
 class IPort : public NoCopyable {
 public:
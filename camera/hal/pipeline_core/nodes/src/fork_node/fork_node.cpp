@@ -23,8 +23,11 @@ ForkNode::ForkNode(const std::string& name, const std::string& type)
 
 ForkNode::~ForkNode()
 {
-    streamRunning_ = false;
-    cv_.notify_all();
+    {
+        std::unique_lock <std::mutex> lck(mtx_);
+        streamRunning_ = false;
+        cv_.notify_all();
+    }
     if (forkThread_ != nullptr) {
         CAMERA_LOGI("forkThread need join");
         forkThread_->join();
@@ -47,13 +50,26 @@ RetCode ForkNode::Start(const int32_t streamId)
 
 RetCode ForkNode::Stop(const int32_t streamId)
 {
-    streamRunning_ = false;
-    cv_.notify_all();
+    {
+        std::unique_lock <std::mutex> lck(mtx_);
+        streamRunning_ = false;
+        cv_.notify_all();
+    }
     if (forkThread_ != nullptr) {
         CAMERA_LOGI("forkThread need join");
         forkThread_->join();
         forkThread_ = nullptr;
     }
+
+    std::shared_ptr<IBuffer> buffer = nullptr;
+    {
+        std::unique_lock <std::mutex> lck(mtx_);
+        buffer = pendingBuffer_;
+        pendingBuffer_ = nullptr;
+    }
+    if (buffer != nullptr) {
+        ReleaseForkBuffer(buffer);
+    }
     return RC_OK;
 }
 
@@ -64,11 +80,8 @@ void ForkNode::DeliverBuffer(std::shared_ptr<IBuffer>& buffer)
         return;
     }
     int32_t id = buffer->GetStreamId();
-    {
-        std::unique_lock <std::mutex> lck(mtx_);
-        tmpBuffer_ = buffer;
-        cv_.notify_one();
-    }
+    // share the frame before it goes downstream, or it may be returned and reused before fork thread reads it.
+    ShareForkBuffer(buffer);
     for (auto& it : outPutPorts_) {
         if (it->format_.streamId_ == id) {
             it->DeliverBuffer(buffer);
@@ -78,45 +91,101 @@ void ForkNode::DeliverBuffer(std::shared_ptr<IBuffer>& buffer)
     }
 }
 
+void ForkNode::ShareForkBuffer(const std::shared_ptr<IBuffer>& buffer)
+{
+    if (streamRunning_ == false) {
+        return;
+    }
+
+    std::shared_ptr<IBufferPool> bufferPool = buffer->GetPool();
+    CHECK_IF_PTR_NULL_RETURN_VOID(bufferPool);
+    std::shared_ptr<IBuffer> sharedBuffer = bufferPool->ShareBuffer(buffer);
+    CHECK_IF_PTR_NULL_RETURN_VOID(sharedBuffer);
+
+    // fork thread is still busy with last frame, drop it and fork the newest one.
+    std::shared_ptr<IBuffer> droppedBuffer = nullptr;
+    {
+        std::unique_lock <std::mutex> lck(mtx_);
+        droppedBuffer = pendingBuffer_;
+        pendingBuffer_ = sharedBuffer;
+        cv_.notify_one();
+    }
+    if (droppedBuffer != nullptr) {
+        ReleaseForkBuffer(droppedBuffer);
+    }
+}
+
+void ForkNode::ReleaseForkBuffer(std::shared_ptr<IBuffer>& buffer)
+{
+    std::shared_ptr<IBufferPool> bufferPool = buffer->GetPool();
+    CHECK_IF_PTR_NULL_RETURN_VOID(bufferPool);
+    bufferPool->ReturnBuffer(buffer);
+}
+
+std::shared_ptr<IBuffer> ForkNode::CopyForkBuffer(const std::shared_ptr<IBufferPool>& bufferPool,
+                                                  std::shared_ptr<IBuffer>& source)
+{
+    CAMERA_LOGI("fork node acquirebuffer enter");
+    std::shared_ptr<IBuffer> buffer = bufferPool->AcquireBuffer();
+    CAMERA_LOGI("fork node acquirebuffer exit");
+    if (buffer == nullptr) {
+        CAMERA_LOGE("acquire buffer failed.");
+    } else if (memcpy_s(buffer->GetVirAddress(), buffer->GetSize(),
+        source->GetVirAddress(), source->GetSize()) != 0) {
+        CAMERA_LOGE("memcpy_s failed.");
+    }
+    ReleaseForkBuffer(source);
+    return buffer;
+}
+
 void ForkNode::ForkBuffers()
 {
     int32_t id = 0;
     uint64_t bufferPoolId = 0;
+    uint64_t usage = 0;
     for (auto& in : inPutPorts_) {
         for (auto& out : outPutPorts_) {
             if (out->format_.streamId_ != in->format_.streamId_) {
                 id = out->format_.streamId_;
                 bufferPoolId = out->format_.bufferPoolId_;
+                usage = out->format_.usage_;
                 CAMERA_LOGI("fork buffer get buffer streamId = %{public}d", out->format_.streamId_);
             }
         }
     }
-    forkThread_ = std::make_shared<std::thread>([this, id, bufferPoolId] {
+    forkThread_ = std::make_shared<std::thread>([this, id, bufferPoolId, usage] {
         prctl(PR_SET_NAME, "fork_buffers");
-        BufferManager* bufferManager = Camera::BufferManager::GetInstance();
-        std::shared_ptr<FrameSpec> frameSpec = std::make_shared<FrameSpec>();
-        std::shared_ptr<IBuffer> buffer = nullptr;
+        std::shared_ptr<IBufferPool> bufferPool = Camera::BufferManager::GetInstance()->GetBufferPool(bufferPoolId);
         while (streamRunning_ == true) {
+            std::shared_ptr<IBuffer> source = nullptr;
             {
                 std::unique_lock <std::mutex> lck(mtx_);
-                cv_.wait(lck);
-                std::shared_ptr<IBufferPool> bufferPool = bufferManager->GetBufferPool(bufferPoolId);
+                cv_.wait(lck, [this] {
+                    return pendingBuffer_ != nullptr || streamRunning_ == false;
+                });
+                source = pendingBuffer_;
+                pendingBuffer_ = nullptr;
+            }
+            if (source == nullptr) {
+                continue;
+            }
+
+            // a consumer in pipeline which only reads from the pool of the frame gets the shared view,
+            // a tunnel has a pool of its own and a writer can't change the frame, so they get a copy.
+            std::shared_ptr<IBuffer> buffer = source;
+            if (source->GetPoolId() != static_cast<int64_t>(bufferPoolId) ||
+                (usage & CAMERA_USAGE_SW_WRITE_OFTEN) != 0) {
                 if (bufferPool == nullptr) {
                     CAMERA_LOGE("get bufferpool failed");
-                    return RC_ERROR;
-                }
-                CAMERA_LOGI("fork node acquirebuffer enter");
-                buffer = bufferPool->AcquireBuffer();
-                CAMERA_LOGI("fork node acquirebuffer exit");
-                if (buffer == nullptr) {
-                    CAMERA_LOGE("acquire buffer failed.");
+                    ReleaseForkBuffer(source);
                     continue;
                 }
-                if (memcpy_s(buffer->GetVirAddress(), buffer->GetSize(),
-                    tmpBuffer_->GetVirAddress(), tmpBuffer_->GetSize()) != 0) {
-                        CAMERA_LOGE("memcpy_s failed.");
-                }
+                buffer = CopyForkBuffer(bufferPool, source);
             }
+            if (buffer == nullptr) {
+                continue;
+            }
+
             for (auto& it : outPutPorts_) {
                 if (it->format_.streamId_ == id) {
                     CAMERA_LOGI("fork node deliver buffer streamid = %{public}d", it->format_.streamId_);
@@ -126,7 +195,6 @@ void ForkNode::ForkBuffers()
             }
         }
         CAMERA_LOGI("fork thread closed");
-        return RC_OK;
     });
     return;
 }
@@ -31,11 +31,17 @@ public:
     void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) override;
     void ForkBuffers();
 
+private:
+    void ShareForkBuffer(const std::shared_ptr<IBuffer>& buffer);
+    void ReleaseForkBuffer(std::shared_ptr<IBuffer>& buffer);
+    std::shared_ptr<IBuffer> CopyForkBuffer(const std::shared_ptr<IBufferPool>& bufferPool,
+                                            std::shared_ptr<IBuffer>& source);
+
 private:
     std::mutex                            mtx_;
     std::condition_variable               cv_;
     std::shared_ptr<std::thread>          forkThread_ = nullptr;
-    std::shared_ptr<IBuffer>              tmpBuffer_ = nullptr;
+    std::shared_ptr<IBuffer>              pendingBuffer_ = nullptr;
     std::vector<std::shared_ptr<IPort>>   inPutPorts_;
     std::vector<std::shared_ptr<IPort>>   outPutPorts_;
     std::atomic_bool                    streamRunning_ = false;
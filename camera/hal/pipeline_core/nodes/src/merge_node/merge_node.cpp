@@ -12,18 +12,28 @@
  */
 
 #include "merge_node.h"
-#include <unistd.h>
+#include <algorithm>
 namespace OHOS::Camera{
+namespace {
+    constexpr uint64_t DEFAULT_TIMESTAMP_TOLERANCE = 5000000; // 5ms in ns
+    constexpr uint64_t NSEC_PER_USEC = 1000;
+    constexpr uint32_t MIN_MERGE_INPUT_COUNT = 2;
+    constexpr size_t MAX_FRAME_QUEUE_DEPTH = 8;
+}
+
 MergeNode::MergeNode(const std::string& name, const std::string& type)
-    :NodeBase(name, type)
+    :NodeBase(name, type), tolerance_(DEFAULT_TIMESTAMP_TOLERANCE)
 {
     CAMERA_LOGV("%{public}s enter, type(%{public}s)\n", name_.c_str(), type_.c_str());
 }
 
 MergeNode::~MergeNode()
 {
-    streamRunning_ = false;
-    cv_.notify_all();
+    {
+        std::unique_lock<std::mutex> lck(mtx_);
+        streamRunning_ = false;
+        cv_.notify_all();
+    }
     if (mergeThread_ != nullptr) {
         CAMERA_LOGI("mergeThread need join");
         mergeThread_->join();
@@ -33,27 +43,58 @@ MergeNode::~MergeNode()
 
 RetCode MergeNode::Start(const int32_t streamId)
 {
-    GetOutPorts();
-    if (streamRunning_ == false) {
-        CAMERA_LOGI("streamrunning = false");
-        streamRunning_ = true;
+    if (streamRunning_ == true) {
+        return RC_OK;
     }
+    inputCount_ = std::max(static_cast<uint32_t>(GetNumberOfInPorts()), MIN_MERGE_INPUT_COUNT);
+    tolerance_ = GetTimestampTolerance();
+    CAMERA_LOGI("merge %{public}u inputs, tolerance = %{public}llu", inputCount_, tolerance_);
+    streamRunning_ = true;
     MergeBuffers();
     return RC_OK;
 }
 
 RetCode MergeNode::Stop(const int32_t streamId)
 {
-    streamRunning_ = false;
-    cv_.notify_all();
+    {
+        std::unique_lock<std::mutex> lck(mtx_);
+        streamRunning_ = false;
+        cv_.notify_all();
+    }
     if (mergeThread_ != nullptr) {
         CAMERA_LOGI("mergeThread need join");
         mergeThread_->join();
         mergeThread_ = nullptr;
     }
+
+    // frames which are not merged yet go back to their buffer pools.
+    FrameSet dropSet = {};
+    {
+        std::unique_lock<std::mutex> lck(mtx_);
+        for (auto& it : inputQueues_) {
+            dropSet.insert(dropSet.end(), it.second.begin(), it.second.end());
+        }
+        inputQueues_.clear();
+    }
+    DropFrames(dropSet);
     return RC_OK;
 }
 
+uint64_t MergeNode::GetTimestampTolerance() const
+{
+    // frames of the same capture are less than half a frame duration apart.
+    int32_t frameDuration = 0;
+    for (auto& it : GetInPorts()) {
+        PortFormat format = {};
+        it->GetFormat(format);
+        frameDuration = std::max(frameDuration, format.minFrameDuration_);
+    }
+    if (frameDuration <= 0) {
+        return DEFAULT_TIMESTAMP_TOLERANCE;
+    }
+    return static_cast<uint64_t>(frameDuration) * NSEC_PER_USEC / 2; // 2: half of the frame duration
+}
+
 void MergeNode::DeliverBuffers(std::shared_ptr<FrameSpec> frameSpec)
 {
     CAMERA_LOGI("merge node get frame");
@@ -63,58 +104,103 @@ void MergeNode::DeliverBuffers(std::shared_ptr<FrameSpec> frameSpec)
     }
     {
         std::unique_lock<std::mutex> lck(mtx_);
-        mergeVec_.push_back(frameSpec);
-        bufferNum_++;
-        cv_.notify_all();
+        // frames of one input arrive nearly in order, so the insert position is found from the back.
+        FrameQueue& queue = inputQueues_[frameSpec->bufferPoolId_];
+        uint64_t timestamp = GetFrameTimestamp(frameSpec);
+        auto pos = std::upper_bound(queue.begin(), queue.end(), timestamp,
+            [](const uint64_t t, const std::shared_ptr<FrameSpec>& fs) {
+                return t < GetFrameTimestamp(fs);
+            });
+        queue.insert(pos, frameSpec);
+        frameArrived_ = true;
+        cv_.notify_one();
     }
     return;
 }
 
+uint64_t MergeNode::GetFrameTimestamp(const std::shared_ptr<FrameSpec>& frameSpec)
+{
+    if (frameSpec->buffer_ == nullptr) {
+        return 0;
+    }
+    return frameSpec->buffer_->GetTimestamp();
+}
+
+void MergeNode::MatchFrames(std::vector<FrameSet>& mergeSets, FrameSet& dropSet)
+{
+    // an input which keeps running while another one stalls must not hold all of its buffers.
+    for (auto& it : inputQueues_) {
+        while (it.second.size() > MAX_FRAME_QUEUE_DEPTH) {
+            dropSet.push_back(it.second.front());
+            it.second.pop_front();
+        }
+    }
+
+    while (inputQueues_.size() >= inputCount_) {
+        uint64_t latest = 0;
+        for (auto& it : inputQueues_) {
+            if (it.second.empty()) {
+                return;
+            }
+            latest = std::max(latest, GetFrameTimestamp(it.second.front()));
+        }
+
+        // the oldest frame of an input can't be matched any more, if it is too early for the latest one.
+        bool matched = true;
+        for (auto& it : inputQueues_) {
+            if (GetFrameTimestamp(it.second.front()) + tolerance_ < latest) {
+                dropSet.push_back(it.second.front());
+                it.second.pop_front();
+                matched = false;
+            }
+        }
+        if (!matched) {
+            continue;
+        }
+
+        FrameSet mergeSet = {};
+        for (auto& it : inputQueues_) {
+            mergeSet.push_back(it.second.front());
+            it.second.pop_front();
+        }
+        mergeSets.emplace_back(std::move(mergeSet));
+    }
+}
+
+void MergeNode::DropFrames(FrameSet& dropSet)
+{
+    for (auto& it : dropSet) {
+        if (it->buffer_ == nullptr) {
+            continue;
+        }
+        CAMERA_LOGW("merge node drop frame, pool = %{public}lld, timestamp = %{public}llu",
+            it->bufferPoolId_, GetFrameTimestamp(it));
+        it->buffer_->SetBufferStatus(CAMERA_BUFFER_STATUS_DROP);
+    }
+    // dropped frames still go downstream, so the stream gives the buffer back to its producer.
+    NodeBase::DeliverBuffers(dropSet);
+    dropSet.clear();
+}
+
 void MergeNode::MergeBuffers()
 {
     mergeThread_ = std::make_shared<std::thread>([this] {
         prctl(PR_SET_NAME, "merge_buffers");
-        tmpVec_.clear();
         while (streamRunning_ == true) {
-            if (bufferNum_ > 0) {
-                auto outPorts = GetOutPorts();
-                for (auto& it : outPorts) {
-                    if (tmpVec_.size() == 0) {
-                    {
-                        std::unique_lock<std::mutex> lck(mtx_);
-                        cv_.wait(lck);
-                        auto tmpFrame = std::find_if(mergeVec_.begin(), mergeVec_.end(),
-                            [it](std::shared_ptr<FrameSpec> fs) {
-                            return it->format_.bufferPoolId_ == fs->bufferPoolId_;
-                        });
-                        if (tmpFrame != mergeVec_.end()) {
-                            tmpVec_.push_back((*tmpFrame));
-                            mergeVec_.erase(tmpFrame);
-                            bufferNum_--;
-                            break;
-                        }
-                    }
-                    } else if (tmpVec_.size() == 1) {
-                    {
-                        std::unique_lock<std::mutex> lck(mtx_);
-                        auto tmpFrame_2 = std::find_if(mergeVec_.begin(), mergeVec_.end(),
-                            [it](std::shared_ptr<FrameSpec> fs) {
-                            return it->format_.bufferPoolId_ != fs->bufferPoolId_;
-                        });
-                        if (tmpFrame_2 != mergeVec_.end()) {
-                            tmpVec_.push_back((*tmpFrame_2));
-                            mergeVec_.erase(tmpFrame_2);
-                            bufferNum_--;
-                        }
-                    }
-                    } else if (tmpVec_.size() == 2) {
-                        for (auto it : outPorts) {
-                            it->DeliverBuffers(tmpVec_);
-                            tmpVec_.clear();
-                        }
-                    }
-                    usleep(20);
-                }
+            std::vector<FrameSet> mergeSets = {};
+            FrameSet dropSet = {};
+            {
+                std::unique_lock<std::mutex> lck(mtx_);
+                cv_.wait(lck, [this] {
+                    return frameArrived_ || streamRunning_ == false;
+                });
+                frameArrived_ = false;
+                MatchFrames(mergeSets, dropSet);
+            }
+            DropFrames(dropSet);
+            // frames of a merged set go on together, each by the out port of its pool.
+            for (auto& mergeSet : mergeSets) {
+                NodeBase::DeliverBuffers(mergeSet);
             }
         }
         CAMERA_LOGI("merge thread closed");
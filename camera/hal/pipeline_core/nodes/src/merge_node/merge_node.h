@@ -15,6 +15,8 @@
 #define HOS_CAMERA_MERGE_NODE_H
 
 #include <vector>
+#include <deque>
+#include <map>
 #include <condition_variable>
 #include "device_manager_adapter.h"
 #include "utils.h"
@@ -31,13 +33,26 @@ public:
     RetCode Stop(const int32_t streamId) override;
     void DeliverBuffers(std::shared_ptr<FrameSpec> frameSpec) override;
     void MergeBuffers();
+
+private:
+    using FrameQueue = std::deque<std::shared_ptr<FrameSpec>>;
+    using FrameSet = std::vector<std::shared_ptr<FrameSpec>>;
+
+    void MatchFrames(std::vector<FrameSet>& mergeSets, FrameSet& dropSet);
+    void DropFrames(FrameSet& dropSet);
+    uint64_t GetTimestampTolerance() const;
+    static uint64_t GetFrameTimestamp(const std::shared_ptr<FrameSpec>& frameSpec);
+
 private:
     std::mutex                                  mtx_;
     std::condition_variable                     cv_;
-    std::vector<std::shared_ptr<FrameSpec>>     mergeVec_;
-    std::vector<std::shared_ptr<FrameSpec>>     tmpVec_;
+    // frames of each input sorted by timestamp, inputs are told apart by buffer pool.
+    std::map<int64_t, FrameQueue>               inputQueues_;
     std::shared_ptr<std::thread>                mergeThread_ = nullptr;
-    uint64_t bufferNum_ = 0;
+    uint32_t                                    inputCount_ = 0;
+    // frames of all inputs whose timestamps differ no more than tolerance are merged together.
+    uint64_t                                    tolerance_ = 0;
+    bool                                        frameArrived_ = false;
     std::atomic_bool                           streamRunning_ = false;
 };
 }// namespace OHOS::Camera
@@ -52,15 +52,7 @@ RetCode PortBase::DisConnect()
 
 int32_t PortBase::Direction() const
 {
-    if (name_.empty()) {
-        return 0;
-    }
-
-    if (name_[0] == 'i') {
-        return 0;
-    } else {
-        return 1;
-    }
+    return direction_;
 }
 
 std::shared_ptr<INode> PortBase::GetNode() const
@@ -95,6 +87,17 @@ void PortBase::DeliverBuffers(std::vector<std::shared_ptr<IBuffer>>& buffers)
     return;
 }
 
+void PortBase::DeliverBuffers(std::vector<std::shared_ptr<FrameSpec>> mergeVec)
+{
+    auto peerPort = Peer();
+    CHECK_IF_PTR_NULL_RETURN_VOID(peerPort);
+    auto peerNode = peerPort->GetNode();
+    CHECK_IF_PTR_NULL_RETURN_VOID(peerNode);
+    peerNode->DeliverBuffers(mergeVec);
+
+    return;
+}
+
 std::string NodeBase::GetName() const
 {
     return name_;
@@ -107,13 +110,17 @@ std::string NodeBase::GetType() const
 
 std::shared_ptr<IPort> NodeBase::GetPort(const std::string& name)
 {
-    auto it = std::find_if(portVec_.begin(), portVec_.end(),
-                           [name](std::shared_ptr<IPort> p) { return p->GetName() == name; });
-    if (it != portVec_.end()) {
-        return *it;
+    auto it = portMap_.find(name);
+    if (it != portMap_.end()) {
+        return it->second;
     }
     std::shared_ptr<IPort> port = std::make_shared<PortBase>(name, shared_from_this());
-    portVec_.push_back(port);
+    portMap_[name] = port;
+    if (port->Direction() == PORT_DIRECTION_IN) {
+        inPorts_.push_back(port);
+    } else {
+        outPorts_.push_back(port);
+    }
     return port;
 }
 
@@ -145,55 +152,30 @@ RetCode NodeBase::Config(const int32_t streamId, const CaptureMeta& meta)
 
 int32_t NodeBase::GetNumberOfInPorts() const
 {
-    int32_t re = 0;
-    for (const auto& it : portVec_) {
-        if (it->Direction() == 0) {
-            re++;
-        }
-    }
-    return re;
+    return static_cast<int32_t>(inPorts_.size());
 }
 
 int32_t NodeBase::GetNumberOfOutPorts() const
 {
-    int32_t re = 0;
-    for (const auto& it : portVec_) {
-        if (it->Direction() == 1) {
-            re++;
-        }
-    }
-    return re;
+    return static_cast<int32_t>(outPorts_.size());
 }
 
 std::vector<std::shared_ptr<IPort>> NodeBase::GetInPorts() const
 {
-    std::vector<std::shared_ptr<IPort>> re;
-    for (const auto& it : portVec_) {
-        if (it->Direction() == 0) {
-            re.push_back(it);
-        }
-    }
-    return re;
+    return inPorts_;
 }
 
 std::vector<std::shared_ptr<IPort>> NodeBase::GetOutPorts()
 {
-    std::vector<std::shared_ptr<IPort>> out = {};
-    for (const auto& it : portVec_) {
-        if (it->Direction() == 1) {
-            out.push_back(it);
-        }
-    }
-    return out;
+    return outPorts_;
 }
 
 std::shared_ptr<IPort> NodeBase::GetOutPortById(const int32_t id)
 {
-    auto ports = GetOutPorts();
-    if (ports.size() <= id) {
+    if (id < 0 || static_cast<size_t>(id) >= outPorts_.size()) {
         return nullptr;
     }
-    return ports[id];
+    return outPorts_[id];
 }
 
 RetCode NodeBase::Capture(const int32_t streamId, const int32_t captureId)
@@ -206,15 +188,50 @@ RetCode NodeBase::CancelCapture(const int32_t streamId)
     return RC_OK;
 }
 
-void NodeBase::DeliverBuffer(std::shared_ptr<IBuffer>& buffer)
+IPort* NodeBase::GetOutPortByPool(const int64_t poolId)
+{
+    const PoolRoutes* routes = poolRoutes_.load(std::memory_order_acquire);
+    if (routes != nullptr) {
+        for (const auto& it : *routes) {
+            // pool id of a port may be changed after the route is made, e.g. by Start.
+            if (it.poolId == poolId && it.port->format_.bufferPoolId_ == poolId) {
+                return it.port;
+            }
+        }
+    }
+    return RebuildPoolRoutes(poolId);
+}
+
+IPort* NodeBase::RebuildPoolRoutes(const int64_t poolId)
 {
-    auto outPorts = GetOutPorts();
-    for (auto it : outPorts) {
-        if (it->format_.bufferPoolId_ == buffer->GetPoolId()) {
-            it->DeliverBuffer(buffer);
-            return;
+    IPort* port = nullptr;
+    for (const auto& it : outPorts_) {
+        if (it->format_.bufferPoolId_ == poolId) {
+            port = it.get();
+            break;
         }
     }
+    if (port == nullptr) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> l(routeLock_);
+    auto routes = std::make_unique<PoolRoutes>();
+    routes->reserve(outPorts_.size());
+    for (const auto& it : outPorts_) {
+        routes->push_back({it->format_.bufferPoolId_, it.get()});
+    }
+    poolRoutes_.store(routes.get(), std::memory_order_release);
+    routeTables_.emplace_back(std::move(routes));
+    return port;
+}
+
+void NodeBase::DeliverBuffer(std::shared_ptr<IBuffer>& buffer)
+{
+    IPort* port = GetOutPortByPool(buffer->GetPoolId());
+    if (port != nullptr) {
+        port->DeliverBuffer(buffer);
+    }
     return;
 }
 
@@ -223,12 +240,32 @@ void NodeBase::DeliverBuffers(std::vector<std::shared_ptr<IBuffer>>& buffers)
     if (buffers.empty()) {
         return;
     }
-    auto outPorts = GetOutPorts();
-    for (auto it : outPorts) {
-        if (it->format_.bufferPoolId_ == buffers[0]->GetPoolId()) {
-            it->DeliverBuffers(buffers);
-            return;
+    IPort* port = GetOutPortByPool(buffers[0]->GetPoolId());
+    if (port != nullptr) {
+        port->DeliverBuffers(buffers);
+    }
+    return;
+}
+
+void NodeBase::DeliverBuffers(std::vector<std::shared_ptr<FrameSpec>> mergeVec)
+{
+    // each buffer of a frame set goes on by the out port of its pool.
+    for (auto& it : mergeVec) {
+        if (it == nullptr || it->buffer_ == nullptr) {
+            continue;
+        }
+        IPort* port = GetOutPortByPool(it->bufferPoolId_);
+        if (port != nullptr) {
+            port->DeliverBuffer(it->buffer_);
+            continue;
+        }
+        CAMERA_LOGE("no out port of pool %{public}lld, return buffer to pool", it->bufferPoolId_);
+        std::shared_ptr<IBufferPool> bufferPool = BufferManager::GetInstance()->GetBufferPool(it->bufferPoolId_);
+        if (bufferPool == nullptr) {
+            CAMERA_LOGE("get bufferpool failed");
+            continue;
         }
+        bufferPool->ReturnBuffer(it->buffer_);
     }
     return;
 }
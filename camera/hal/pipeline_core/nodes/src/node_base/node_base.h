@@ -15,6 +15,10 @@
 #define NODE_BASE_H
 
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "inode.h"
 #include "buffer_manager.h"
 #include "idevice_manager.h"
@@ -24,7 +28,8 @@ class PortBase : public IPort {
 public:
     PortBase(const std::string& name, const std::weak_ptr<INode>& n):
         name_(name),
-        owner_(n)
+        owner_(n),
+        direction_(name.empty() || name[0] == 'i' ? PORT_DIRECTION_IN : PORT_DIRECTION_OUT)
     {
     }
     ~PortBase() override = default;
@@ -40,11 +45,12 @@ public:
     virtual void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) override;
     virtual void DeliverBuffers(std::vector<std::shared_ptr<IBuffer>>& buffers) override;
     void DeliverBuffers(std::shared_ptr<FrameSpec> frameSpec) override {};
-    void DeliverBuffers(std::vector<std::shared_ptr<FrameSpec>> mergeVec) override {};
+    void DeliverBuffers(std::vector<std::shared_ptr<FrameSpec>> mergeVec) override;
 protected:
     std::string name_;
     std::shared_ptr<IPort> peer_ = nullptr;
     std::weak_ptr<INode> owner_;
+    PortDirection direction_;
 };
 
 class NodeBase : public INode, public std::enable_shared_from_this<NodeBase> {
@@ -56,10 +62,12 @@ public:
     }
     ~NodeBase() override
     {
-        for (const auto& it : portVec_) {
+        for (const auto& it : inPorts_) {
+            it->DisConnect();
+        }
+        for (const auto& it : outPorts_) {
             it->DisConnect();
         }
-        portVec_.clear();
     }
 
     std::string GetName() const override;
@@ -83,12 +91,33 @@ public:
 
     virtual RetCode ProvideBuffers(std::shared_ptr<FrameSpec> frameSpec){};
     void DeliverBuffers(std::shared_ptr<FrameSpec> frameSpec) override {};
-    void DeliverBuffers(std::vector<std::shared_ptr<FrameSpec>> mergeVec) override {};
+    void DeliverBuffers(std::vector<std::shared_ptr<FrameSpec>> mergeVec) override;
+
+protected:
+    // out port which delivers buffers of a pool, null if there is none.
+    IPort* GetOutPortByPool(const int64_t poolId);
 
 protected:
     std::string name_;
     std::string type_;
-    std::vector<std::shared_ptr<IPort>> portVec_;
+    // ports are only added while the pipeline is built, and live as long as the node.
+    std::unordered_map<std::string, std::shared_ptr<IPort>> portMap_;
+    std::vector<std::shared_ptr<IPort>> inPorts_;
+    std::vector<std::shared_ptr<IPort>> outPorts_;
+
+private:
+    struct PoolRoute {
+        int64_t poolId;
+        IPort* port;
+    };
+    using PoolRoutes = std::vector<PoolRoute>;
+    IPort* RebuildPoolRoutes(const int64_t poolId);
+
+    // routes are published as immutable tables, so buffers are routed without lock and allocation.
+    // a table is rebuilt only when a pool id is seen the first time, retired tables live with the node.
+    std::atomic<const PoolRoutes*> poolRoutes_ = nullptr;
+    std::mutex routeLock_;
+    std::vector<std::unique_ptr<PoolRoutes>> routeTables_;
 };
 }
 #endif
@@ -12,9 +12,20 @@
  */
 
 #include "source_node.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 
 namespace OHOS::Camera {
+namespace {
+    constexpr int EPOLL_EVENT_COUNT = 3;
+    // buffers in flight are bounded by the pool, the queue is never full unless a buffer is responded twice.
+    constexpr uint32_t RESPOND_QUEUE_FACTOR = 2;
+    constexpr uint32_t RESPOND_QUEUE_MIN_SIZE = 8;
+    // the loop which runs on this thread, it collects buffers returned by itself without a wakeup.
+    thread_local const void* g_currentLoop = nullptr;
+}
+
 SourceNode::SourceNode(const std::string& name, const std::string& type) : NodeBase(name, type)
 {
     CAMERA_LOGV("%{public}s enter, type(%{public}s)\n", name_.c_str(), type_.c_str());
@@ -61,10 +72,7 @@ RetCode SourceNode::Start(const int32_t streamId)
         std::lock_guard<std::mutex> l(hndl_);
         handler_[streamId] = ph;
     }
-    RetCode rc = handler_[streamId]->StartCollectBuffers();
-    CHECK_IF_NOT_EQUAL_RETURN_VALUE(rc, RC_OK, RC_ERROR);
-
-    rc = handler_[streamId]->StartDistributeBuffers();
+    RetCode rc = ph->StartLoop();
     CHECK_IF_NOT_EQUAL_RETURN_VALUE(rc, RC_OK, RC_ERROR);
 
     return RC_OK;
@@ -80,7 +88,7 @@ RetCode SourceNode::Flush(const int32_t streamId)
 RetCode SourceNode::Stop(const int32_t streamId)
 {
     CHECK_IF_NOT_EQUAL_RETURN_VALUE(handler_.count(streamId) > 0, true, RC_ERROR);
-    handler_[streamId]->StopDistributeBuffers();
+    handler_[streamId]->StopLoop();
 
     {
         std::lock_guard<std::mutex> l(hndl_);
@@ -160,143 +168,195 @@ SourceNode::PortHandler::PortHandler(std::shared_ptr<IPort>& p)
     port = p;
 }
 
-RetCode SourceNode::PortHandler::StartCollectBuffers()
+SourceNode::PortHandler::~PortHandler()
+{
+    StopLoop();
+    CloseFds();
+}
+
+RetCode SourceNode::PortHandler::StartLoop()
 {
     CHECK_IF_PTR_NULL_RETURN_VALUE(port, RC_ERROR);
-    PortFormat format = {};
     port->GetFormat(format);
-    int streamId = format.streamId_;
 
     pool = BufferManager::GetInstance()->GetBufferPool(format.bufferPoolId_);
     CHECK_IF_PTR_NULL_RETURN_VALUE(pool, RC_ERROR);
-    pool->NotifyStart();
 
-    cltRun = true;
-    collector = std::make_unique<std::thread>([this, &streamId] {
-        std::string name = "collect#" + std::to_string(streamId);
-        prctl(PR_SET_NAME, name.c_str());
-        while (cltRun) {
-            CollectBuffers();
+    idleFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    respondFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    exitFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (idleFd < 0 || respondFd < 0 || exitFd < 0 || epollFd < 0) {
+        CAMERA_LOGE("create fds of stream [%{public}d] failed", format.streamId_);
+        CloseFds();
+        return RC_ERROR;
+    }
+    for (int fd : {idleFd, respondFd, exitFd}) {
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    uint32_t queueSize = format.bufferCount_ * RESPOND_QUEUE_FACTOR;
+    respondBuffers = std::make_unique<SpscQueue<std::shared_ptr<IBuffer>>>(
+        queueSize > RESPOND_QUEUE_MIN_SIZE ? queueSize : RESPOND_QUEUE_MIN_SIZE);
+    frameSpecs.reserve(format.bufferCount_);
+
+    pool->SetIdleCallback([this] {
+        if (g_currentLoop != this) {
+            uint64_t one = 1;
+            write(idleFd, &one, sizeof(one));
         }
     });
+    pool->NotifyStart();
+
+    // the first round of the loop sends all idle buffers to the device.
+    collecting = true;
+    uint64_t one = 1;
+    write(idleFd, &one, sizeof(one));
+    loop = std::make_unique<std::thread>(&SourceNode::PortHandler::Loop, this);
 
     return RC_OK;
 }
 
 RetCode SourceNode::PortHandler::StopCollectBuffers()
 {
-    cltRun = false;
+    CHECK_IF_PTR_NULL_RETURN_VALUE(pool, RC_ERROR);
+    collecting = false;
     pool->NotifyStop();
-    if (collector != nullptr) {
-        collector->join();
+    {
+        // wait for the loop to finish sending buffers to the device.
+        std::lock_guard<std::mutex> l(collectLock);
     }
 
-    CHECK_IF_PTR_NULL_RETURN_VALUE(pool, RC_ERROR);
     auto node = port->GetNode();
     if (node != nullptr) {
         uint32_t n = pool->GetIdleBufferCount();
         for (uint32_t i = 0; i < n; i++) {
-            auto buffer = pool->AcquireBuffer(-1);
+            auto buffer = pool->AcquireBuffer(0);
+            if (buffer == nullptr) {
+                break;
+            }
             node->DeliverBuffer(buffer);
         }
     }
     return RC_OK;
 }
 
-void SourceNode::PortHandler::CollectBuffers()
+RetCode SourceNode::PortHandler::StopLoop()
 {
-    CHECK_IF_PTR_NULL_RETURN_VOID(pool);
-    std::shared_ptr<IBuffer> buffer = pool->AcquireBuffer(-1);
-    CHECK_IF_PTR_NULL_RETURN_VOID(buffer);
-
-    PortFormat format = {};
-    port->GetFormat(format);
-    std::shared_ptr<FrameSpec> frameSpec = std::make_shared<FrameSpec>();
-    frameSpec->bufferPoolId_ = format.bufferPoolId_;
-    frameSpec->bufferCount_ = format.bufferCount_;
-    frameSpec->buffer_ = buffer;
-
-    auto node = port->GetNode();
-    CHECK_IF_PTR_NULL_RETURN_VOID(node);
-    RetCode rc = node->ProvideBuffers(frameSpec);
-    if (rc == RC_ERROR) {
-        CAMERA_LOGE("provide buffer failed.");
+    if (loop == nullptr) {
+        return RC_OK;
     }
-}
 
-RetCode SourceNode::PortHandler::StartDistributeBuffers()
-{
-    dbtRun = true;
-    distributor = std::make_unique<std::thread>([this] {
-        PortFormat format = {};
-        port->GetFormat(format);
-        int id = format.streamId_;
-        std::string name = "collect#" + std::to_string(id);
-        prctl(PR_SET_NAME, name.c_str());
-        while (dbtRun) {
-            DistributeBuffers();
-        }
-    });
+    // buffers which are responded already are delivered, before the loop exits.
+    collecting = false;
+    uint64_t one = 1;
+    write(exitFd, &one, sizeof(one));
+    loop->join();
+    loop = nullptr;
+    pool->SetIdleCallback(nullptr);
 
     return RC_OK;
 }
 
-RetCode SourceNode::PortHandler::StopDistributeBuffers()
+void SourceNode::PortHandler::CloseFds()
 {
-    FlushBuffers();
-    dbtRun = false;
-    rbcv.notify_one();
-    if (distributor != nullptr) {
-        distributor->join();
+    for (int* fd : {&idleFd, &respondFd, &exitFd, &epollFd}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
     }
-
-    return RC_OK;
 }
 
-void SourceNode::PortHandler::DistributeBuffers()
+void SourceNode::PortHandler::Loop()
 {
-    std::unique_lock<std::mutex> l(rblock);
-    rbcv.wait(l, [this] { return dbtRun == false || !respondBufferList.empty(); });
+    std::string name = "source#" + std::to_string(format.streamId_);
+    prctl(PR_SET_NAME, name.c_str());
+    g_currentLoop = this;
+
+    struct epoll_event events[EPOLL_EVENT_COUNT] = {};
+    while (true) {
+        int n = epoll_wait(epollFd, events, EPOLL_EVENT_COUNT, -1);
+        bool exit = false;
+        for (int i = 0; i < n; i++) {
+            uint64_t value = 0;
+            read(events[i].data.fd, &value, sizeof(value));
+            exit = exit || events[i].data.fd == exitFd;
+        }
 
-    if (!dbtRun) {
-        return;
+        // an event may be consumed by the round of an earlier one, both queues are drained every round.
+        DistributeBuffers();
+        if (exit) {
+            return;
+        }
+        CollectBuffers();
     }
+}
 
+void SourceNode::PortHandler::CollectBuffers()
+{
+    std::lock_guard<std::mutex> l(collectLock);
     auto node = port->GetNode();
     CHECK_IF_PTR_NULL_RETURN_VOID(node);
-    auto buffer = respondBufferList.front();
-    node->DeliverBuffer(buffer);
-    respondBufferList.pop_front();
+    // only the buffers idle now are taken, acquires without wait would grow an elastic pool to its max.
+    for (uint32_t n = pool->GetIdleBufferCount(); collecting && n > 0; n--) {
+        std::shared_ptr<IBuffer> buffer = pool->AcquireBuffer(0);
+        if (buffer == nullptr) {
+            return;
+        }
 
-    return;
+        std::shared_ptr<FrameSpec> frameSpec = GetFrameSpec();
+        frameSpec->bufferPoolId_ = format.bufferPoolId_;
+        frameSpec->bufferCount_ = format.bufferCount_;
+        frameSpec->buffer_ = buffer;
+        RetCode rc = node->ProvideBuffers(frameSpec);
+        if (rc == RC_ERROR) {
+            CAMERA_LOGE("provide buffer failed.");
+        }
+    }
 }
 
-void SourceNode::PortHandler::OnBuffer(std::shared_ptr<IBuffer>& buffer)
+std::shared_ptr<FrameSpec> SourceNode::PortHandler::GetFrameSpec()
 {
-    std::unique_lock<std::mutex> l(rblock);
-    respondBufferList.emplace_back(buffer);
-    rbcv.notify_one();
-
-    return;
+    // a frame spec which is only referred by the free-list is dropped by the device.
+    for (auto& it : frameSpecs) {
+        if (it.use_count() == 1) {
+            return it;
+        }
+    }
+    std::shared_ptr<FrameSpec> frameSpec = std::make_shared<FrameSpec>();
+    frameSpecs.emplace_back(frameSpec);
+    return frameSpec;
 }
 
-void SourceNode::PortHandler::FlushBuffers()
+void SourceNode::PortHandler::DistributeBuffers()
 {
-    if (respondBufferList.empty()) {
-        return;
-    }
-
     auto node = port->GetNode();
     CHECK_IF_PTR_NULL_RETURN_VOID(node);
-    std::unique_lock<std::mutex> l(rblock);
-    while (!respondBufferList.empty()) {
-        auto buffer = respondBufferList.front();
+    std::shared_ptr<IBuffer> buffer = nullptr;
+    while (respondBuffers->Pop(buffer)) {
         node->DeliverBuffer(buffer);
-        respondBufferList.pop_front();
     }
 
     return;
 }
 
+void SourceNode::PortHandler::OnBuffer(std::shared_ptr<IBuffer>& buffer)
+{
+    std::shared_ptr<IBuffer> respond = buffer;
+    if (!respondBuffers->Push(std::move(respond))) {
+        CAMERA_LOGE("respond queue of stream [%{public}d] is full, drop buffer", format.streamId_);
+        pool->ReturnBuffer(buffer);
+        return;
+    }
+    uint64_t one = 1;
+    write(respondFd, &one, sizeof(one));
+
+    return;
+}
+
 REGISTERNODE(SourceNode, {"source"})
 } // namespace OHOS::Camera
@@ -16,6 +16,7 @@
 
 #include "camera.h"
 #include "node_base.h"
+#include "spsc_queue.h"
 #include "utils.h"
 #include <vector>
 
@@ -38,36 +39,44 @@ public:
     virtual void SetBufferCallback();
 
 protected:
+    // every port runs one event loop, which sends idle buffers of the pool to the device and
+    // delivers buffers filled by the device. it wakes up by eventfds, when a buffer becomes idle
+    // or the device responds, so that a frame costs no more than one thread switch.
     class PortHandler {
     public:
         PortHandler() = default;
-        virtual ~PortHandler() = default;
+        virtual ~PortHandler();
         PortHandler(std::shared_ptr<IPort>& p);
-        RetCode StartCollectBuffers();
+        RetCode StartLoop();
         RetCode StopCollectBuffers();
-        RetCode StartDistributeBuffers();
-        RetCode StopDistributeBuffers();
+        RetCode StopLoop();
+        // called by the device thread, only one thread may respond buffers of a port.
         void OnBuffer(std::shared_ptr<IBuffer>& buffer);
 
     private:
+        void Loop();
         void CollectBuffers();
         void DistributeBuffers();
-        void FlushBuffers();
+        std::shared_ptr<FrameSpec> GetFrameSpec();
+        void CloseFds();
 
     private:
         std::shared_ptr<IPort> port = nullptr;
+        PortFormat format = {};
 
-        bool cltRun = false;
-        std::unique_ptr<std::thread> collector = nullptr;
-
-        bool dbtRun = false;
-        std::unique_ptr<std::thread> distributor = nullptr;
+        std::atomic_bool collecting = false;
+        std::mutex collectLock;
+        std::unique_ptr<std::thread> loop = nullptr;
+        int idleFd = -1;
+        int respondFd = -1;
+        int exitFd = -1;
+        int epollFd = -1;
 
         std::shared_ptr<IBufferPool> pool = nullptr;
 
-        std::condition_variable rbcv;
-        std::mutex rblock;
-        std::list<std::shared_ptr<IBuffer>> respondBufferList = {};
+        std::unique_ptr<SpscQueue<std::shared_ptr<IBuffer>>> respondBuffers = nullptr;
+        // frame specs are reused, once the device drops them.
+        std::vector<std::shared_ptr<FrameSpec>> frameSpecs = {};
     };
 
     std::mutex hndl_ = {};
@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "image_converter.h"
+#include "securec.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CAMERA_CONVERT_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define CAMERA_CONVERT_SSE2
+#endif
+
+namespace OHOS::Camera {
+namespace {
+    // BT.601 limited range in 6 bit fixed point, see ConvertPixel.
+    constexpr int32_t COEF_Y = 74;
+    constexpr int32_t COEF_RV = 102;
+    constexpr int32_t COEF_GU = 25;
+    constexpr int32_t COEF_GV = 52;
+    constexpr int32_t COEF_BU = 129;
+    constexpr int32_t Y_OFFSET = 16;
+    constexpr int32_t UV_OFFSET = 128;
+    constexpr int32_t ROUND = 32;
+    constexpr int32_t SHIFT = 6;
+    constexpr int32_t MAX_PIXEL = 255;
+    constexpr uint8_t ALPHA_OPAQUE = 0xff;
+    constexpr uint32_t YUYV_BYTES = 2;
+    constexpr uint32_t RGBA_BYTES = 4;
+#if defined(CAMERA_CONVERT_NEON) || defined(CAMERA_CONVERT_SSE2)
+    constexpr uint32_t SIMD_PIXELS = 16;
+#endif
+}
+
+static inline uint8_t Clamp(int32_t value)
+{
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > MAX_PIXEL ? MAX_PIXEL : value));
+}
+
+// vector paths compute the same formula with saturated int16 adds, a sum which saturates
+// is above 255 after the shift anyway, so both paths clamp to the same value.
+static inline void ConvertPixel(uint8_t y, int32_t u, int32_t v, uint8_t* rgba)
+{
+    int32_t luma = (y - Y_OFFSET) * COEF_Y + ROUND;
+    rgba[0] = Clamp((luma + COEF_RV * v) >> SHIFT);
+    rgba[1] = Clamp((luma - COEF_GU * u - COEF_GV * v) >> SHIFT);
+    rgba[2] = Clamp((luma + COEF_BU * u) >> SHIFT);
+    rgba[3] = ALPHA_OPAQUE;
+}
+
+static void YuyvRowsScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* dstY0, uint8_t* dstY1,
+                           uint8_t* dstUv, uint32_t start, uint32_t width, bool swapUv)
+{
+    uint32_t uIndex = swapUv ? 1 : 0;
+    for (uint32_t x = start; x < width; x += 2) { // 2: one yuyv macro pixel
+        const uint8_t* p0 = row0 + x * YUYV_BYTES;
+        const uint8_t* p1 = row1 + x * YUYV_BYTES;
+        dstY0[x] = p0[0];
+        dstY0[x + 1] = p0[2]; // 2: offset of Y1
+        dstY1[x] = p1[0];
+        dstY1[x + 1] = p1[2]; // 2: offset of Y1
+        dstUv[x + uIndex] = static_cast<uint8_t>((p0[1] + p1[1] + 1) >> 1);
+        dstUv[x + 1 - uIndex] = static_cast<uint8_t>((p0[3] + p1[3] + 1) >> 1); // 3: offset of V
+    }
+}
+
+static void SwapUvRowScalar(const uint8_t* src, uint8_t* dst, uint32_t start, uint32_t width)
+{
+    for (uint32_t x = start; x < width; x += 2) { // 2: one chroma pair
+        uint8_t first = src[x];
+        dst[x] = src[x + 1];
+        dst[x + 1] = first;
+    }
+}
+
+static void RgbaRowScalar(const uint8_t* srcY, const uint8_t* srcUv, uint8_t* dst,
+                          uint32_t start, uint32_t width, bool swapUv)
+{
+    uint32_t uIndex = swapUv ? 1 : 0;
+    for (uint32_t x = start; x < width; x += 2) { // 2: pixels sharing one chroma pair
+        int32_t u = srcUv[x + uIndex] - UV_OFFSET;
+        int32_t v = srcUv[x + 1 - uIndex] - UV_OFFSET;
+        ConvertPixel(srcY[x], u, v, dst + x * RGBA_BYTES);
+        ConvertPixel(srcY[x + 1], u, v, dst + (x + 1) * RGBA_BYTES);
+    }
+}
+
+#if defined(CAMERA_CONVERT_NEON)
+static uint32_t YuyvRowsSimd(const uint8_t* row0, const uint8_t* row1, uint8_t* dstY0, uint8_t* dstY1,
+                             uint8_t* dstUv, uint32_t width, bool swapUv)
+{
+    uint32_t x = 0;
+    for (; x + SIMD_PIXELS <= width; x += SIMD_PIXELS) {
+        uint8x16x2_t p0 = vld2q_u8(row0 + x * YUYV_BYTES);
+        uint8x16x2_t p1 = vld2q_u8(row1 + x * YUYV_BYTES);
+        vst1q_u8(dstY0 + x, p0.val[0]);
+        vst1q_u8(dstY1 + x, p1.val[0]);
+        uint8x16_t uv = vrhaddq_u8(p0.val[1], p1.val[1]);
+        if (swapUv) {
+            uv = vrev16q_u8(uv);
+        }
+        vst1q_u8(dstUv + x, uv);
+    }
+    return x;
+}
+
+static uint32_t SwapUvRowSimd(const uint8_t* src, uint8_t* dst, uint32_t width)
+{
+    uint32_t x = 0;
+    for (; x + SIMD_PIXELS <= width; x += SIMD_PIXELS) {
+        vst1q_u8(dst + x, vrev16q_u8(vld1q_u8(src + x)));
+    }
+    return x;
+}
+
+static inline uint8x8_t ConvertChannel(int16x8_t luma, int16x8_t chroma)
+{
+    return vqmovun_s16(vshrq_n_s16(vqaddq_s16(luma, chroma), SHIFT));
+}
+
+static uint32_t RgbaRowSimd(const uint8_t* srcY, const uint8_t* srcUv, uint8_t* dst, uint32_t width, bool swapUv)
+{
+    const int16x8_t uvOffset = vdupq_n_s16(UV_OFFSET);
+    const int16x8_t yOffset = vdupq_n_s16(Y_OFFSET);
+    const int16x8_t round = vdupq_n_s16(ROUND);
+    uint32_t x = 0;
+    for (; x + SIMD_PIXELS <= width; x += SIMD_PIXELS) {
+        uint8x16_t y = vld1q_u8(srcY + x);
+        uint8x8x2_t uv = vld2_u8(srcUv + x);
+        int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(uv.val[swapUv ? 1 : 0])), uvOffset);
+        int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(uv.val[swapUv ? 0 : 1])), uvOffset);
+
+        int16x8x2_t r = vzipq_s16(vmulq_n_s16(v, COEF_RV), vmulq_n_s16(v, COEF_RV));
+        int16x8_t gTerm = vnegq_s16(vaddq_s16(vmulq_n_s16(u, COEF_GU), vmulq_n_s16(v, COEF_GV)));
+        int16x8x2_t g = vzipq_s16(gTerm, gTerm);
+        int16x8x2_t b = vzipq_s16(vmulq_n_s16(u, COEF_BU), vmulq_n_s16(u, COEF_BU));
+
+        int16x8_t lumaLow = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(y)));
+        int16x8_t lumaHigh = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(y)));
+        lumaLow = vaddq_s16(vmulq_n_s16(vsubq_s16(lumaLow, yOffset), COEF_Y), round);
+        lumaHigh = vaddq_s16(vmulq_n_s16(vsubq_s16(lumaHigh, yOffset), COEF_Y), round);
+
+        uint8x16x4_t rgba;
+        rgba.val[0] = vcombine_u8(ConvertChannel(lumaLow, r.val[0]), ConvertChannel(lumaHigh, r.val[1]));
+        rgba.val[1] = vcombine_u8(ConvertChannel(lumaLow, g.val[0]), ConvertChannel(lumaHigh, g.val[1]));
+        rgba.val[2] = vcombine_u8(ConvertChannel(lumaLow, b.val[0]), ConvertChannel(lumaHigh, b.val[1]));
+        rgba.val[3] = vdupq_n_u8(ALPHA_OPAQUE);
+        vst4q_u8(dst + x * RGBA_BYTES, rgba);
+    }
+    return x;
+}
+#elif defined(CAMERA_CONVERT_SSE2)
+static inline __m128i SwapBytes(__m128i value)
+{
+    return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8)); // 8: swap bytes of each pair
+}
+
+static uint32_t YuyvRowsSimd(const uint8_t* row0, const uint8_t* row1, uint8_t* dstY0, uint8_t* dstY1,
+                             uint8_t* dstUv, uint32_t width, bool swapUv)
+{
+    const __m128i lowMask = _mm_set1_epi16(0x00ff);
+    uint32_t x = 0;
+    for (; x + SIMD_PIXELS <= width; x += SIMD_PIXELS) {
+        const uint8_t* p0 = row0 + x * YUYV_BYTES;
+        const uint8_t* p1 = row1 + x * YUYV_BYTES;
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p0));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p0 + SIMD_PIXELS));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + SIMD_PIXELS));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstY0 + x),
+            _mm_packus_epi16(_mm_and_si128(a0, lowMask), _mm_and_si128(b0, lowMask)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstY1 + x),
+            _mm_packus_epi16(_mm_and_si128(a1, lowMask), _mm_and_si128(b1, lowMask)));
+        __m128i uv0 = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(b0, 8)); // 8: chroma byte
+        __m128i uv1 = _mm_packus_epi16(_mm_srli_epi16(a1, 8), _mm_srli_epi16(b1, 8)); // 8: chroma byte
+        __m128i uv = _mm_avg_epu8(uv0, uv1);
+        if (swapUv) {
+            uv = SwapBytes(uv);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstUv + x), uv);
+    }
+    return x;
+}
+
+static uint32_t SwapUvRowSimd(const uint8_t* src, uint8_t* dst, uint32_t width)
+{
+    uint32_t x = 0;
+    for (; x + SIMD_PIXELS <= width; x += SIMD_PIXELS) {
+        __m128i uv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), SwapBytes(uv));
+    }
+    return x;
+}
+
+static inline __m128i ConvertChannel(__m128i lumaLow, __m128i lumaHigh, __m128i chroma)
+{
+    __m128i low = _mm_srai_epi16(_mm_adds_epi16(lumaLow, _mm_unpacklo_epi16(chroma, chroma)), SHIFT);
+    __m128i high = _mm_srai_epi16(_mm_adds_epi16(lumaHigh, _mm_unpackhi_epi16(chroma, chroma)), SHIFT);
+    return _mm_packus_epi16(low, high);
+}
+
+static uint32_t RgbaRowSimd(const uint8_t* srcY, const uint8_t* srcUv, uint8_t* dst, uint32_t width, bool swapUv)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lowMask = _mm_set1_epi16(0x00ff);
+    const __m128i uvOffset = _mm_set1_epi16(UV_OFFSET);
+    const __m128i yOffset = _mm_set1_epi16(Y_OFFSET);
+    const __m128i round = _mm_set1_epi16(ROUND);
+    const __m128i alpha = _mm_set1_epi8(static_cast<char>(ALPHA_OPAQUE));
+    uint32_t x = 0;
+    for (; x + SIMD_PIXELS <= width; x += SIMD_PIXELS) {
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcY + x));
+        __m128i uv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcUv + x));
+        __m128i first = _mm_sub_epi16(_mm_and_si128(uv, lowMask), uvOffset);
+        __m128i second = _mm_sub_epi16(_mm_srli_epi16(uv, 8), uvOffset); // 8: second byte of the pair
+        __m128i u = swapUv ? second : first;
+        __m128i v = swapUv ? first : second;
+
+        __m128i r = _mm_mullo_epi16(v, _mm_set1_epi16(COEF_RV));
+        __m128i g = _mm_sub_epi16(zero, _mm_add_epi16(_mm_mullo_epi16(u, _mm_set1_epi16(COEF_GU)),
+            _mm_mullo_epi16(v, _mm_set1_epi16(COEF_GV))));
+        __m128i b = _mm_mullo_epi16(u, _mm_set1_epi16(COEF_BU));
+
+        __m128i lumaLow = _mm_sub_epi16(_mm_unpacklo_epi8(y, zero), yOffset);
+        __m128i lumaHigh = _mm_sub_epi16(_mm_unpackhi_epi8(y, zero), yOffset);
+        lumaLow = _mm_add_epi16(_mm_mullo_epi16(lumaLow, _mm_set1_epi16(COEF_Y)), round);
+        lumaHigh = _mm_add_epi16(_mm_mullo_epi16(lumaHigh, _mm_set1_epi16(COEF_Y)), round);
+
+        __m128i red = ConvertChannel(lumaLow, lumaHigh, r);
+        __m128i green = ConvertChannel(lumaLow, lumaHigh, g);
+        __m128i blue = ConvertChannel(lumaLow, lumaHigh, b);
+        __m128i rgLow = _mm_unpacklo_epi8(red, green);
+        __m128i rgHigh = _mm_unpackhi_epi8(red, green);
+        __m128i baLow = _mm_unpacklo_epi8(blue, alpha);
+        __m128i baHigh = _mm_unpackhi_epi8(blue, alpha);
+        __m128i* out = reinterpret_cast<__m128i*>(dst + x * RGBA_BYTES);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(rgLow, baLow));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rgLow, baLow));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rgHigh, baHigh)); // 2: pixels 8 to 11
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rgHigh, baHigh)); // 3: pixels 12 to 15
+    }
+    return x;
+}
+#else
+static uint32_t YuyvRowsSimd(const uint8_t*, const uint8_t*, uint8_t*, uint8_t*, uint8_t*, uint32_t, bool)
+{
+    return 0;
+}
+
+static uint32_t SwapUvRowSimd(const uint8_t*, uint8_t*, uint32_t)
+{
+    return 0;
+}
+
+static uint32_t RgbaRowSimd(const uint8_t*, const uint8_t*, uint8_t*, uint32_t, bool)
+{
+    return 0;
+}
+#endif
+
+static void ConvertYuyvToYuv420sp(const uint8_t* src, uint32_t srcStride, uint8_t* dstY, uint8_t* dstUv,
+                           uint32_t dstStride, uint32_t width, uint32_t height, bool swapUv, bool simd)
+{
+    for (uint32_t row = 0; row + 1 < height; row += 2) { // 2: two luma rows share one chroma row
+        const uint8_t* row0 = src + row * srcStride;
+        const uint8_t* row1 = row0 + srcStride;
+        uint8_t* dstY0 = dstY + row * dstStride;
+        uint8_t* dstY1 = dstY0 + dstStride;
+        uint8_t* uv = dstUv + (row / 2) * dstStride; // 2: two luma rows share one chroma row
+        uint32_t done = simd ? YuyvRowsSimd(row0, row1, dstY0, dstY1, uv, width, swapUv) : 0;
+        YuyvRowsScalar(row0, row1, dstY0, dstY1, uv, done, width, swapUv);
+    }
+}
+
+static void SwapYuv420spUv(const uint8_t* srcY, const uint8_t* srcUv, uint32_t srcStride,
+                           uint8_t* dstY, uint8_t* dstUv, uint32_t dstStride,
+                           uint32_t width, uint32_t height, bool simd)
+{
+    for (uint32_t row = 0; row < height; row++) {
+        (void)memcpy_s(dstY + row * dstStride, width, srcY + row * srcStride, width);
+    }
+    for (uint32_t row = 0; row < height / 2; row++) { // 2: chroma is subsampled vertically
+        const uint8_t* src = srcUv + row * srcStride;
+        uint8_t* dst = dstUv + row * dstStride;
+        uint32_t done = simd ? SwapUvRowSimd(src, dst, width) : 0;
+        SwapUvRowScalar(src, dst, done, width);
+    }
+}
+
+static void ConvertYuv420spToRgba(const uint8_t* srcY, const uint8_t* srcUv, uint32_t srcStride,
+                           uint8_t* dst, uint32_t dstStride, uint32_t width, uint32_t height, bool swapUv, bool simd)
+{
+    for (uint32_t row = 0; row < height; row++) {
+        const uint8_t* y = srcY + row * srcStride;
+        const uint8_t* uv = srcUv + (row / 2) * srcStride; // 2: chroma is subsampled vertically
+        uint8_t* rgba = dst + row * dstStride;
+        uint32_t done = simd ? RgbaRowSimd(y, uv, rgba, width, swapUv) : 0;
+        RgbaRowScalar(y, uv, rgba, done, width, swapUv);
+    }
+}
+
+void ImageConverter::YuyvToYuv420sp(const uint8_t* src, uint32_t srcStride,
+                                    uint8_t* dstY, uint8_t* dstUv, uint32_t dstStride,
+                                    uint32_t width, uint32_t height, bool swapUv)
+{
+    ConvertYuyvToYuv420sp(src, srcStride, dstY, dstUv, dstStride, width, height, swapUv, true);
+}
+
+void ImageConverter::YuyvToYuv420spScalar(const uint8_t* src, uint32_t srcStride,
+                                          uint8_t* dstY, uint8_t* dstUv, uint32_t dstStride,
+                                          uint32_t width, uint32_t height, bool swapUv)
+{
+    ConvertYuyvToYuv420sp(src, srcStride, dstY, dstUv, dstStride, width, height, swapUv, false);
+}
+
+void ImageConverter::Yuv420spSwapUv(const uint8_t* srcY, const uint8_t* srcUv, uint32_t srcStride,
+                                    uint8_t* dstY, uint8_t* dstUv, uint32_t dstStride,
+                                    uint32_t width, uint32_t height)
+{
+    SwapYuv420spUv(srcY, srcUv, srcStride, dstY, dstUv, dstStride, width, height, true);
+}
+
+void ImageConverter::Yuv420spSwapUvScalar(const uint8_t* srcY, const uint8_t* srcUv, uint32_t srcStride,
+                                          uint8_t* dstY, uint8_t* dstUv, uint32_t dstStride,
+                                          uint32_t width, uint32_t height)
+{
+    SwapYuv420spUv(srcY, srcUv, srcStride, dstY, dstUv, dstStride, width, height, false);
+}
+
+void ImageConverter::Yuv420spToRgba(const uint8_t* srcY, const uint8_t* srcUv, uint32_t srcStride,
+                                    uint8_t* dst, uint32_t dstStride,
+                                    uint32_t width, uint32_t height, bool swapUv)
+{
+    ConvertYuv420spToRgba(srcY, srcUv, srcStride, dst, dstStride, width, height, swapUv, true);
+}
+
+void ImageConverter::Yuv420spToRgbaScalar(const uint8_t* srcY, const uint8_t* srcUv, uint32_t srcStride,
+                                          uint8_t* dst, uint32_t dstStride,
+                                          uint32_t width, uint32_t height, bool swapUv)
+{
+    ConvertYuv420spToRgba(srcY, srcUv, srcStride, dst, dstStride, width, height, swapUv, false);
+}
+
+const char* ImageConverter::GetSimdName()
+{
+#if defined(CAMERA_CONVERT_NEON)
+    return "neon";
+#elif defined(CAMERA_CONVERT_SSE2)
+    return "sse2";
+#else
+    return "none";
+#endif
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_IMAGE_CONVERTER_H
+#define HOS_CAMERA_IMAGE_CONVERTER_H
+
+#include <cstdint>
+
+namespace OHOS::Camera {
+// Pixel format conversion kernels used by TransformNode.
+// Every conversion has a scalar reference path, the default path is vectorised with NEON or SSE2
+// when the target supports it and gives bit-exact the same output as the scalar one.
+// Strides are in bytes, width and height of yuv420 images must be even.
+class ImageConverter {
+public:
+    // YUYV422 packed -> NV12 (swapUv == false) or NV21 (swapUv == true).
+    static void YuyvToYuv420sp(const uint8_t* src, uint32_t srcStride,
+                               uint8_t* dstY, uint8_t* dstUv, uint32_t dstStride,
+                               uint32_t width, uint32_t height, bool swapUv);
+    static void YuyvToYuv420spScalar(const uint8_t* src, uint32_t srcStride,
+                                     uint8_t* dstY, uint8_t* dstUv, uint32_t dstStride,
+                                     uint32_t width, uint32_t height, bool swapUv);
+
+    // NV12 <-> NV21, the luma plane is copied and the chroma pairs are swapped.
+    static void Yuv420spSwapUv(const uint8_t* srcY, const uint8_t* srcUv, uint32_t srcStride,
+                               uint8_t* dstY, uint8_t* dstUv, uint32_t dstStride,
+                               uint32_t width, uint32_t height);
+    static void Yuv420spSwapUvScalar(const uint8_t* srcY, const uint8_t* srcUv, uint32_t srcStride,
+                                     uint8_t* dstY, uint8_t* dstUv, uint32_t dstStride,
+                                     uint32_t width, uint32_t height);
+
+    // NV12 (swapUv == false) or NV21 (swapUv == true) -> RGBA8888, BT.601 limited range.
+    static void Yuv420spToRgba(const uint8_t* srcY, const uint8_t* srcUv, uint32_t srcStride,
+                               uint8_t* dst, uint32_t dstStride,
+                               uint32_t width, uint32_t height, bool swapUv);
+    static void Yuv420spToRgbaScalar(const uint8_t* srcY, const uint8_t* srcUv, uint32_t srcStride,
+                                     uint8_t* dst, uint32_t dstStride,
+                                     uint32_t width, uint32_t height, bool swapUv);
+
+    // name of the vector extension used by the default path, "none" if there is no one.
+    static const char* GetSimdName();
+};
+} // namespace OHOS::Camera
+#endif
@@ -14,24 +14,165 @@
 #include "transform_node.h"
 
 namespace OHOS::Camera {
+namespace {
+    constexpr uint32_t YUYV_BYTES_PER_PIXEL = 2;
+    constexpr uint32_t RGBA_BYTES_PER_PIXEL = 4;
+}
+
 TransformNode::TransformNode(const std::string& name, const std::string& type)
-    :NodeBase(name, type, streamId)
+    :NodeBase(name, type)
 {
     CAMERA_LOGV("%{public}s enter, type(%{public}s)\n", name_.c_str(), type_.c_str());
 }
 
 RetCode TransformNode::Start(const int32_t streamId)
 {
+    if (streamRunning_ == true) {
+        return RC_OK;
+    }
+    outPutPorts_ = GetOutPorts();
+    AllocateBuffers();
+    // the output pool is resolved once, frames don't look it up in the buffer manager.
+    outPool_ = nullptr;
+    if (!outPutPorts_.empty()) {
+        outPool_ = Camera::BufferManager::GetInstance()->GetBufferPool(outPutPorts_[0]->format_.bufferPoolId_);
+    }
+    streamRunning_ = true;
     return RC_OK;
 }
 
 RetCode TransformNode::Stop(const int32_t streamId)
 {
+    streamRunning_ = false;
     return RC_OK;
 }
 
 void TransformNode::AllocateBuffers()
 {
+    // out port which needs buffers of its own gets a heap pool to convert into.
+    BufferManager* bufferManager = Camera::BufferManager::GetInstance();
+    for (auto& it : outPutPorts_) {
+        if (!it->format_.needAllocation_ || bufferManager->GetBufferPool(it->format_.bufferPoolId_) != nullptr) {
+            continue;
+        }
+        int64_t bufferPoolId = bufferManager->GenerateBufferPoolId();
+        std::shared_ptr<IBufferPool> bufferPool = bufferManager->GetBufferPool(bufferPoolId);
+        if (bufferPool == nullptr) {
+            CAMERA_LOGE("get bufferpool failed");
+            continue;
+        }
+        if (it->format_.maxBufferCount_ > it->format_.bufferCount_ &&
+            bufferPool->SetElasticPolicy(it->format_.maxBufferCount_, it->format_.bufferCount_) != RC_OK) {
+            CAMERA_LOGE("set elastic policy failed");
+            continue;
+        }
+        RetCode ret = bufferPool->Init(it->format_.w_, it->format_.h_, it->format_.usage_,
+            it->format_.format_, it->format_.bufferCount_, CAMERA_BUFFER_SOURCE_TYPE_HEAP);
+        if (ret != RC_OK) {
+            CAMERA_LOGE("bufferpool init failed");
+            continue;
+        }
+        it->format_.bufferPoolId_ = bufferPoolId;
+    }
+}
+
+void TransformNode::DeliverBuffer(std::shared_ptr<IBuffer>& buffer)
+{
+    if (buffer == nullptr) {
+        CAMERA_LOGE("buffer is null");
+        return;
+    }
+    if (outPutPorts_.empty()) {
+        ReturnBuffer(buffer);
+        return;
+    }
+
+    // transform node has only one output, frames already in the output pool or format pass through.
+    std::shared_ptr<IPort> outPort = outPutPorts_[0];
+    std::shared_ptr<IBufferPool> bufferPool = outPool_;
+    if (bufferPool == nullptr || buffer->GetPoolId() == outPort->format_.bufferPoolId_ ||
+        buffer->GetFormat() == static_cast<int32_t>(outPort->format_.format_)) {
+        outPort->DeliverBuffer(buffer);
+        return;
+    }
+
+    std::shared_ptr<IBuffer> target = bufferPool->AcquireBuffer();
+    if (target == nullptr) {
+        CAMERA_LOGE("acquire buffer failed, drop frame %{public}llu", buffer->GetFrameNumber());
+        ReturnBuffer(buffer);
+        return;
+    }
+    CameraBufferStatus status = buffer->GetBufferStatus();
+    if (status == CAMERA_BUFFER_STATUS_OK && ConvertBuffer(buffer, target) != RC_OK) {
+        status = CAMERA_BUFFER_STATUS_INVALID;
+    }
+    target->SetBufferStatus(status);
+    target->SetStreamId(buffer->GetStreamId());
+    target->SetCaptureId(buffer->GetCaptureId());
+    target->SetFrameNumber(buffer->GetFrameNumber());
+    target->SetTimestamp(buffer->GetTimestamp());
+    ReturnBuffer(buffer);
+    outPort->DeliverBuffer(target);
+}
+
+uint32_t TransformNode::GetRowBytes(const std::shared_ptr<IBuffer>& buffer, const uint32_t packedBytes)
+{
+    // buffers without a stride of their own are packed.
+    uint32_t stride = buffer->GetStride();
+    return stride >= packedBytes ? stride : packedBytes;
+}
+
+RetCode TransformNode::ConvertBuffer(const std::shared_ptr<IBuffer>& source, const std::shared_ptr<IBuffer>& target)
+{
+    uint32_t width = source->GetWidth();
+    uint32_t height = source->GetHeight();
+    int32_t srcFormat = source->GetFormat();
+    int32_t dstFormat = target->GetFormat();
+    const uint8_t* src = static_cast<const uint8_t*>(source->GetVirAddress());
+    uint8_t* dst = static_cast<uint8_t*>(target->GetVirAddress());
+    if (src == nullptr || dst == nullptr || target->GetWidth() != width || target->GetHeight() != height ||
+        (width & 1) != 0 || (height & 1) != 0) {
+        CAMERA_LOGE("can't convert %{public}ux%{public}u to %{public}ux%{public}u",
+            width, height, target->GetWidth(), target->GetHeight());
+        return RC_ERROR;
+    }
+
+    bool srcNv21 = srcFormat == CAMERA_FORMAT_YCRCB_420_SP;
+    bool dstNv21 = dstFormat == CAMERA_FORMAT_YCRCB_420_SP;
+    bool srcYuv420sp = srcNv21 || srcFormat == CAMERA_FORMAT_YCBCR_420_SP;
+    bool dstYuv420sp = dstNv21 || dstFormat == CAMERA_FORMAT_YCBCR_420_SP;
+    // yuv420sp has height rows of luma and height / 2 rows of chroma with the same stride.
+    uint32_t srcStride = GetRowBytes(source, srcYuv420sp ? width : width * YUYV_BYTES_PER_PIXEL);
+    uint32_t dstStride = GetRowBytes(target, dstYuv420sp ? width : width * RGBA_BYTES_PER_PIXEL);
+    uint32_t srcLumaSize = srcStride * height;
+    uint32_t dstLumaSize = dstStride * height;
+    uint32_t srcYuv420Size = srcLumaSize * 3 / 2; // 3 / 2: yuv420 size
+    uint32_t dstYuv420Size = dstLumaSize * 3 / 2; // 3 / 2: yuv420 size
+    if (srcFormat == CAMERA_FORMAT_YUYV_422_PKG && dstYuv420sp &&
+        source->GetSize() >= srcLumaSize && target->GetSize() >= dstYuv420Size) {
+        ImageConverter::YuyvToYuv420sp(src, srcStride, dst, dst + dstLumaSize, dstStride, width, height, dstNv21);
+        return RC_OK;
+    }
+    if (srcYuv420sp && dstYuv420sp && srcNv21 != dstNv21 &&
+        source->GetSize() >= srcYuv420Size && target->GetSize() >= dstYuv420Size) {
+        ImageConverter::Yuv420spSwapUv(src, src + srcLumaSize, srcStride,
+            dst, dst + dstLumaSize, dstStride, width, height);
+        return RC_OK;
+    }
+    if (srcYuv420sp && dstFormat == CAMERA_FORMAT_RGBA_8888 &&
+        source->GetSize() >= srcYuv420Size && target->GetSize() >= dstLumaSize) {
+        ImageConverter::Yuv420spToRgba(src, src + srcLumaSize, srcStride, dst, dstStride, width, height, srcNv21);
+        return RC_OK;
+    }
+    CAMERA_LOGE("unsupported transform from format %{public}d to %{public}d", srcFormat, dstFormat);
+    return RC_ERROR;
+}
+
+void TransformNode::ReturnBuffer(std::shared_ptr<IBuffer>& buffer)
+{
+    std::shared_ptr<IBufferPool> bufferPool = buffer->GetPool();
+    CHECK_IF_PTR_NULL_RETURN_VOID(bufferPool);
+    bufferPool->ReturnBuffer(buffer);
 }
 REGISTERNODE(TransformNode, {"transform"})
 }// namespace OHOS::Camera
@@ -16,6 +16,7 @@
 
 #include <vector>
 #include "device_manager_adapter.h"
+#include "image_converter.h"
 #include "utils.h"
 #include "camera.h"
 #include "node_base.h"
@@ -27,7 +28,18 @@ public:
     ~TransformNode() override = default;
     RetCode Start(const int32_t streamId) override;
     RetCode Stop(const int32_t streamId) override;
+    void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) override;
     void AllocateBuffers();
+
+private:
+    RetCode ConvertBuffer(const std::shared_ptr<IBuffer>& source, const std::shared_ptr<IBuffer>& target);
+    static uint32_t GetRowBytes(const std::shared_ptr<IBuffer>& buffer, const uint32_t packedBytes);
+    void ReturnBuffer(std::shared_ptr<IBuffer>& buffer);
+
+private:
+    std::vector<std::shared_ptr<IPort>>   outPutPorts_;
+    std::shared_ptr<IBufferPool>          outPool_ = nullptr;
+    std::atomic_bool                      streamRunning_ = false;
 };
 } // namespace OHOS::Camera
 #endif
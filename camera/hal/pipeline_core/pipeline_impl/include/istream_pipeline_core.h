@@ -43,6 +43,9 @@ public:
     virtual ~IStreamPipelineCore() = default;
     virtual std::shared_ptr<OfflinePipeline> GetOfflinePipeline(const int32_t id) = 0;
     virtual RetCode Capture(const std::vector<int32_t>& ids, const int32_t captureId) = 0;
+    // submit frameCount frames of one capture at once, they share the settings of last Config.
+    virtual RetCode CaptureBatch(const std::vector<int32_t>& ids, const int32_t captureId,
+        const uint32_t frameCount) = 0;
     virtual RetCode CancelCapture(const std::vector<int32_t>& ids) = 0;
     virtual OperationMode GetCurrentMode() const = 0;
     virtual DynamicStreamSwitchMode CheckStreamsSupported(OperationMode mode,
@@ -40,6 +40,9 @@ struct PortFormat {
     uint8_t needAllocation_;
     uint32_t bufferCount_;
     int64_t bufferPoolId_;
+    int32_t memoryType_;
+    uint32_t maxBufferCount_;
+    int32_t minFrameDuration_;
 };
 using PortFormat = struct PortFormat;
 
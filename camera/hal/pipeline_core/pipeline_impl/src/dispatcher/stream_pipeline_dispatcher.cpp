@@ -12,90 +12,208 @@
  */
 
 #include "stream_pipeline_dispatcher.h"
+#include <algorithm>
 
 namespace OHOS::Camera {
+namespace {
+    constexpr uint32_t NODE_WORKER_COUNT = 3;
+}
 
 std::unique_ptr<StreamPipelineDispatcher> StreamPipelineDispatcher::Create()
 {
     return std::make_unique<StreamPipelineDispatcher>();
 }
 
-void StreamPipelineDispatcher::GenerateNodeSeq(std::vector<std::shared_ptr<INode>>& nodeVec,
-            const std::shared_ptr<INode>& node)
+StreamPipelineDispatcher::~StreamPipelineDispatcher()
 {
-    if (node != nullptr) {
-        nodeVec.push_back(node);
-    } else {
-        return;
+    {
+        std::lock_guard<std::mutex> l(workerLock_);
+        workerExit_ = true;
     }
+    workerCv_.notify_all();
+    for (auto& it : workers_) {
+        it.join();
+    }
+}
 
-    if (node->GetNumberOfInPorts() == 0) {
-        return;
+void StreamPipelineDispatcher::GenerateNodeLevels(NodeLevels& levels, const std::vector<std::shared_ptr<INode>>& sinks)
+{
+    // the level of a node is its longest path to a sink, walked once without recursion.
+    std::unordered_map<std::shared_ptr<INode>, uint32_t> depth;
+    std::vector<std::shared_ptr<INode>> order;
+    std::vector<std::shared_ptr<INode>> stack;
+    for (const auto& it : sinks) {
+        depth[it] = 0;
+        order.push_back(it);
+        stack.push_back(it);
+    }
+    while (!stack.empty()) {
+        std::shared_ptr<INode> node = stack.back();
+        stack.pop_back();
+        uint32_t next = depth[node] + 1;
+        for (const auto& port : node->GetInPorts()) {
+            std::shared_ptr<IPort> peer = port->Peer();
+            std::shared_ptr<INode> upstream = peer == nullptr ? nullptr : peer->GetNode();
+            if (upstream == nullptr) {
+                continue;
+            }
+            auto it = depth.find(upstream);
+            if (it == depth.end()) {
+                order.push_back(upstream);
+            } else if (it->second >= next) {
+                continue;
+            }
+            depth[upstream] = next;
+            stack.push_back(upstream);
+        }
     }
 
-    for (const auto& it : node->GetInPorts()) {
-        GenerateNodeSeq(nodeVec, it->Peer()->GetNode());
+    levels.clear();
+    for (const auto& it : order) {
+        uint32_t level = depth[it];
+        if (levels.size() <= level) {
+            levels.resize(level + 1);
+        }
+        levels[level].push_back(it);
     }
 }
 
 RetCode StreamPipelineDispatcher::Update(const std::shared_ptr<Pipeline>& p)
 {
-    std::vector<std::shared_ptr<INode>> sink;
+    std::unordered_map<int, std::vector<std::shared_ptr<INode>>> sinks;
     for (auto it = p->nodes_.rbegin(); it < p->nodes_.rend(); it++) {
         if ((*it)->GetNumberOfInPorts() == 1 && (*it)->GetNumberOfOutPorts() == 0) {
-            sink.push_back(*it);
+            auto inPorts = (*it)->GetInPorts();
+            if (!inPorts.empty()) {
+                // sink node has only one port, and it is a in-port
+                sinks[inPorts[0]->GetStreamId()].push_back(*it);
+            }
         }
     }
 
     std::unordered_map<int, std::vector<std::shared_ptr<INode>>> seqNode;
-    for (const auto& it : sink) {
-        auto inPorts = it->GetInPorts();
-        if (!inPorts.empty()) {
-            // sink node has only one port, and it is a in-port
-            GenerateNodeSeq(seqNode[inPorts[0]->GetStreamId()], it);
+    std::unordered_map<int, NodeLevels> levels;
+    for (const auto& [streamId, nodes] : sinks) {
+        GenerateNodeLevels(levels[streamId], nodes);
+        for (const auto& level : levels[streamId]) {
+            seqNode[streamId].insert(seqNode[streamId].end(), level.begin(), level.end());
         }
     }
 
     std::swap(seqNode_, seqNode);
+    std::swap(levels_, levels);
     CAMERA_LOGI("------------------------Node Seq(UpStream) Dump Begin-------------\n");
-    for (auto [ss, vv] : seqNode_) {
+    for (const auto& [ss, ll] : levels_) {
         CAMERA_LOGI("sink stream id:%{public}d \n", ss);
-        for (auto it : vv) {
-            CAMERA_LOGI("seq node name:%{public}s\n", it->GetName().c_str());
+        for (uint32_t i = 0; i < ll.size(); i++) {
+            for (const auto& it : ll[i]) {
+                CAMERA_LOGI("seq node name:%{public}s, level:%{public}u\n", it->GetName().c_str(), i);
+            }
         }
     }
     CAMERA_LOGI("------------------------Node Seq(UpStream) Dump End-------------\n");
     return RC_OK;
 }
 
-RetCode StreamPipelineDispatcher::Prepare(const int32_t streamId)
+void StreamPipelineDispatcher::WorkerLoop()
 {
-    if (seqNode_.count(streamId) == 0) {
-        return RC_ERROR;
+    while (true) {
+        std::function<void()> task = nullptr;
+        {
+            std::unique_lock<std::mutex> l(workerLock_);
+            workerCv_.wait(l, [this] { return workerExit_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
     }
+}
 
+RetCode StreamPipelineDispatcher::RunLevel(const std::vector<std::shared_ptr<INode>>& level,
+    const NodeOperation& operation)
+{
+    if (level.size() == 1) {
+        return operation(level[0]);
+    }
+
+    // the caller runs the first node itself, the others are handed to the pool.
+    std::vector<RetCode> results(level.size(), RC_OK);
+    std::mutex doneLock;
+    std::condition_variable doneCv;
+    size_t pending = level.size() - 1;
+    {
+        std::lock_guard<std::mutex> l(workerLock_);
+        while (workers_.size() < std::min<size_t>(NODE_WORKER_COUNT, pending)) {
+            workers_.emplace_back(&StreamPipelineDispatcher::WorkerLoop, this);
+        }
+        for (size_t i = 1; i < level.size(); i++) {
+            tasks_.emplace_back([&, i] {
+                results[i] = operation(level[i]);
+                std::lock_guard<std::mutex> done(doneLock);
+                if (--pending == 0) {
+                    doneCv.notify_one();
+                }
+            });
+        }
+    }
+    workerCv_.notify_all();
+    results[0] = operation(level[0]);
+
+    std::unique_lock<std::mutex> l(doneLock);
+    doneCv.wait(l, [&pending] { return pending == 0; });
     RetCode re = RC_OK;
-    for (auto it = seqNode_[streamId].rbegin(); it != seqNode_[streamId].rend(); it++) {
-        CAMERA_LOGV("init node %{public}s begin", (*it)->GetName().c_str());
-        re = (*it)->Init(streamId) | re;
-        CAMERA_LOGV("init node %{public}s end", (*it)->GetName().c_str());
+    for (auto it : results) {
+        re = it | re;
     }
     return re;
 }
 
-RetCode StreamPipelineDispatcher::Start(const int32_t streamId)
+RetCode StreamPipelineDispatcher::RunByLevel(const int32_t streamId, bool fromSource, const NodeOperation& operation)
+{
+    const NodeLevels& levels = levels_[streamId];
+    RetCode re = RC_OK;
+    if (fromSource) {
+        for (auto it = levels.rbegin(); it != levels.rend(); it++) {
+            re = RunLevel(*it, operation) | re;
+        }
+    } else {
+        for (auto it = levels.begin(); it != levels.end(); it++) {
+            re = RunLevel(*it, operation) | re;
+        }
+    }
+    return re;
+}
+
+RetCode StreamPipelineDispatcher::Prepare(const int32_t streamId)
 {
     if (seqNode_.count(streamId) == 0) {
         return RC_ERROR;
     }
 
-    RetCode re = RC_OK;
-    for (auto it = seqNode_[streamId].rbegin(); it != seqNode_[streamId].rend(); it++) {
-        CAMERA_LOGV("start node %{public}s begin", (*it)->GetName().c_str());
-        re = (*it)->Start(streamId) | re;
-        CAMERA_LOGV("start node %{public}s end", (*it)->GetName().c_str());
+    return RunByLevel(streamId, true, [streamId](const std::shared_ptr<INode>& node) {
+        CAMERA_LOGV("init node %{public}s begin", node->GetName().c_str());
+        RetCode re = node->Init(streamId);
+        CAMERA_LOGV("init node %{public}s end", node->GetName().c_str());
+        return re;
+    });
+}
+
+RetCode StreamPipelineDispatcher::Start(const int32_t streamId)
+{
+    if (seqNode_.count(streamId) == 0) {
+        return RC_ERROR;
     }
-    return re;
+
+    // consumers are running before their producers, sources start last.
+    return RunByLevel(streamId, false, [streamId](const std::shared_ptr<INode>& node) {
+        CAMERA_LOGV("start node %{public}s begin", node->GetName().c_str());
+        RetCode re = node->Start(streamId);
+        CAMERA_LOGV("start node %{public}s end", node->GetName().c_str());
+        return re;
+    });
 }
 
 RetCode StreamPipelineDispatcher::Config(const int32_t streamId, const CaptureMeta& meta)
@@ -104,6 +222,7 @@ RetCode StreamPipelineDispatcher::Config(const int32_t streamId, const CaptureMe
         return RC_ERROR;
     }
 
+    // config is on the path of every request and cheap, it isn't worth a thread hand-off.
     RetCode re = RC_OK;
     for (auto it = seqNode_[streamId].rbegin(); it != seqNode_[streamId].rend(); it++) {
         re = (*it)->Config(streamId, meta) | re;
@@ -117,13 +236,12 @@ RetCode StreamPipelineDispatcher::Flush(const int32_t streamId)
         return RC_ERROR;
     }
 
-    RetCode re = RC_OK;
-    for (auto it = seqNode_[streamId].rbegin(); it != seqNode_[streamId].rend(); it++) {
-        CAMERA_LOGV("flush node %{public}s begin", (*it)->GetName().c_str());
-        re = (*it)->Flush(streamId) | re;
-        CAMERA_LOGV("flush node %{public}s end", (*it)->GetName().c_str());
-    }
-    return re;
+    return RunByLevel(streamId, true, [streamId](const std::shared_ptr<INode>& node) {
+        CAMERA_LOGV("flush node %{public}s begin", node->GetName().c_str());
+        RetCode re = node->Flush(streamId);
+        CAMERA_LOGV("flush node %{public}s end", node->GetName().c_str());
+        return re;
+    });
 }
 
 RetCode StreamPipelineDispatcher::Stop(const int32_t streamId)
@@ -132,13 +250,13 @@ RetCode StreamPipelineDispatcher::Stop(const int32_t streamId)
         return RC_OK;
     }
 
-    RetCode re = RC_OK;
-    for (auto it = seqNode_[streamId].rbegin(); it != seqNode_[streamId].rend(); it++) {
-        CAMERA_LOGV("stop node %{public}s begin", (*it)->GetName().c_str());
-        re = (*it)->Stop(streamId) | re;
-        CAMERA_LOGV("stop node %{public}s end", (*it)->GetName().c_str());
-    }
-    return re;
+    // producers stop before their consumers, sources stop first.
+    return RunByLevel(streamId, true, [streamId](const std::shared_ptr<INode>& node) {
+        CAMERA_LOGV("stop node %{public}s begin", node->GetName().c_str());
+        RetCode re = node->Stop(streamId);
+        CAMERA_LOGV("stop node %{public}s end", node->GetName().c_str());
+        return re;
+    });
 }
 
 RetCode StreamPipelineDispatcher::Capture(const int32_t streamId, const int32_t captureId)
@@ -177,6 +295,7 @@ RetCode StreamPipelineDispatcher::Destroy(const int32_t streamId)
         return RC_OK;
     }
     seqNode_.erase(streamId);
+    levels_.erase(streamId);
 
     return RC_OK;
 }
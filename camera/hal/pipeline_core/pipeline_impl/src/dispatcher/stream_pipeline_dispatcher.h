@@ -13,6 +13,11 @@
 
 #ifndef STREAM_PIPELINE_DISPATCHER_H
 #define STREAM_PIPELINE_DISPATCHER_H
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include "stream_pipeline_data_structure.h"
 #include "inode.h"
@@ -24,7 +29,7 @@ namespace OHOS::Camera {
 class StreamPipelineDispatcher : public NoCopyable, private ConfigParser {
 public:
     StreamPipelineDispatcher() = default;
-    virtual ~StreamPipelineDispatcher() = default;
+    virtual ~StreamPipelineDispatcher();
     static std::unique_ptr<StreamPipelineDispatcher> Create();
     virtual RetCode Update(const std::shared_ptr<Pipeline>& p);
     virtual RetCode Prepare(const int32_t id);
@@ -37,10 +42,26 @@ public:
     virtual RetCode Destroy(const int32_t id);
     virtual std::shared_ptr<INode> GetNode(const int32_t streamId, const std::string name);
 protected:
-    void GenerateNodeSeq(std::vector<std::shared_ptr<INode>>& nodeVec,
-                const std::shared_ptr<INode>& node);
+    using NodeLevels = std::vector<std::vector<std::shared_ptr<INode>>>;
+    using NodeOperation = std::function<RetCode(const std::shared_ptr<INode>&)>;
+    void GenerateNodeLevels(NodeLevels& levels, const std::vector<std::shared_ptr<INode>>& sinks);
+    RetCode RunByLevel(const int32_t streamId, bool fromSource, const NodeOperation& operation);
+    RetCode RunLevel(const std::vector<std::shared_ptr<INode>>& level, const NodeOperation& operation);
+    void WorkerLoop();
+
 protected:
+    // upstream order, sinks first.
     std::unordered_map<int, std::vector<std::shared_ptr<INode>>> seqNode_;
+    // levels_[streamId][n] holds the nodes whose longest path to the sink is n, nodes of a level don't
+    // depend on each other, all of their consumers are in lower levels.
+    std::unordered_map<int, NodeLevels> levels_;
+
+    // small pool running the lifecycle operations of the nodes of a level concurrently.
+    std::mutex workerLock_;
+    std::condition_variable workerCv_;
+    std::list<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+    bool workerExit_ = false;
 };
 }
 #endif
@@ -15,6 +15,14 @@
 #include "stream_pipeline_strategy.h"
 
 namespace OHOS::Camera {
+namespace {
+    // resolved specs of the recent stream configurations, enough for switching between the usual modes.
+    constexpr size_t MAX_SPEC_CACHE_SIZE = 16;
+    constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+    constexpr uint32_t HIGH_WORD_SHIFT = 32;
+}
+
 StreamPipelineStrategy::StreamPipelineStrategy(const std::shared_ptr<HostStreamMgr>& streamMgr,
     const std::shared_ptr<PipelineSpec>& spec) :
     hostStreamMgr_(streamMgr),
@@ -24,9 +32,17 @@ StreamPipelineStrategy::StreamPipelineStrategy(const std::shared_ptr<HostStreamM
 
 std::shared_ptr<PipelineSpec> StreamPipelineStrategy::GeneratePipelineSpec(const int32_t& mode)
 {
+    std::vector<uint64_t> signature;
+    std::vector<HostStreamInfo> streamInfos;
+    ConstructSignature(mode, signature, streamInfos);
     PipelineSpec pipe {};
-    if (SelectPipelineSpec(mode, pipe) != RC_OK) {
-        return nullptr;
+    auto it = specCache_.find(signature);
+    if (it == specCache_.end() || RestoreSpec(it->second, streamInfos, pipe) != RC_OK) {
+        pipe = {};
+        if (SelectPipelineSpec(mode, pipe) != RC_OK) {
+            return nullptr;
+        }
+        CacheSpec(signature, streamInfos, pipe);
     }
     if (CombineSpecs(pipe) != RC_OK) {
         return nullptr;
@@ -34,6 +50,90 @@ std::shared_ptr<PipelineSpec> StreamPipelineStrategy::GeneratePipelineSpec(const
     return pipelineSpec_;
 }
 
+size_t StreamPipelineStrategy::SpecSignatureHash::operator()(const std::vector<uint64_t>& signature) const
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (auto it : signature) {
+        hash = (hash ^ it) * FNV_PRIME;
+    }
+    return static_cast<size_t>(hash);
+}
+
+void StreamPipelineStrategy::ConstructSignature(const int32_t& mode, std::vector<uint64_t>& signature,
+    std::vector<HostStreamInfo>& streamInfos) const
+{
+    std::vector<int32_t> streamIds;
+    hostStreamMgr_->GetStreamIds(streamIds);
+    signature.push_back(static_cast<uint64_t>(static_cast<uint32_t>(mode)));
+    for (auto id : streamIds) {
+        HostStreamInfo info = hostStreamMgr_->GetStreamInfo(id);
+        signature.push_back((static_cast<uint64_t>(info.type_) << HIGH_WORD_SHIFT) |
+            static_cast<uint32_t>(info.format_));
+        signature.push_back((static_cast<uint64_t>(static_cast<uint32_t>(info.width_)) << HIGH_WORD_SHIFT) |
+            static_cast<uint32_t>(info.height_));
+        signature.push_back(info.usage_);
+        signature.push_back((static_cast<uint64_t>(info.bufferCount_) << HIGH_WORD_SHIFT) |
+            static_cast<uint32_t>(info.memoryType_));
+        signature.push_back((static_cast<uint64_t>(info.maxBufferCount_) << HIGH_WORD_SHIFT) |
+            static_cast<uint32_t>(info.minFrameDuration_));
+        streamInfos.push_back(info);
+    }
+}
+
+void StreamPipelineStrategy::CacheSpec(const std::vector<uint64_t>& signature,
+    const std::vector<HostStreamInfo>& streamInfos, const PipelineSpec& pipe)
+{
+    if (specCache_.size() >= MAX_SPEC_CACHE_SIZE) {
+        specCache_.clear();
+    }
+    CachedSpec cache = {pipe};
+    for (const auto& it : streamInfos) {
+        cache.streamIds.push_back(it.streamId_);
+        cache.bufferPoolIds.push_back(static_cast<int64_t>(it.bufferPoolId_));
+    }
+    for (size_t i = 0; i < pipe.nodeSpecSet_.size(); i++) {
+        if (GetTypeId(pipe.nodeSpecSet_[i].type_, G_STREAM_TABLE_PTR, G_STREAM_TABLE_SIZE)) {
+            cache.streamNodes.push_back(i);
+        }
+    }
+    specCache_[signature] = std::move(cache);
+}
+
+RetCode StreamPipelineStrategy::RestoreSpec(const CachedSpec& cache, const std::vector<HostStreamInfo>& streamInfos,
+    PipelineSpec& pipe) const
+{
+    if (cache.streamIds.size() != streamInfos.size()) {
+        return RC_ERROR;
+    }
+    // same configuration of new streams, only stream ids and buffer pool ids are different.
+    std::unordered_map<uint32_t, uint32_t> streamIds;
+    std::unordered_map<int64_t, int64_t> bufferPoolIds;
+    for (size_t i = 0; i < streamInfos.size(); i++) {
+        streamIds[cache.streamIds[i]] = streamInfos[i].streamId_;
+        bufferPoolIds[cache.bufferPoolIds[i]] = static_cast<int64_t>(streamInfos[i].bufferPoolId_);
+    }
+    pipe = cache.pipe;
+    for (auto& node : pipe.nodeSpecSet_) {
+        for (auto& port : node.portSpecSet_) {
+            auto id = streamIds.find(port.format_.streamId_);
+            if (id != streamIds.end()) {
+                port.format_.streamId_ = id->second;
+            }
+            auto poolId = bufferPoolIds.find(port.format_.bufferPoolId_);
+            if (port.format_.bufferPoolId_ != 0 && poolId != bufferPoolIds.end()) {
+                port.format_.bufferPoolId_ = poolId->second;
+            }
+        }
+    }
+    for (auto index : cache.streamNodes) {
+        auto id = streamIds.find(pipe.nodeSpecSet_[index].streamId_);
+        if (id != streamIds.end()) {
+            pipe.nodeSpecSet_[index].streamId_ = id->second;
+        }
+    }
+    return RC_OK;
+}
+
 std::string StreamPipelineStrategy::ConstructKeyStrIndex(const int32_t& mode)
 {
     std::string keyStr;
@@ -105,7 +205,10 @@ PortFormat StreamPipelineStrategy::SetPortFormat(G_PIPELINE_SPEC_DATA_TYPE &pipe
         .format_ = hostStreamInfo.format_,
         .usage_ = hostStreamInfo.usage_,
         .needAllocation_ = pipeSpecPtr->nodeSpec[j].portSpec[k].need_allocation,
-        .bufferCount_ = hostStreamInfo.bufferCount_
+        .bufferCount_ = hostStreamInfo.bufferCount_,
+        .memoryType_ = hostStreamInfo.memoryType_,
+        .maxBufferCount_ = hostStreamInfo.maxBufferCount_,
+        .minFrameDuration_ = hostStreamInfo.minFrameDuration_
     };
     CAMERA_LOGI("buffercount = %{public}d", f.bufferCount_);
     return f;
@@ -113,14 +216,26 @@ PortFormat StreamPipelineStrategy::SetPortFormat(G_PIPELINE_SPEC_DATA_TYPE &pipe
 
 void StreamPipelineStrategy::InitPipeSpecPtr(G_PIPELINE_SPEC_DATA_TYPE &pipeSpecPtr, std::string keyStr)
 {
-    for (int i = 0; i < G_PIPELINE_SPECS_SIZE; i++) {
-        if (G_PIPELINE_SPECS_TABLE[i].name == keyStr) {
-            pipeSpecPtr = &G_PIPELINE_SPECS_TABLE[i];
-            break;
-        }
+    G_PIPELINE_SPEC_DATA_TYPE spec = FindPipelineSpec(keyStr);
+    if (spec != nullptr) {
+        pipeSpecPtr = spec;
     }
 }
 
+G_PIPELINE_SPEC_DATA_TYPE StreamPipelineStrategy::FindPipelineSpec(const std::string& keyStr)
+{
+    // the spec table doesn't change after it's loaded, index it by name once.
+    static const std::unordered_map<std::string, G_PIPELINE_SPEC_DATA_TYPE> specIndex = [] {
+        std::unordered_map<std::string, G_PIPELINE_SPEC_DATA_TYPE> index;
+        for (int i = 0; i < G_PIPELINE_SPECS_SIZE; i++) {
+            index.emplace(G_PIPELINE_SPECS_TABLE[i].name, &G_PIPELINE_SPECS_TABLE[i]);
+        }
+        return index;
+    }();
+    auto it = specIndex.find(keyStr);
+    return it == specIndex.end() ? nullptr : it->second;
+}
+
 RetCode StreamPipelineStrategy::SelectPipelineSpec(const int32_t& mode, PipelineSpec& pipe)
 {
     std::string keyStr = ConstructKeyStrIndex(mode);
@@ -261,12 +376,6 @@ RetCode StreamPipelineStrategy::CheckPipelineSpecExist(const int32_t mode, const
         keyStr += "_" + streamStr;
     }
 
-    for (int i = 0; i < G_PIPELINE_SPECS_SIZE; i++) {
-        if (G_PIPELINE_SPECS_TABLE[i].name == keyStr) {
-            return RC_OK;
-        }
-    }
-
-    return RC_ERROR;
+    return FindPipelineSpec(keyStr) != nullptr ? RC_OK : RC_ERROR;
 }
 }
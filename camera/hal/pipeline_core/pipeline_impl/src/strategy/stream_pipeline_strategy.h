@@ -14,6 +14,7 @@
 #ifndef STREAM_PIPELINE_STRATEGY_H
 #define STREAM_PIPELINE_STRATEGY_H
 
+#include <unordered_map>
 #include "stream_pipeline_data_structure.h"
 #include "host_stream_mgr.h"
 #include "object_factory.h"
@@ -40,10 +41,29 @@ protected:
     virtual RetCode SelectPipelineSpec(const int32_t& mode, PipelineSpec& pipe);
     void PrintConnection(const NodeSpec& n);
     RetCode CombineSpecs(PipelineSpec& pipe);
+    static G_PIPELINE_SPEC_DATA_TYPE FindPipelineSpec(const std::string& keyStr);
+
+    // scene and everything of the host streams which the selected spec depends on, except ids.
+    struct SpecSignatureHash {
+        size_t operator()(const std::vector<uint64_t>& signature) const;
+    };
+    struct CachedSpec {
+        PipelineSpec pipe;
+        std::vector<int32_t> streamIds;
+        std::vector<int64_t> bufferPoolIds;
+        std::vector<size_t> streamNodes;
+    };
+    void ConstructSignature(const int32_t& mode, std::vector<uint64_t>& signature,
+        std::vector<HostStreamInfo>& streamInfos) const;
+    void CacheSpec(const std::vector<uint64_t>& signature, const std::vector<HostStreamInfo>& streamInfos,
+        const PipelineSpec& pipe);
+    RetCode RestoreSpec(const CachedSpec& cache, const std::vector<HostStreamInfo>& streamInfos,
+        PipelineSpec& pipe) const;
 
 protected:
     std::shared_ptr<HostStreamMgr> hostStreamMgr_ = nullptr;
     std::shared_ptr<PipelineSpec> pipelineSpec_ = nullptr;
+    std::unordered_map<std::vector<uint64_t>, CachedSpec, SpecSignatureHash> specCache_ = {};
 };
 }
 #endif
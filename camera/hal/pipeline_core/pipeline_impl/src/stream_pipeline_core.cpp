@@ -119,6 +119,19 @@ RetCode StreamPipelineCore::Capture(const std::vector<int>& streamIds, const int
     return re;
 }
 
+RetCode StreamPipelineCore::CaptureBatch(const std::vector<int>& streamIds, const int32_t captureId,
+    const uint32_t frameCount)
+{
+    std::lock_guard<std::mutex> l(mutex_);
+    RetCode re = RC_OK;
+    for (const auto& it : streamIds) {
+        for (uint32_t i = 0; i < frameCount; i++) {
+            re = dispatcher_->Capture(it, captureId) | re;
+        }
+    }
+    return re;
+}
+
 RetCode StreamPipelineCore::CancelCapture(const std::vector<int>& streamIds)
 {
     std::lock_guard<std::mutex> l(mutex_);
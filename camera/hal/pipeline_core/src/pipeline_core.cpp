@@ -27,6 +27,8 @@ void PipelineCore::UpdateMetadata(std::shared_ptr<CameraStandard::CameraMetadata
     RetCode rc = RC_OK;
     std::shared_ptr<IDeviceManager> deviceManager = IDeviceManager::GetInstance();
     deviceManager->Configure(meta);
+    // changed after the device is configured, a capture which sees the old version is applied before.
+    metadataVersion_++;
     if (rc == RC_ERROR) {
         CAMERA_LOGE("update metadata failed.");
         return;
@@ -34,6 +36,11 @@ void PipelineCore::UpdateMetadata(std::shared_ptr<CameraStandard::CameraMetadata
     return;
 }
 
+uint64_t PipelineCore::GetMetadataVersion() const
+{
+    return metadataVersion_.load();
+}
+
 std::shared_ptr<HostStreamMgr> PipelineCore::GetHostStreamMgr() const
 {
     return context_->streamMgr_;
@@ -14,6 +14,7 @@
 #ifndef PIPELINE_CORE_H
 #define PIPELINE_CORE_H
 
+#include <atomic>
 #include "ipipeline_core.h"
 
 namespace OHOS::Camera {
@@ -21,6 +22,7 @@ class PipelineCore : public IPipelineCore {
 public:
     RetCode Init() override;
     void UpdateMetadata(std::shared_ptr<CameraStandard::CameraMetadata> meta) override;
+    uint64_t GetMetadataVersion() const override;
     std::shared_ptr<HostStreamMgr> GetHostStreamMgr() const override;
     std::shared_ptr<IStreamPipelineCore> GetStreamPipelineCore() const override;
     PipelineCore() = default;
@@ -28,6 +30,7 @@ public:
 protected:
     std::shared_ptr<NodeContext> context_ = nullptr;
     std::shared_ptr<IStreamPipelineCore> spc_ = nullptr;
+    std::atomic<uint64_t> metadataVersion_ = 0;
 };
 }
 #endif
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+#include "gmock/gmock.h"
+#include "algo_plugin.h"
+#include "image_buffer.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+    constexpr const char* ALGO_EXAMPLE_PATH = "/system/lib/libcamera_ipp_algo_example.z.so";
+    constexpr uint32_t FRAME_WIDTH = 64;
+    constexpr uint32_t FRAME_HEIGHT = 48;
+    constexpr uint32_t FRAME_COUNT = 100;
+}
+
+class AlgoPluginTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+
+    void SetUp(void);
+    void TearDown(void);
+
+    static std::shared_ptr<IBuffer> CreateBuffer(std::vector<uint8_t>& memory);
+    // run frames through the plugin and return the descriptors allocated in them.
+    static uint32_t ProcessFrames(AlgoPlugin& plugin, uint32_t inBufferCount, uint32_t frameCount);
+
+    std::shared_ptr<AlgoPlugin> plugin_ = nullptr;
+};
+
+void AlgoPluginTest::SetUpTestCase(void)
+{
+    std::cout << "Camera::AlgoPluginTest SetUpTestCase" << std::endl;
+}
+
+void AlgoPluginTest::TearDownTestCase(void)
+{
+    std::cout << "Camera::AlgoPluginTest TearDownTestCase" << std::endl;
+}
+
+void AlgoPluginTest::SetUp(void)
+{
+    std::cout << "Camera::AlgoPluginTest SetUp" << std::endl;
+    plugin_ = std::make_shared<AlgoPlugin>("example", "ipp algo example", 0, ALGO_EXAMPLE_PATH);
+    EXPECT_EQ(true, plugin_->LoadLib() == RC_OK);
+    EXPECT_EQ(true, plugin_->Init(nullptr) == RC_OK);
+    EXPECT_EQ(true, plugin_->Start() == RC_OK);
+}
+
+void AlgoPluginTest::TearDown(void)
+{
+    std::cout << "Camera::AlgoPluginTest TearDown.." << std::endl;
+    plugin_->Stop();
+    plugin_ = nullptr;
+}
+
+std::shared_ptr<IBuffer> AlgoPluginTest::CreateBuffer(std::vector<uint8_t>& memory)
+{
+    std::shared_ptr<IBuffer> buffer = std::make_shared<ImageBuffer>(CAMERA_BUFFER_SOURCE_TYPE_HEAP,
+        FRAME_WIDTH, FRAME_HEIGHT, 0, CAMERA_FORMAT_YCRCB_420_SP);
+    buffer->SetStride(FRAME_WIDTH);
+    buffer->SetSize(memory.size());
+    buffer->SetVirAddress(memory.data());
+    return buffer;
+}
+
+uint32_t AlgoPluginTest::ProcessFrames(AlgoPlugin& plugin, uint32_t inBufferCount, uint32_t frameCount)
+{
+    uint32_t frameSize = FRAME_WIDTH * FRAME_HEIGHT * 3 / 2; // 3 / 2: yuv420 size
+    std::vector<std::vector<uint8_t>> memory(inBufferCount + 1, std::vector<uint8_t>(frameSize));
+    std::shared_ptr<IBuffer> outBuffer = CreateBuffer(memory[inBufferCount]);
+    std::vector<std::shared_ptr<IBuffer>> inBuffers;
+    for (uint32_t i = 0; i < inBufferCount; i++) {
+        inBuffers.emplace_back(CreateBuffer(memory[i]));
+    }
+
+    uint32_t begin = plugin.GetAlgoBufferAllocCount();
+    std::shared_ptr<CameraStandard::CameraMetadata> meta = nullptr;
+    for (uint32_t i = 0; i < frameCount; i++) {
+        uint32_t count = plugin.GetAlgoBufferAllocCount();
+        EXPECT_EQ(true, plugin.Process(outBuffer, inBuffers, meta) == RC_OK);
+        std::cout << "frame " << i << " allocations " << plugin.GetAlgoBufferAllocCount() - count << std::endl;
+    }
+    return plugin.GetAlgoBufferAllocCount() - begin;
+}
+
+HWTEST_F(AlgoPluginTest, ProcessWithoutAllocation, TestSize.Level0)
+{
+    EXPECT_EQ(true, ProcessFrames(*plugin_, 1, FRAME_COUNT) == 0);
+    EXPECT_EQ(true, ProcessFrames(*plugin_, 2, FRAME_COUNT) == 0); // 2: merge of two cameras
+}
+
+HWTEST_F(AlgoPluginTest, ProcessGrowsOnce, TestSize.Level0)
+{
+    // more inputs than preallocated grow the descriptors of the set in use, later frames reuse it.
+    uint32_t inBufferCount = 8;
+    EXPECT_EQ(true, ProcessFrames(*plugin_, inBufferCount, 1) == 1);
+    EXPECT_EQ(true, ProcessFrames(*plugin_, inBufferCount, FRAME_COUNT) <= 1);
+    EXPECT_EQ(true, ProcessFrames(*plugin_, 1, FRAME_COUNT) == 0);
+}
+
+HWTEST_F(AlgoPluginTest, ProcessNullBuffers, TestSize.Level0)
+{
+    std::shared_ptr<IBuffer> outBuffer = nullptr;
+    std::vector<std::shared_ptr<IBuffer>> inBuffers = {nullptr, nullptr};
+    std::shared_ptr<CameraStandard::CameraMetadata> meta = nullptr;
+    EXPECT_EQ(true, plugin_->Process(outBuffer, inBuffers, meta) != RC_OK);
+    EXPECT_EQ(true, plugin_->GetAlgoBufferAllocCount() == 0);
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "gmock/gmock.h"
+#include "buffer_manager.h"
+#include "fork_node.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+    constexpr int32_t MAIN_STREAM_ID = 1;
+    constexpr int32_t FORK_STREAM_ID = 2;
+    constexpr uint32_t POOL_BUFFER_COUNT = 4;
+    constexpr uint32_t POOL_WIDTH = 64;
+    constexpr uint32_t POOL_HEIGHT = 48;
+    constexpr uint8_t FRAME_PATTERN = 0x5a;
+    constexpr int32_t WAIT_LOOPS = 100;
+    constexpr int32_t WAIT_MS = 10;
+
+    // downstream of fork node, records the memory of the buffers it gets and returns them to their pools.
+    class RecordNode : public NodeBase {
+    public:
+        RecordNode(const std::string& name, const std::string& type) : NodeBase(name, type) {}
+        ~RecordNode() override = default;
+        void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) override
+        {
+            {
+                std::lock_guard<std::mutex> l(lock_);
+                uint8_t* addr = static_cast<uint8_t*>(buffer->GetVirAddress());
+                addresses_.push_back(addr);
+                firstBytes_.push_back(addr == nullptr ? 0 : addr[0]);
+            }
+            std::shared_ptr<IBufferPool> pool = BufferManager::GetInstance()->GetBufferPool(buffer->GetPoolId());
+            if (pool != nullptr) {
+                pool->ReturnBuffer(buffer);
+            }
+        }
+        // the fork thread delivers asynchronously.
+        bool WaitFor(size_t count)
+        {
+            for (int32_t i = 0; i < WAIT_LOOPS; i++) {
+                {
+                    std::lock_guard<std::mutex> l(lock_);
+                    if (addresses_.size() >= count) {
+                        return true;
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_MS));
+            }
+            return false;
+        }
+
+        std::mutex lock_;
+        std::vector<void*> addresses_;
+        std::vector<uint8_t> firstBytes_;
+    };
+}
+
+class ForkNodeTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+
+    void SetUp(void);
+    void TearDown(void);
+
+    static std::shared_ptr<IBufferPool> CreatePool(int64_t& poolId);
+    void Connect(const std::string& outName, const std::shared_ptr<RecordNode>& sink, const PortFormat& format);
+
+    std::shared_ptr<ForkNode> fork_ = nullptr;
+    std::shared_ptr<RecordNode> mainSink_ = nullptr;
+    std::shared_ptr<RecordNode> forkSink_ = nullptr;
+};
+
+void ForkNodeTest::SetUpTestCase(void)
+{
+    std::cout << "Camera::ForkNodeTest SetUpTestCase" << std::endl;
+}
+
+void ForkNodeTest::TearDownTestCase(void)
+{
+    std::cout << "Camera::ForkNodeTest TearDownTestCase" << std::endl;
+}
+
+void ForkNodeTest::SetUp(void)
+{
+    std::cout << "Camera::ForkNodeTest SetUp" << std::endl;
+    fork_ = std::make_shared<ForkNode>("fork", "fork");
+    mainSink_ = std::make_shared<RecordNode>("mainsink", "sink");
+    forkSink_ = std::make_shared<RecordNode>("forksink", "sink");
+}
+
+void ForkNodeTest::TearDown(void)
+{
+    std::cout << "Camera::ForkNodeTest TearDown.." << std::endl;
+    fork_ = nullptr;
+    mainSink_ = nullptr;
+    forkSink_ = nullptr;
+}
+
+std::shared_ptr<IBufferPool> ForkNodeTest::CreatePool(int64_t& poolId)
+{
+    BufferManager* manager = BufferManager::GetInstance();
+    poolId = manager->GenerateBufferPoolId();
+    std::shared_ptr<IBufferPool> pool = manager->GetBufferPool(poolId);
+    EXPECT_TRUE(pool->Init(POOL_WIDTH, POOL_HEIGHT, CAMERA_USAGE_SW_WRITE_OFTEN, CAMERA_FORMAT_YCRCB_420_SP,
+        POOL_BUFFER_COUNT, CAMERA_BUFFER_SOURCE_TYPE_HEAP) == RC_OK);
+    return pool;
+}
+
+void ForkNodeTest::Connect(const std::string& outName, const std::shared_ptr<RecordNode>& sink,
+    const PortFormat& format)
+{
+    std::shared_ptr<IPort> outPort = fork_->GetPort(outName);
+    std::shared_ptr<IPort> inPort = sink->GetPort("in0");
+    outPort->SetFormat(format);
+    inPort->SetFormat(format);
+    outPort->Connect(inPort);
+    inPort->Connect(outPort);
+}
+
+HWTEST_F(ForkNodeTest, ShareViewTest, TestSize.Level0)
+{
+    int64_t poolId = -1;
+    std::shared_ptr<IBufferPool> pool = CreatePool(poolId);
+    PortFormat format = {};
+    format.streamId_ = MAIN_STREAM_ID;
+    format.bufferPoolId_ = poolId;
+    fork_->GetPort("in0")->SetFormat(format);
+    Connect("out0", mainSink_, format);
+    // the forked consumer only reads the frame from the same pool.
+    format.streamId_ = FORK_STREAM_ID;
+    format.usage_ = CAMERA_USAGE_SW_READ_OFTEN;
+    Connect("out1", forkSink_, format);
+
+    EXPECT_EQ(RC_OK, fork_->Start(MAIN_STREAM_ID));
+    std::shared_ptr<IBuffer> buffer = pool->AcquireBuffer(0);
+    EXPECT_TRUE(buffer != nullptr);
+    void* addr = buffer->GetVirAddress();
+    buffer->SetStreamId(MAIN_STREAM_ID);
+    fork_->DeliverBuffer(buffer);
+    EXPECT_EQ(true, forkSink_->WaitFor(1));
+    EXPECT_EQ(RC_OK, fork_->Stop(MAIN_STREAM_ID));
+
+    // both streams get the same memory, the buffer is idle once both have returned it.
+    EXPECT_EQ(1, mainSink_->addresses_.size());
+    EXPECT_EQ(1, forkSink_->addresses_.size());
+    EXPECT_EQ(addr, forkSink_->addresses_[0]);
+    EXPECT_EQ(POOL_BUFFER_COUNT, pool->GetIdleBufferCount());
+}
+
+HWTEST_F(ForkNodeTest, CopyTunnelTest, TestSize.Level0)
+{
+    int64_t poolId = -1;
+    std::shared_ptr<IBufferPool> pool = CreatePool(poolId);
+    int64_t forkPoolId = -1;
+    std::shared_ptr<IBufferPool> forkPool = CreatePool(forkPoolId);
+    PortFormat format = {};
+    format.streamId_ = MAIN_STREAM_ID;
+    format.bufferPoolId_ = poolId;
+    fork_->GetPort("in0")->SetFormat(format);
+    Connect("out0", mainSink_, format);
+    // the forked stream has buffers of its own pool, like a tunnel.
+    format.streamId_ = FORK_STREAM_ID;
+    format.bufferPoolId_ = forkPoolId;
+    Connect("out1", forkSink_, format);
+
+    EXPECT_EQ(RC_OK, fork_->Start(MAIN_STREAM_ID));
+    std::shared_ptr<IBuffer> buffer = pool->AcquireBuffer(0);
+    EXPECT_TRUE(buffer != nullptr);
+    void* addr = buffer->GetVirAddress();
+    static_cast<uint8_t*>(addr)[0] = FRAME_PATTERN;
+    buffer->SetStreamId(MAIN_STREAM_ID);
+    fork_->DeliverBuffer(buffer);
+    EXPECT_EQ(true, forkSink_->WaitFor(1));
+    EXPECT_EQ(RC_OK, fork_->Stop(MAIN_STREAM_ID));
+
+    // the forked stream gets a copy in a buffer of its own pool.
+    EXPECT_EQ(1, forkSink_->addresses_.size());
+    EXPECT_NE(addr, forkSink_->addresses_[0]);
+    EXPECT_EQ(FRAME_PATTERN, forkSink_->firstBytes_[0]);
+    EXPECT_EQ(POOL_BUFFER_COUNT, pool->GetIdleBufferCount());
+    EXPECT_EQ(POOL_BUFFER_COUNT, forkPool->GetIdleBufferCount());
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "gmock/gmock.h"
+#include "image_buffer.h"
+#include "merge_node.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+    constexpr uint32_t POOL_BUFFER_COUNT = 4;
+    constexpr uint32_t POOL_WIDTH = 64;
+    constexpr uint32_t POOL_HEIGHT = 48;
+    constexpr int32_t FRAME_DURATION = 33333; // 30fps in us
+    constexpr uint64_t MS = 1000000; // ms in ns
+    constexpr uint64_t BASE_TIMESTAMP = 1000 * MS;
+    constexpr int32_t WAIT_LOOPS = 100;
+    constexpr int32_t WAIT_MS = 10;
+
+    using Delivered = std::vector<std::pair<uint64_t, CameraBufferStatus>>;
+
+    // downstream of merge node, records the buffers it gets and returns them to their pools like a stream.
+    class RecordNode : public NodeBase {
+    public:
+        RecordNode(const std::string& name, const std::string& type) : NodeBase(name, type) {}
+        ~RecordNode() override = default;
+        void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) override
+        {
+            {
+                std::lock_guard<std::mutex> l(lock_);
+                delivered_.push_back({buffer->GetTimestamp(), buffer->GetBufferStatus()});
+            }
+            std::shared_ptr<IBufferPool> pool = BufferManager::GetInstance()->GetBufferPool(buffer->GetPoolId());
+            if (pool != nullptr) {
+                pool->ReturnBuffer(buffer);
+            }
+        }
+        Delivered Get()
+        {
+            std::lock_guard<std::mutex> l(lock_);
+            return delivered_;
+        }
+        // the merge thread delivers asynchronously.
+        Delivered WaitFor(size_t count)
+        {
+            for (int32_t i = 0; i < WAIT_LOOPS; i++) {
+                Delivered d = Get();
+                if (d.size() >= count) {
+                    return d;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_MS));
+            }
+            return Get();
+        }
+
+    private:
+        std::mutex lock_;
+        Delivered delivered_;
+    };
+}
+
+class MergeNodeTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+
+    void SetUp(void);
+    void TearDown(void);
+
+    std::shared_ptr<FrameSpec> MakeFrame(const int64_t poolId, const uint64_t timestamp);
+
+    std::shared_ptr<MergeNode> merge_ = nullptr;
+    // one sink for the out port of each pool.
+    std::shared_ptr<RecordNode> sinkA_ = nullptr;
+    std::shared_ptr<RecordNode> sinkB_ = nullptr;
+    std::shared_ptr<IBufferPool> poolA_ = nullptr;
+    std::shared_ptr<IBufferPool> poolB_ = nullptr;
+    int64_t poolIdA_ = -1;
+    int64_t poolIdB_ = -1;
+};
+
+void MergeNodeTest::SetUpTestCase(void)
+{
+    std::cout << "Camera::MergeNodeTest SetUpTestCase" << std::endl;
+}
+
+void MergeNodeTest::TearDownTestCase(void)
+{
+    std::cout << "Camera::MergeNodeTest TearDownTestCase" << std::endl;
+}
+
+void MergeNodeTest::SetUp(void)
+{
+    std::cout << "Camera::MergeNodeTest SetUp" << std::endl;
+    BufferManager* manager = BufferManager::GetInstance();
+    merge_ = std::make_shared<MergeNode>("merge", "merge");
+    sinkA_ = std::make_shared<RecordNode>("sinka", "sink");
+    sinkB_ = std::make_shared<RecordNode>("sinkb", "sink");
+    int32_t index = 0;
+    for (auto& sink : {sinkA_, sinkB_}) {
+        int64_t poolId = manager->GenerateBufferPoolId();
+        std::shared_ptr<IBufferPool> pool = manager->GetBufferPool(poolId);
+        EXPECT_TRUE(pool->Init(POOL_WIDTH, POOL_HEIGHT, CAMERA_USAGE_SW_WRITE_OFTEN, CAMERA_FORMAT_YCRCB_420_SP,
+            POOL_BUFFER_COUNT, CAMERA_BUFFER_SOURCE_TYPE_HEAP) == RC_OK);
+        (sink == sinkA_ ? poolA_ : poolB_) = pool;
+        (sink == sinkA_ ? poolIdA_ : poolIdB_) = poolId;
+        PortFormat format = {};
+        format.bufferPoolId_ = poolId;
+        format.minFrameDuration_ = FRAME_DURATION;
+        std::string suffix = std::to_string(index++);
+        merge_->GetPort("in" + suffix)->SetFormat(format);
+        std::shared_ptr<IPort> outPort = merge_->GetPort("out" + suffix);
+        std::shared_ptr<IPort> inPort = sink->GetPort("in0");
+        outPort->SetFormat(format);
+        inPort->SetFormat(format);
+        outPort->Connect(inPort);
+        inPort->Connect(outPort);
+    }
+}
+
+void MergeNodeTest::TearDown(void)
+{
+    std::cout << "Camera::MergeNodeTest TearDown.." << std::endl;
+    merge_ = nullptr;
+    sinkA_ = nullptr;
+    sinkB_ = nullptr;
+    poolA_ = nullptr;
+    poolB_ = nullptr;
+}
+
+std::shared_ptr<FrameSpec> MergeNodeTest::MakeFrame(const int64_t poolId, const uint64_t timestamp)
+{
+    auto frameSpec = std::make_shared<FrameSpec>();
+    frameSpec->bufferPoolId_ = poolId;
+    frameSpec->buffer_ = BufferManager::GetInstance()->GetBufferPool(poolId)->AcquireBuffer(0);
+    EXPECT_TRUE(frameSpec->buffer_ != nullptr);
+    if (frameSpec->buffer_ != nullptr) {
+        frameSpec->buffer_->SetTimestamp(timestamp);
+    }
+    return frameSpec;
+}
+
+HWTEST_F(MergeNodeTest, MatchFramesTest, TestSize.Level0)
+{
+    EXPECT_EQ(RC_OK, merge_->Start(0));
+    // 10ms apart is within half of the frame duration, but beyond the default tolerance.
+    merge_->DeliverBuffers(MakeFrame(poolIdA_, BASE_TIMESTAMP));
+    merge_->DeliverBuffers(MakeFrame(poolIdB_, BASE_TIMESTAMP + 10 * MS));
+    // inputs arrive out of order, frames are matched by timestamp.
+    merge_->DeliverBuffers(MakeFrame(poolIdB_, BASE_TIMESTAMP + 35 * MS));
+    merge_->DeliverBuffers(MakeFrame(poolIdA_, BASE_TIMESTAMP + 33 * MS));
+    sinkA_->WaitFor(2); // 2: both pairs are merged
+    sinkB_->WaitFor(2); // 2: both pairs are merged
+    EXPECT_EQ(RC_OK, merge_->Stop(0));
+
+    // each merged frame goes to the out port of its pool.
+    EXPECT_TRUE(sinkA_->Get() == Delivered({{BASE_TIMESTAMP, CAMERA_BUFFER_STATUS_OK},
+        {BASE_TIMESTAMP + 33 * MS, CAMERA_BUFFER_STATUS_OK}}));
+    EXPECT_TRUE(sinkB_->Get() == Delivered({{BASE_TIMESTAMP + 10 * MS, CAMERA_BUFFER_STATUS_OK},
+        {BASE_TIMESTAMP + 35 * MS, CAMERA_BUFFER_STATUS_OK}}));
+}
+
+HWTEST_F(MergeNodeTest, DropFramesTest, TestSize.Level0)
+{
+    EXPECT_EQ(RC_OK, merge_->Start(0));
+    // frame of input a has no match, once input b is a frame ahead of it.
+    merge_->DeliverBuffers(MakeFrame(poolIdA_, BASE_TIMESTAMP));
+    merge_->DeliverBuffers(MakeFrame(poolIdB_, BASE_TIMESTAMP + 33 * MS));
+    merge_->DeliverBuffers(MakeFrame(poolIdA_, BASE_TIMESTAMP + 34 * MS));
+    // dropped frames are delivered downstream by the out port of their pool, so the producer gets them back.
+    EXPECT_TRUE(sinkA_->WaitFor(2) == Delivered({{BASE_TIMESTAMP, CAMERA_BUFFER_STATUS_DROP}, // 2: drop and merge
+        {BASE_TIMESTAMP + 34 * MS, CAMERA_BUFFER_STATUS_OK}}));
+
+    // frames which are not merged when the node stops are dropped the same way.
+    merge_->DeliverBuffers(MakeFrame(poolIdB_, BASE_TIMESTAMP + 66 * MS));
+    EXPECT_EQ(RC_OK, merge_->Stop(0));
+    EXPECT_EQ(2, sinkA_->Get().size()); // 2: nothing more for input a
+    EXPECT_TRUE(sinkB_->Get() == Delivered({{BASE_TIMESTAMP + 33 * MS, CAMERA_BUFFER_STATUS_OK},
+        {BASE_TIMESTAMP + 66 * MS, CAMERA_BUFFER_STATUS_DROP}}));
+}
+
+HWTEST_F(MergeNodeTest, ReturnBuffersTest, TestSize.Level0)
+{
+    EXPECT_EQ(RC_OK, merge_->Start(0));
+    // more frames than the pools hold, merged buffers must come back to be acquired again.
+    constexpr uint32_t frameCount = POOL_BUFFER_COUNT * 3;
+    for (uint32_t i = 0; i < frameCount; i++) {
+        uint64_t timestamp = BASE_TIMESTAMP + i * 33 * MS;
+        merge_->DeliverBuffers(MakeFrame(poolIdA_, timestamp));
+        merge_->DeliverBuffers(MakeFrame(poolIdB_, timestamp + MS));
+        sinkB_->WaitFor(i + 1);
+    }
+    EXPECT_EQ(RC_OK, merge_->Stop(0));
+    EXPECT_EQ(frameCount, sinkA_->Get().size());
+    EXPECT_EQ(frameCount, sinkB_->Get().size());
+    EXPECT_EQ(POOL_BUFFER_COUNT, poolA_->GetIdleBufferCount());
+    EXPECT_EQ(POOL_BUFFER_COUNT, poolB_->GetIdleBufferCount());
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include "gmock/gmock.h"
+#include "image_buffer.h"
+#include "offline_pipeline.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+    constexpr uint32_t CAPTURE_COUNT = 32;
+    constexpr uint32_t WORKER_COUNT = 4;
+    constexpr uint32_t ALGO_COST_LOOPS = 2000000;
+    constexpr uint32_t WAIT_INTERVAL_US = 1000;
+    constexpr uint32_t WAIT_TIMEOUT_US = 10000000;
+}
+
+// synthetic algorithm which keeps a cpu busy, odd captures take longer so that they complete out of order.
+class CpuBoundPipeline : public OfflinePipeline {
+public:
+    void ProcessCache(std::vector<std::shared_ptr<IBuffer>>& buffers) override
+    {
+        uint32_t loops = ALGO_COST_LOOPS * ((buffers[0]->GetCaptureId() % 2) + 1); // 2: odd captures are slower
+        volatile uint64_t sum = 0;
+        for (uint32_t i = 0; i < loops; i++) {
+            sum = sum + i;
+        }
+    }
+
+    void DeliverProcessedCache(std::vector<std::shared_ptr<IBuffer>>& buffers) override
+    {
+        std::lock_guard<std::mutex> l(lock_);
+        delivered_.emplace_back(buffers[0]->GetCaptureId());
+    }
+
+    void DeliverCancelCache(std::vector<std::shared_ptr<IBuffer>>& buffers) override
+    {
+        std::lock_guard<std::mutex> l(lock_);
+        canceled_.emplace_back(buffers[0]->GetCaptureId());
+    }
+
+    std::mutex lock_;
+    std::vector<int32_t> delivered_ = {};
+    std::vector<int32_t> canceled_ = {};
+};
+
+class OfflinePipelineTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+
+    void SetUp(void);
+    void TearDown(void);
+
+    static void SendCapture(OfflinePipeline& pipeline, int32_t captureId);
+    static bool WaitDry(OfflinePipeline& pipeline);
+    // returns the time in ms to process all the captures.
+    static double RunCaptures(uint32_t workerCount, std::vector<int32_t>& delivered);
+};
+
+void OfflinePipelineTest::SetUpTestCase(void)
+{
+    std::cout << "Camera::OfflinePipelineTest SetUpTestCase" << std::endl;
+}
+
+void OfflinePipelineTest::TearDownTestCase(void)
+{
+    std::cout << "Camera::OfflinePipelineTest TearDownTestCase" << std::endl;
+}
+
+void OfflinePipelineTest::SetUp(void)
+{
+    std::cout << "Camera::OfflinePipelineTest SetUp" << std::endl;
+}
+
+void OfflinePipelineTest::TearDown(void)
+{
+    std::cout << "Camera::OfflinePipelineTest TearDown.." << std::endl;
+}
+
+void OfflinePipelineTest::SendCapture(OfflinePipeline& pipeline, int32_t captureId)
+{
+    std::shared_ptr<IBuffer> buffer = std::make_shared<ImageBuffer>(CAMERA_BUFFER_SOURCE_TYPE_HEAP);
+    buffer->SetCaptureId(captureId);
+    buffer->SetBufferStatus(CAMERA_BUFFER_STATUS_OK);
+    std::vector<std::shared_ptr<IBuffer>> buffers = {buffer};
+    pipeline.ReceiveCache(buffers);
+}
+
+bool OfflinePipelineTest::WaitDry(OfflinePipeline& pipeline)
+{
+    for (uint32_t waited = 0; waited < WAIT_TIMEOUT_US; waited += WAIT_INTERVAL_US) {
+        if (pipeline.CacheQueueDry()) {
+            return true;
+        }
+        usleep(WAIT_INTERVAL_US);
+    }
+    return false;
+}
+
+double OfflinePipelineTest::RunCaptures(uint32_t workerCount, std::vector<int32_t>& delivered)
+{
+    CpuBoundPipeline pipeline;
+    pipeline.SetWorkerCount(workerCount);
+    pipeline.StartProcess();
+    auto begin = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < CAPTURE_COUNT; i++) {
+        SendCapture(pipeline, i);
+    }
+    EXPECT_EQ(true, WaitDry(pipeline));
+    auto end = std::chrono::steady_clock::now();
+    pipeline.StopProcess();
+    delivered = pipeline.delivered_;
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / 1000.0; // 1000: us to ms
+}
+
+HWTEST_F(OfflinePipelineTest, DeliverInCaptureOrder, TestSize.Level0)
+{
+    std::vector<int32_t> delivered = {};
+    RunCaptures(WORKER_COUNT, delivered);
+    EXPECT_EQ(true, delivered.size() == CAPTURE_COUNT);
+    for (uint32_t i = 0; i < delivered.size(); i++) {
+        EXPECT_EQ(true, delivered[i] == static_cast<int32_t>(i));
+    }
+}
+
+HWTEST_F(OfflinePipelineTest, CancelPendingCapture, TestSize.Level0)
+{
+    CpuBoundPipeline pipeline;
+    pipeline.StartProcess();
+    for (uint32_t i = 0; i < CAPTURE_COUNT; i++) {
+        SendCapture(pipeline, i);
+    }
+    // the last capture is still waiting for the only worker.
+    int32_t captureId = CAPTURE_COUNT - 1;
+    EXPECT_EQ(true, pipeline.CheckOwnerOfCaptureId(captureId));
+    EXPECT_EQ(true, pipeline.CancelCapture(captureId) == RC_OK);
+    EXPECT_EQ(false, pipeline.CheckOwnerOfCaptureId(captureId));
+    EXPECT_EQ(true, WaitDry(pipeline));
+    pipeline.StopProcess();
+
+    EXPECT_EQ(true, pipeline.canceled_ == std::vector<int32_t>({captureId}));
+    EXPECT_EQ(true, pipeline.delivered_.size() == CAPTURE_COUNT - 1);
+    for (uint32_t i = 0; i < pipeline.delivered_.size(); i++) {
+        EXPECT_EQ(true, pipeline.delivered_[i] == static_cast<int32_t>(i));
+    }
+}
+
+HWTEST_F(OfflinePipelineTest, StopFlushCaches, TestSize.Level0)
+{
+    CpuBoundPipeline pipeline;
+    pipeline.SetWorkerCount(WORKER_COUNT);
+    pipeline.StartProcess();
+    for (uint32_t i = 0; i < CAPTURE_COUNT; i++) {
+        SendCapture(pipeline, i);
+    }
+    // most captures are still waiting for the workers, stop hands every one of them back.
+    EXPECT_EQ(true, pipeline.StopProcess() == RC_OK);
+    EXPECT_EQ(true, pipeline.CacheQueueDry());
+    EXPECT_EQ(false, pipeline.CheckOwnerOfCaptureId(CAPTURE_COUNT - 1));
+
+    std::vector<int32_t> captureIds = pipeline.delivered_;
+    captureIds.insert(captureIds.end(), pipeline.canceled_.begin(), pipeline.canceled_.end());
+    std::sort(captureIds.begin(), captureIds.end());
+    EXPECT_EQ(true, captureIds.size() == CAPTURE_COUNT);
+    for (uint32_t i = 0; i < captureIds.size(); i++) {
+        EXPECT_EQ(true, captureIds[i] == static_cast<int32_t>(i));
+    }
+}
+
+HWTEST_F(OfflinePipelineTest, WorkerBenchmark, TestSize.Level1)
+{
+    std::vector<int32_t> delivered = {};
+    double single = RunCaptures(1, delivered);
+    double multiple = RunCaptures(WORKER_COUNT, delivered);
+    std::cout << CAPTURE_COUNT << " captures, 1 worker " << single << " ms, " << WORKER_COUNT << " workers " <<
+        multiple << " ms" << std::endl;
+    if (sysconf(_SC_NPROCESSORS_ONLN) >= WORKER_COUNT) {
+        EXPECT_EQ(true, multiple < single);
+    }
+}
+} // namespace OHOS::Camera
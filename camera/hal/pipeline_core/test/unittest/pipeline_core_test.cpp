@@ -310,4 +310,20 @@ HWTEST_F(PipelineCoreTest, PipelineCore_NormalPreviewSnapshotDestroyTest, TestSi
     re = s->DestroyPipeline({0, 2});
     EXPECT_TRUE(re == RC_OK);
 }
+
+HWTEST_F(PipelineCoreTest, PipelineCore_MetadataVersionTest, TestSize.Level0)
+{
+    // streams compare the version with the one their settings are applied at, every update must change it.
+    std::shared_ptr<IPipelineCore> core = IPipelineCore::Create();
+    EXPECT_TRUE(core != nullptr);
+    RetCode re = core->Init();
+    EXPECT_TRUE(re == RC_OK);
+    std::shared_ptr<CameraStandard::CameraMetadata> meta = std::make_shared<CameraStandard::CameraMetadata>(2, 128);
+    uint64_t version = core->GetMetadataVersion();
+    core->UpdateMetadata(meta);
+    EXPECT_TRUE(core->GetMetadataVersion() != version);
+    version = core->GetMetadataVersion();
+    core->UpdateMetadata(meta);
+    EXPECT_TRUE(core->GetMetadataVersion() != version);
+}
 }
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <gtest/gtest.h>
+#include "gmock/gmock.h"
+#include "buffer_manager.h"
+#include "source_node.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+    constexpr int32_t LOOP_STREAM_ID = 1;
+    constexpr uint32_t LOOP_BUFFER_COUNT = 4;
+    constexpr uint32_t LOOP_FRAME_COUNT = 200;
+    constexpr uint32_t LOOP_WIDTH = 64;
+    constexpr uint32_t LOOP_HEIGHT = 64;
+    constexpr int32_t LOOP_TIMEOUT_MS = 5000;
+
+    // a device which fills the buffers in its own thread, like a v4l2 dequeue thread.
+    class FakeSourceNode : public SourceNode {
+    public:
+        FakeSourceNode(const std::string& name, const std::string& type)
+            : SourceNode(name, type), NodeBase(name, type)
+        {
+        }
+        ~FakeSourceNode() override = default;
+
+        RetCode Start(const int32_t streamId) override
+        {
+            deviceRunning_ = true;
+            device_ = std::thread([this] {
+                std::unique_lock<std::mutex> l(deviceLock_);
+                while (true) {
+                    deviceCv_.wait(l, [this] { return !deviceRunning_ || !queued_.empty(); });
+                    if (!deviceRunning_) {
+                        return;
+                    }
+                    std::shared_ptr<FrameSpec> frameSpec = queued_.front();
+                    queued_.pop_front();
+                    frameSpec->buffer_->SetFrameNumber(++frameNumber_);
+                    frameSpec->buffer_->SetStreamId(LOOP_STREAM_ID);
+                    l.unlock();
+                    OnPackBuffer(frameSpec);
+                    frameSpec = nullptr;
+                    l.lock();
+                }
+            });
+            return SourceNode::Start(streamId);
+        }
+
+        RetCode Stop(const int32_t streamId) override
+        {
+            SourceNode::Flush(streamId);
+            {
+                std::lock_guard<std::mutex> l(deviceLock_);
+                deviceRunning_ = false;
+                deviceCv_.notify_one();
+            }
+            device_.join();
+            // buffers which are not filled go back to the pool, like on stream off.
+            for (auto& it : queued_) {
+                it->buffer_->GetPool()->ReturnBuffer(it->buffer_);
+            }
+            queued_.clear();
+            return SourceNode::Stop(streamId);
+        }
+
+        RetCode ProvideBuffers(std::shared_ptr<FrameSpec> frameSpec) override
+        {
+            std::lock_guard<std::mutex> l(deviceLock_);
+            frameSpecs_.insert(frameSpec.get());
+            queued_.emplace_back(frameSpec);
+            deviceCv_.notify_one();
+            return RC_OK;
+        }
+
+        size_t GetFrameSpecCount()
+        {
+            std::lock_guard<std::mutex> l(deviceLock_);
+            return frameSpecs_.size();
+        }
+
+    private:
+        std::thread device_;
+        std::mutex deviceLock_;
+        std::condition_variable deviceCv_;
+        bool deviceRunning_ = false;
+        uint64_t frameNumber_ = 0;
+        std::list<std::shared_ptr<FrameSpec>> queued_ = {};
+        std::set<const FrameSpec*> frameSpecs_ = {};
+    };
+
+    // returns every buffer to its pool at once.
+    class ReturnNode : public NodeBase {
+    public:
+        ReturnNode(const std::string& name, const std::string& type) : NodeBase(name, type) {}
+        ~ReturnNode() override = default;
+
+        void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) override
+        {
+            CHECK_IF_PTR_NULL_RETURN_VOID(buffer);
+            std::shared_ptr<IBufferPool> pool = buffer->GetPool();
+            CHECK_IF_PTR_NULL_RETURN_VOID(pool);
+            pool->ReturnBuffer(buffer);
+            std::lock_guard<std::mutex> l(lock_);
+            count_++;
+            cv_.notify_one();
+        }
+
+        bool WaitFrames(const uint32_t count)
+        {
+            std::unique_lock<std::mutex> l(lock_);
+            return cv_.wait_for(l, std::chrono::milliseconds(LOOP_TIMEOUT_MS), [this, count] {
+                return count_ >= count;
+            });
+        }
+
+    private:
+        std::mutex lock_;
+        std::condition_variable cv_;
+        uint32_t count_ = 0;
+    };
+}
+
+class SourceNodeTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+
+    void SetUp(void);
+    void TearDown(void);
+};
+
+void SourceNodeTest::SetUpTestCase(void)
+{
+    std::cout << "Camera::SourceNodeTest SetUpTestCase" << std::endl;
+}
+
+void SourceNodeTest::TearDownTestCase(void)
+{
+    std::cout << "Camera::SourceNodeTest TearDownTestCase" << std::endl;
+}
+
+void SourceNodeTest::SetUp(void)
+{
+    std::cout << "Camera::SourceNodeTest SetUp" << std::endl;
+}
+
+void SourceNodeTest::TearDown(void)
+{
+    std::cout << "Camera::SourceNodeTest TearDown.." << std::endl;
+}
+
+HWTEST_F(SourceNodeTest, PortLoopTest, TestSize.Level0)
+{
+    BufferManager* manager = BufferManager::GetInstance();
+    int64_t poolId = manager->GenerateBufferPoolId();
+    std::shared_ptr<IBufferPool> pool = manager->GetBufferPool(poolId);
+    EXPECT_TRUE(pool != nullptr);
+    EXPECT_TRUE(pool->Init(LOOP_WIDTH, LOOP_HEIGHT, CAMERA_USAGE_SW_WRITE_OFTEN, CAMERA_FORMAT_YCRCB_420_SP,
+        LOOP_BUFFER_COUNT, CAMERA_BUFFER_SOURCE_TYPE_HEAP) == RC_OK);
+
+    auto source = std::make_shared<FakeSourceNode>("source", "source");
+    auto sink = std::make_shared<ReturnNode>("sink", "sink");
+    std::shared_ptr<IPort> outPort = source->GetPort("out0");
+    std::shared_ptr<IPort> inPort = sink->GetPort("in0");
+    PortFormat format = {};
+    format.streamId_ = LOOP_STREAM_ID;
+    format.bufferPoolId_ = poolId;
+    format.bufferCount_ = LOOP_BUFFER_COUNT;
+    outPort->SetFormat(format);
+    inPort->SetFormat(format);
+    outPort->Connect(inPort);
+    inPort->Connect(outPort);
+
+    auto begin = std::chrono::steady_clock::now();
+    EXPECT_TRUE(source->Start(LOOP_STREAM_ID) == RC_OK);
+    EXPECT_TRUE(sink->WaitFrames(LOOP_FRAME_COUNT));
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << LOOP_FRAME_COUNT << " frames take " << us << " us" << std::endl;
+    EXPECT_TRUE(source->Stop(LOOP_STREAM_ID) == RC_OK);
+
+    // frame specs are recycled, they are not more than buffers which may be in the device and in the loop.
+    EXPECT_TRUE(source->GetFrameSpecCount() <= LOOP_BUFFER_COUNT * 2); // 2: in the device and in the loop
+    EXPECT_EQ(LOOP_BUFFER_COUNT, pool->GetIdleBufferCount());
+}
+} // namespace OHOS::Camera
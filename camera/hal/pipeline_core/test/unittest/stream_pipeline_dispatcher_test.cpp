@@ -13,6 +13,9 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <mutex>
 #include <thread>
 #include <unistd.h>
 #include <vector>
@@ -21,9 +24,70 @@
 #include "stream_pipeline_strategy.h"
 #include "stream_pipeline_builder.h"
 #include "stream_pipeline_dispatcher.h"
+#include "image_buffer.h"
+#include "node_base.h"
 
 using namespace testing::ext;
 namespace OHOS::Camera {
+namespace {
+    constexpr int32_t ORDER_STREAM_ID = 1;
+    constexpr int32_t NODE_START_MS = 100;
+
+    std::mutex g_orderLock;
+    std::vector<std::string> g_order;
+
+    // records the order of the lifecycle calls, start of sources takes a while.
+    class OrderNode : public NodeBase {
+    public:
+        OrderNode(const std::string& name, const std::string& type) : NodeBase(name, type) {}
+        ~OrderNode() override = default;
+        RetCode Start(const int32_t streamId) override
+        {
+            if (name_.find("source") == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(NODE_START_MS));
+            }
+            Record("start " + name_);
+            return RC_OK;
+        }
+        RetCode Stop(const int32_t streamId) override
+        {
+            Record("stop " + name_);
+            return RC_OK;
+        }
+        void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) override
+        {
+            if (name_.find("sink") == 0) {
+                Record("deliver " + name_);
+                return;
+            }
+            NodeBase::DeliverBuffer(buffer);
+        }
+        static void Record(const std::string& call)
+        {
+            std::lock_guard<std::mutex> l(g_orderLock);
+            g_order.push_back(call);
+        }
+    };
+
+    void Link(const std::shared_ptr<INode>& from, const std::string& out,
+        const std::shared_ptr<INode>& to, const std::string& in)
+    {
+        std::shared_ptr<IPort> outPort = from->GetPort(out);
+        std::shared_ptr<IPort> inPort = to->GetPort(in);
+        PortFormat format = {};
+        format.streamId_ = ORDER_STREAM_ID;
+        outPort->SetFormat(format);
+        inPort->SetFormat(format);
+        outPort->Connect(inPort);
+        inPort->Connect(outPort);
+    }
+
+    size_t IndexOf(const std::string& call)
+    {
+        return std::find(g_order.begin(), g_order.end(), call) - g_order.begin();
+    }
+}
+
 class DispatcherTest : public testing::Test {
 public:
     static void SetUpTestCase(void);
@@ -124,4 +188,74 @@ HWTEST_F(DispatcherTest, AbConfigTest, TestSize.Level0)
     RetCode re = d->Update(pipeline);
     EXPECT_TRUE(re == RC_OK);
 }
+
+HWTEST_F(DispatcherTest, LevelOrderTest, TestSize.Level0)
+{
+    // two sources merged into one sink, the sources are independent of each other.
+    auto source0 = std::make_shared<OrderNode>("source0", "source");
+    auto source1 = std::make_shared<OrderNode>("source1", "source");
+    auto merge = std::make_shared<OrderNode>("merge", "merge");
+    auto sink = std::make_shared<OrderNode>("sink", "sink");
+    Link(source0, "out0", merge, "in0");
+    Link(source1, "out0", merge, "in1");
+    Link(merge, "out0", sink, "in0");
+    std::shared_ptr<Pipeline> pipeline = std::make_shared<Pipeline>();
+    pipeline->nodes_ = {source0, source1, merge, sink};
+
+    std::unique_ptr<StreamPipelineDispatcher> d = StreamPipelineDispatcher::Create();
+    EXPECT_TRUE(d != nullptr);
+    EXPECT_TRUE(d->Update(pipeline) == RC_OK);
+    g_order.clear();
+    auto begin = std::chrono::steady_clock::now();
+    EXPECT_TRUE(d->Start(ORDER_STREAM_ID) == RC_OK);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "start of 2 sources takes " << ms << " ms" << std::endl;
+    EXPECT_TRUE(ms < NODE_START_MS * 2); // 2: the sources start concurrently
+    EXPECT_TRUE(IndexOf("start sink") < IndexOf("start merge"));
+    EXPECT_TRUE(IndexOf("start merge") < IndexOf("start source0"));
+    EXPECT_TRUE(IndexOf("start merge") < IndexOf("start source1"));
+    EXPECT_TRUE(IndexOf("start source1") < g_order.size());
+
+    g_order.clear();
+    EXPECT_TRUE(d->Stop(ORDER_STREAM_ID) == RC_OK);
+    EXPECT_EQ(4, g_order.size()); // 4: each node stops once
+    EXPECT_TRUE(IndexOf("stop source0") < IndexOf("stop merge"));
+    EXPECT_TRUE(IndexOf("stop source1") < IndexOf("stop merge"));
+    EXPECT_TRUE(IndexOf("stop merge") < IndexOf("stop sink"));
+}
+
+HWTEST_F(DispatcherTest, PoolRouteTest, TestSize.Level0)
+{
+    auto fork = std::make_shared<OrderNode>("fork", "fork");
+    auto sink0 = std::make_shared<OrderNode>("sink0", "sink");
+    auto sink1 = std::make_shared<OrderNode>("sink1", "sink");
+    Link(fork, "out0", sink0, "in0");
+    Link(fork, "out1", sink1, "in0");
+    EXPECT_EQ(0, fork->GetNumberOfInPorts());
+    EXPECT_EQ(2, fork->GetNumberOfOutPorts()); // 2: out0 and out1
+    EXPECT_TRUE(fork->GetPort("out1") == fork->GetOutPortById(1));
+    EXPECT_EQ(PORT_DIRECTION_IN, sink0->GetPort("in0")->Direction());
+    fork->GetPort("out0")->format_.bufferPoolId_ = 100; // 100: pool of out0
+    fork->GetPort("out1")->format_.bufferPoolId_ = 200; // 200: pool of out1
+
+    std::shared_ptr<IBuffer> buffer = std::make_shared<ImageBuffer>(CAMERA_BUFFER_SOURCE_TYPE_HEAP);
+    g_order.clear();
+    buffer->SetPoolId(200); // 200: pool of out1
+    fork->DeliverBuffer(buffer);
+    buffer->SetPoolId(100); // 100: pool of out0
+    fork->DeliverBuffer(buffer);
+    buffer->SetPoolId(300); // 300: no port delivers it
+    fork->DeliverBuffer(buffer);
+    EXPECT_TRUE(g_order == std::vector<std::string>({"deliver sink1", "deliver sink0"}));
+
+    // routes follow pool ids which are changed after they are made.
+    fork->GetPort("out0")->format_.bufferPoolId_ = 300; // 300: new pool of out0
+    fork->GetPort("out1")->format_.bufferPoolId_ = 100; // 100: new pool of out1
+    g_order.clear();
+    buffer->SetPoolId(100); // 100: pool of out1
+    fork->DeliverBuffer(buffer);
+    buffer->SetPoolId(300); // 300: pool of out0
+    fork->DeliverBuffer(buffer);
+    EXPECT_TRUE(g_order == std::vector<std::string>({"deliver sink1", "deliver sink0"}));
+}
 }
@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 
+#include <chrono>
 #include <thread>
 #include <unistd.h>
 #include <vector>
@@ -29,6 +30,8 @@ public:
 
     void SetUp(void);
     void TearDown(void);
+
+    static bool IsSameSpec(const PipelineSpec& spec, const PipelineSpec& expect);
 };
 
 void StrategyTest::SetUpTestCase(void)
@@ -51,6 +54,30 @@ void StrategyTest::TearDown(void)
     std::cout << "Camera::StrategyTest TearDown.." << std::endl;
 }
 
+bool StrategyTest::IsSameSpec(const PipelineSpec& spec, const PipelineSpec& expect)
+{
+    if (spec.nodeSpecSet_.size() != expect.nodeSpecSet_.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < spec.nodeSpecSet_.size(); i++) {
+        const NodeSpec& n = spec.nodeSpecSet_[i];
+        const NodeSpec& e = expect.nodeSpecSet_[i];
+        if (n.name_ != e.name_ || n.streamId_ != e.streamId_ || n.portSpecSet_.size() != e.portSpecSet_.size()) {
+            return false;
+        }
+        for (size_t j = 0; j < n.portSpecSet_.size(); j++) {
+            const PortFormat& f = n.portSpecSet_[j].format_;
+            const PortFormat& ef = e.portSpecSet_[j].format_;
+            if (n.portSpecSet_[j].info_.name_ != e.portSpecSet_[j].info_.name_ || f.streamId_ != ef.streamId_ ||
+                f.bufferPoolId_ != ef.bufferPoolId_ || f.w_ != ef.w_ || f.h_ != ef.h_ || f.format_ != ef.format_ ||
+                f.memoryType_ != ef.memoryType_ || f.minFrameDuration_ != ef.minFrameDuration_) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 HWTEST_F(StrategyTest, NormalPreviewTest, TestSize.Level0)
 {
     std::shared_ptr<HostStreamMgr> streamMgr = HostStreamMgr::Create();
@@ -97,4 +124,137 @@ HWTEST_F(StrategyTest, AbNormalTest, TestSize.Level0)
     std::shared_ptr<PipelineSpec> spec = s->GeneratePipelineSpec(1);
     EXPECT_TRUE(spec == nullptr);
 }
+
+HWTEST_F(StrategyTest, CachedSpecTest, TestSize.Level0)
+{
+    std::shared_ptr<HostStreamMgr> streamMgr = HostStreamMgr::Create();
+    std::unique_ptr<StreamPipelineStrategy> s = StreamPipelineStrategy::Create(streamMgr);
+    EXPECT_TRUE(s != nullptr);
+    HostStreamInfo info = {.type_ = PREVIEW, .streamId_ = 1, .width_ = 640, .height_ = 480, .bufferPoolId_ = 11};
+    streamMgr->CreateHostStream(info, nullptr);
+    std::shared_ptr<PipelineSpec> spec = s->GeneratePipelineSpec(0);
+    EXPECT_TRUE(spec != nullptr);
+    s->Destroy();
+    streamMgr->DestroyHostStream({info.streamId_});
+
+    // the same configuration of a new stream hits the cache, ids must be the ones of the new stream.
+    info.streamId_ = 2;
+    info.bufferPoolId_ = 22;
+    streamMgr->CreateHostStream(info, nullptr);
+    spec = s->GeneratePipelineSpec(0);
+    EXPECT_TRUE(spec != nullptr);
+
+    std::shared_ptr<HostStreamMgr> expectMgr = HostStreamMgr::Create();
+    expectMgr->CreateHostStream(info, nullptr);
+    std::unique_ptr<StreamPipelineStrategy> expectStrategy = StreamPipelineStrategy::Create(expectMgr);
+    std::shared_ptr<PipelineSpec> expect = expectStrategy->GeneratePipelineSpec(0);
+    EXPECT_TRUE(expect != nullptr);
+    if (spec != nullptr && expect != nullptr) {
+        EXPECT_TRUE(IsSameSpec(*spec, *expect));
+    }
+}
+
+HWTEST_F(StrategyTest, MemoryTypeTest, TestSize.Level0)
+{
+    std::shared_ptr<HostStreamMgr> streamMgr = HostStreamMgr::Create();
+    std::unique_ptr<StreamPipelineStrategy> s = StreamPipelineStrategy::Create(streamMgr);
+    EXPECT_TRUE(s != nullptr);
+    HostStreamInfo info = {.type_ = PREVIEW, .streamId_ = 1, .width_ = 640, .height_ = 480, .bufferPoolId_ = 11};
+    for (StreamMemoryType memoryType : {MEMORY_TYPE_MMAP, MEMORY_TYPE_USERPTR, MEMORY_TYPE_DMABUF}) {
+        // the memory type is part of the cached spec, a stream differing only in it must not reuse the spec.
+        info.memoryType_ = memoryType;
+        streamMgr->CreateHostStream(info, nullptr);
+        std::shared_ptr<PipelineSpec> spec = s->GeneratePipelineSpec(0);
+        EXPECT_TRUE(spec != nullptr);
+        if (spec != nullptr) {
+            for (auto& node : spec->nodeSpecSet_) {
+                for (auto& port : node.portSpecSet_) {
+                    EXPECT_EQ(port.format_.memoryType_, memoryType);
+                }
+            }
+        }
+        s->Destroy();
+        streamMgr->DestroyHostStream({info.streamId_});
+    }
+}
+
+HWTEST_F(StrategyTest, MaxBufferCountTest, TestSize.Level0)
+{
+    std::shared_ptr<HostStreamMgr> streamMgr = HostStreamMgr::Create();
+    std::unique_ptr<StreamPipelineStrategy> s = StreamPipelineStrategy::Create(streamMgr);
+    EXPECT_TRUE(s != nullptr);
+    HostStreamInfo info = {.type_ = PREVIEW, .streamId_ = 1, .width_ = 640, .height_ = 480, .bufferPoolId_ = 11,
+        .bufferCount_ = 4};
+    for (uint32_t maxBufferCount : {8, 0}) {
+        // nodes which allocate buffers make their pools elastic up to max buffer count of the stream.
+        info.maxBufferCount_ = maxBufferCount;
+        streamMgr->CreateHostStream(info, nullptr);
+        std::shared_ptr<PipelineSpec> spec = s->GeneratePipelineSpec(0);
+        EXPECT_TRUE(spec != nullptr);
+        if (spec != nullptr) {
+            for (auto& node : spec->nodeSpecSet_) {
+                for (auto& port : node.portSpecSet_) {
+                    EXPECT_EQ(port.format_.bufferCount_, info.bufferCount_);
+                    EXPECT_EQ(port.format_.maxBufferCount_, maxBufferCount);
+                }
+            }
+        }
+        s->Destroy();
+        streamMgr->DestroyHostStream({info.streamId_});
+    }
+}
+
+HWTEST_F(StrategyTest, FrameDurationTest, TestSize.Level0)
+{
+    std::shared_ptr<HostStreamMgr> streamMgr = HostStreamMgr::Create();
+    std::unique_ptr<StreamPipelineStrategy> s = StreamPipelineStrategy::Create(streamMgr);
+    EXPECT_TRUE(s != nullptr);
+    HostStreamInfo info = {.type_ = PREVIEW, .streamId_ = 1, .width_ = 640, .height_ = 480, .bufferPoolId_ = 11};
+    for (int32_t minFrameDuration : {33333, 16666, 0}) {
+        // nodes such as merge node derive their timing from the frame duration of the stream.
+        info.minFrameDuration_ = minFrameDuration;
+        streamMgr->CreateHostStream(info, nullptr);
+        std::shared_ptr<PipelineSpec> spec = s->GeneratePipelineSpec(0);
+        EXPECT_TRUE(spec != nullptr);
+        if (spec != nullptr) {
+            for (auto& node : spec->nodeSpecSet_) {
+                for (auto& port : node.portSpecSet_) {
+                    EXPECT_EQ(port.format_.minFrameDuration_, minFrameDuration);
+                }
+            }
+        }
+        s->Destroy();
+        streamMgr->DestroyHostStream({info.streamId_});
+    }
+}
+
+HWTEST_F(StrategyTest, CachedSpecBenchmark, TestSize.Level1)
+{
+    // switch between preview and preview + snapshot, a new strategy for each round resolves the spec every time.
+    const int rounds = 200;
+    for (bool cached : {false, true}) {
+        std::shared_ptr<HostStreamMgr> streamMgr = HostStreamMgr::Create();
+        std::unique_ptr<StreamPipelineStrategy> s = StreamPipelineStrategy::Create(streamMgr);
+        int64_t ns = 0;
+        for (int i = 0; i < rounds; i++) {
+            if (!cached) {
+                s = StreamPipelineStrategy::Create(streamMgr);
+            }
+            std::vector<int> streamIds = {i * 2};
+            streamMgr->CreateHostStream({.type_ = PREVIEW, .streamId_ = i * 2}, nullptr);
+            if (i % 2 == 1) {
+                streamMgr->CreateHostStream({.type_ = STILL_CAPTURE, .streamId_ = i * 2 + 1}, nullptr);
+                streamIds.push_back(i * 2 + 1);
+            }
+            auto begin = std::chrono::steady_clock::now();
+            std::shared_ptr<PipelineSpec> spec = s->GeneratePipelineSpec(0);
+            auto end = std::chrono::steady_clock::now();
+            ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+            EXPECT_TRUE(spec != nullptr);
+            s->Destroy();
+            streamMgr->DestroyHostStream(streamIds);
+        }
+        std::cout << (cached ? "cached" : "uncached") << " GeneratePipelineSpec " << ns / rounds << " ns" << std::endl;
+    }
+}
 }
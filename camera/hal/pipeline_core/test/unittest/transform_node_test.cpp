@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <gtest/gtest.h>
+#include "gmock/gmock.h"
+#include "image_converter.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+    // 1080p for the benchmark, a width which is no multiple of the vector length checks the scalar tail.
+    constexpr uint32_t BENCH_WIDTH = 1920;
+    constexpr uint32_t BENCH_HEIGHT = 1080;
+    constexpr uint32_t BENCH_LOOPS = 50;
+    constexpr uint32_t TAIL_WIDTH = 646;
+    constexpr uint32_t TAIL_HEIGHT = 482;
+}
+
+class TransformNodeTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+
+    void SetUp(void);
+    void TearDown(void);
+
+    static std::vector<uint8_t> RandomImage(uint32_t size);
+    static void CheckBitExact(uint32_t width, uint32_t height);
+    template<typename F>
+    static double MeasureMpixs(uint32_t width, uint32_t height, F&& convert);
+};
+
+void TransformNodeTest::SetUpTestCase(void)
+{
+    std::cout << "Camera::TransformNodeTest SetUpTestCase" << std::endl;
+}
+
+void TransformNodeTest::TearDownTestCase(void)
+{
+    std::cout << "Camera::TransformNodeTest TearDownTestCase" << std::endl;
+}
+
+void TransformNodeTest::SetUp(void)
+{
+    std::cout << "Camera::TransformNodeTest SetUp" << std::endl;
+}
+
+void TransformNodeTest::TearDown(void)
+{
+    std::cout << "Camera::TransformNodeTest TearDown.." << std::endl;
+}
+
+std::vector<uint8_t> TransformNodeTest::RandomImage(uint32_t size)
+{
+    std::vector<uint8_t> image(size);
+    for (auto& it : image) {
+        it = static_cast<uint8_t>(rand());
+    }
+    // extreme values are where saturation of the vector paths may differ from the scalar one.
+    for (uint32_t i = 0; i < size / 4; i += 2) { // 4: first quarter of the image
+        image[i] = (i & 2) ? 0xff : 0; // 2: alternate the extreme values
+    }
+    return image;
+}
+
+void TransformNodeTest::CheckBitExact(uint32_t width, uint32_t height)
+{
+    uint32_t nvSize = width * height * 3 / 2; // 3 / 2: yuv420 size
+    std::vector<uint8_t> yuyv = RandomImage(width * height * 2); // 2: yuyv size
+    std::vector<uint8_t> nv12 = RandomImage(nvSize);
+    for (bool swapUv : {false, true}) {
+        std::vector<uint8_t> simd(nvSize);
+        std::vector<uint8_t> scalar(nvSize);
+        ImageConverter::YuyvToYuv420sp(yuyv.data(), width * 2, simd.data(), // 2: yuyv stride
+            simd.data() + width * height, width, width, height, swapUv);
+        ImageConverter::YuyvToYuv420spScalar(yuyv.data(), width * 2, scalar.data(), // 2: yuyv stride
+            scalar.data() + width * height, width, width, height, swapUv);
+        EXPECT_EQ(true, simd == scalar);
+
+        std::vector<uint8_t> rgbaSimd(width * height * 4); // 4: rgba size
+        std::vector<uint8_t> rgbaScalar(width * height * 4); // 4: rgba size
+        ImageConverter::Yuv420spToRgba(nv12.data(), nv12.data() + width * height, width,
+            rgbaSimd.data(), width * 4, width, height, swapUv); // 4: rgba stride
+        ImageConverter::Yuv420spToRgbaScalar(nv12.data(), nv12.data() + width * height, width,
+            rgbaScalar.data(), width * 4, width, height, swapUv); // 4: rgba stride
+        EXPECT_EQ(true, rgbaSimd == rgbaScalar);
+    }
+
+    std::vector<uint8_t> simd(nvSize);
+    std::vector<uint8_t> scalar(nvSize);
+    ImageConverter::Yuv420spSwapUv(nv12.data(), nv12.data() + width * height, width,
+        simd.data(), simd.data() + width * height, width, width, height);
+    ImageConverter::Yuv420spSwapUvScalar(nv12.data(), nv12.data() + width * height, width,
+        scalar.data(), scalar.data() + width * height, width, width, height);
+    EXPECT_EQ(true, simd == scalar);
+}
+
+template<typename F>
+double TransformNodeTest::MeasureMpixs(uint32_t width, uint32_t height, F&& convert)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_LOOPS; i++) {
+        convert();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double us = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+    return us > 0 ? static_cast<double>(width) * height * BENCH_LOOPS / us : 0;
+}
+
+HWTEST_F(TransformNodeTest, YuyvToYuv420spReference, TestSize.Level0)
+{
+    // two rows of 2 pixels: Y0 U Y1 V
+    std::vector<uint8_t> yuyv = {10, 100, 20, 200, 30, 51, 40, 150};
+    std::vector<uint8_t> nv(6); // 6: 2x2 yuv420 size
+    ImageConverter::YuyvToYuv420spScalar(yuyv.data(), 4, nv.data(), nv.data() + 4, 2, 2, 2, false); // 4, 2: strides
+    EXPECT_EQ(true, nv == std::vector<uint8_t>({10, 20, 30, 40, 76, 175}));
+    ImageConverter::YuyvToYuv420spScalar(yuyv.data(), 4, nv.data(), nv.data() + 4, 2, 2, 2, true); // 4, 2: strides
+    EXPECT_EQ(true, nv == std::vector<uint8_t>({10, 20, 30, 40, 175, 76}));
+}
+
+HWTEST_F(TransformNodeTest, Yuv420spToRgbaReference, TestSize.Level0)
+{
+    // black, gray and white of the limited range in nv12 2x2
+    std::vector<uint8_t> nv = {16, 126, 235, 235, 128, 128};
+    std::vector<uint8_t> rgba(16); // 16: 2x2 rgba size
+    ImageConverter::Yuv420spToRgbaScalar(nv.data(), nv.data() + 4, 2, rgba.data(), 8, 2, 2, false); // 4,2,8: layout
+    EXPECT_EQ(true, rgba == std::vector<uint8_t>({0, 0, 0, 0xff, 127, 127, 127, 0xff,
+        253, 253, 253, 0xff, 253, 253, 253, 0xff}));
+}
+
+HWTEST_F(TransformNodeTest, SimdBitExact, TestSize.Level0)
+{
+    std::cout << "simd: " << ImageConverter::GetSimdName() << std::endl;
+    CheckBitExact(TAIL_WIDTH, TAIL_HEIGHT);
+    CheckBitExact(BENCH_WIDTH, BENCH_HEIGHT);
+}
+
+HWTEST_F(TransformNodeTest, ConvertBenchmark, TestSize.Level1)
+{
+    uint32_t w = BENCH_WIDTH;
+    uint32_t h = BENCH_HEIGHT;
+    std::vector<uint8_t> yuyv = RandomImage(w * h * 2); // 2: yuyv size
+    std::vector<uint8_t> nv12 = RandomImage(w * h * 3 / 2); // 3 / 2: yuv420 size
+    std::vector<uint8_t> nv(w * h * 3 / 2); // 3 / 2: yuv420 size
+    std::vector<uint8_t> rgba(w * h * 4); // 4: rgba size
+    const uint8_t* src = yuyv.data();
+    const uint8_t* srcY = nv12.data();
+    const uint8_t* srcUv = nv12.data() + w * h;
+    uint8_t* dstY = nv.data();
+    uint8_t* dstUv = nv.data() + w * h;
+    uint8_t* dst = rgba.data();
+
+    std::cout << "simd: " << ImageConverter::GetSimdName() << ", " << w << "x" << h << " MPix/s" << std::endl;
+    std::cout << "yuyv->nv21 scalar " << MeasureMpixs(w, h, [&] {
+        ImageConverter::YuyvToYuv420spScalar(src, w * 2, dstY, dstUv, w, w, h, true); // 2: yuyv stride
+    }) << ", simd " << MeasureMpixs(w, h, [&] {
+        ImageConverter::YuyvToYuv420sp(src, w * 2, dstY, dstUv, w, w, h, true); // 2: yuyv stride
+    }) << std::endl;
+    std::cout << "nv12->nv21 scalar " << MeasureMpixs(w, h, [&] {
+        ImageConverter::Yuv420spSwapUvScalar(srcY, srcUv, w, dstY, dstUv, w, w, h);
+    }) << ", simd " << MeasureMpixs(w, h, [&] {
+        ImageConverter::Yuv420spSwapUv(srcY, srcUv, w, dstY, dstUv, w, w, h);
+    }) << std::endl;
+    std::cout << "nv12->rgba scalar " << MeasureMpixs(w, h, [&] {
+        ImageConverter::Yuv420spToRgbaScalar(srcY, srcUv, w, dst, w * 4, w, h, false); // 4: rgba stride
+    }) << ", simd " << MeasureMpixs(w, h, [&] {
+        ImageConverter::Yuv420spToRgba(srcY, srcUv, w, dst, w * 4, w, h, false); // 4: rgba stride
+    }) << std::endl;
+}
+} // namespace OHOS::Camera
@@ -13,60 +13,286 @@
  * limitations under the License.
  */
 
-#include <chrono>
-#include <assert.h>
-#include <signal.h>
+#include <condition_variable>
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/prctl.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include "camera.h"
 #include "watchdog.h"
 
 namespace OHOS::Camera {
+namespace {
+    // one revolution of the wheel covers 5.12s, longer timeouts wait for more rounds.
+    constexpr uint32_t WHEEL_TICK_MS = 10;
+    constexpr uint32_t WHEEL_SLOT_COUNT = 512;
+    constexpr uint32_t MS_PER_SECOND = 1000;
+    constexpr uint32_t NS_PER_MS = 1000000;
+    constexpr int EPOLL_EVENT_COUNT = 2;
+}
 
-WatchDog::WatchDog() {}
+class WatchDogTimerWheel {
+public:
+    static WatchDogTimerWheel& GetInstance();
+    uint64_t Arm(int ms, std::function<void()> executor, WatchDogAction action);
+    void Disarm(uint64_t id);
+    uint32_t AddDumper(std::function<void()> dumper);
+    void RemoveDumper(uint32_t id);
 
-void WatchDog::Init(int ms, std::function<void()> executor, bool isKill)
+private:
+    struct Timer {
+        uint64_t id;
+        uint32_t rounds;
+        int ms;
+        std::function<void()> executor;
+        WatchDogAction action;
+    };
+    using TimerList = std::list<Timer>;
+
+    WatchDogTimerWheel();
+    ~WatchDogTimerWheel();
+    void Loop();
+    void Tick(uint64_t ticks);
+    void Expire(const Timer& timer);
+    void SetTicking(bool ticking);
+
+private:
+    std::mutex lock_;
+    std::condition_variable cv_;
+    std::vector<TimerList> slots_;
+    // id -> slot and position in the slot, for removal without a search.
+    std::unordered_map<uint64_t, std::pair<uint32_t, TimerList::iterator>> timers_;
+    TimerList expired_;
+    uint32_t cursor_ = 0;
+    uint64_t nextId_ = 1;
+    uint64_t firingId_ = 0;
+    bool ticking_ = false;
+    int timerFd_ = -1;
+    int exitFd_ = -1;
+    int epollFd_ = -1;
+    std::unique_ptr<std::thread> loop_ = nullptr;
+
+    std::mutex dumperLock_;
+    std::map<uint32_t, std::function<void()>> dumpers_;
+    uint32_t nextDumperId_ = 1;
+};
+
+WatchDogTimerWheel& WatchDogTimerWheel::GetInstance()
 {
-    timeMs_ = ms;
-    isKill_ = isKill;
-    executor_ = executor;
-    handleThread_ = std::make_unique<std::thread>(&WatchDog::WaitForWakeUP, this);
+    static WatchDogTimerWheel wheel;
+    return wheel;
 }
 
-WatchDog::~WatchDog()
+WatchDogTimerWheel::WatchDogTimerWheel() : slots_(WHEEL_SLOT_COUNT)
 {
-    {
-        std::unique_lock<std::mutex> l(lock_);
-        terminate_ = true;
-        cv_.notify_one();
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    exitFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (timerFd_ < 0 || exitFd_ < 0 || epollFd_ < 0) {
+        CAMERA_LOGE("watchdog timer wheel create fds failed");
+        return;
+    }
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = timerFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, timerFd_, &event);
+    event.data.fd = exitFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, exitFd_, &event);
+    loop_ = std::make_unique<std::thread>(&WatchDogTimerWheel::Loop, this);
+}
+
+WatchDogTimerWheel::~WatchDogTimerWheel()
+{
+    if (loop_ != nullptr) {
+        uint64_t one = 1;
+        write(exitFd_, &one, sizeof(one));
+        loop_->join();
     }
-    if (handleThread_ != nullptr && handleThread_->joinable()) {
-        handleThread_->join();
+    for (int fd : {timerFd_, exitFd_, epollFd_}) {
+        if (fd >= 0) {
+            close(fd);
+        }
     }
 }
 
-void WatchDog::WaitForWakeUP()
+uint64_t WatchDogTimerWheel::Arm(int ms, std::function<void()> executor, WatchDogAction action)
 {
-    prctl(PR_SET_NAME, "camera_watchdog");
+    uint32_t ticks = ms <= 0 ? 1 : (static_cast<uint32_t>(ms) + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS;
+    std::lock_guard<std::mutex> l(lock_);
+    uint64_t id = nextId_++;
+    uint32_t slot = (cursor_ + ticks) % WHEEL_SLOT_COUNT;
+    TimerList& timers = slots_[slot];
+    timers.push_front({id, (ticks - 1) / WHEEL_SLOT_COUNT, ms, std::move(executor), action});
+    timers_[id] = {slot, timers.begin()};
+    if (!ticking_) {
+        SetTicking(true);
+    }
+    return id;
+}
 
+void WatchDogTimerWheel::Disarm(uint64_t id)
+{
     std::unique_lock<std::mutex> l(lock_);
-    cv_.wait_for(l, std::chrono::milliseconds(timeMs_), [this]() {
-        return terminate_; });
-    if (terminate_) {
+    auto it = timers_.find(id);
+    if (it != timers_.end()) {
+        slots_[it->second.first].erase(it->second.second);
+        timers_.erase(it);
+        if (timers_.empty() && ticking_) {
+            SetTicking(false);
+        }
+        return;
+    }
+    for (auto e = expired_.begin(); e != expired_.end(); e++) {
+        if (e->id == id) {
+            expired_.erase(e);
+            return;
+        }
+    }
+    // the executor may use its owner, don't return before it's done, unless it disarms itself.
+    if (loop_ != nullptr && std::this_thread::get_id() != loop_->get_id()) {
+        cv_.wait(l, [this, id] { return firingId_ != id; });
+    }
+}
+
+uint32_t WatchDogTimerWheel::AddDumper(std::function<void()> dumper)
+{
+    std::lock_guard<std::mutex> l(dumperLock_);
+    uint32_t id = nextDumperId_++;
+    dumpers_[id] = std::move(dumper);
+    return id;
+}
+
+void WatchDogTimerWheel::RemoveDumper(uint32_t id)
+{
+    std::lock_guard<std::mutex> l(dumperLock_);
+    dumpers_.erase(id);
+}
+
+void WatchDogTimerWheel::SetTicking(bool ticking)
+{
+    // the timerfd only ticks while there are armed watchdogs, an idle wheel doesn't wake up.
+    struct itimerspec spec = {};
+    if (ticking) {
+        spec.it_interval.tv_sec = WHEEL_TICK_MS / MS_PER_SECOND;
+        spec.it_interval.tv_nsec = (WHEEL_TICK_MS % MS_PER_SECOND) * NS_PER_MS;
+        spec.it_value = spec.it_interval;
+    }
+    if (timerfd_settime(timerFd_, 0, &spec, nullptr) != 0) {
+        CAMERA_LOGE("watchdog timer wheel set timer failed");
         return;
     }
+    ticking_ = ticking;
+}
+
+void WatchDogTimerWheel::Loop()
+{
+    prctl(PR_SET_NAME, "camera_watchdog");
+
+    struct epoll_event events[EPOLL_EVENT_COUNT] = {};
+    while (true) {
+        int n = epoll_wait(epollFd_, events, EPOLL_EVENT_COUNT, -1);
+        for (int i = 0; i < n; i++) {
+            uint64_t value = 0;
+            if (read(events[i].data.fd, &value, sizeof(value)) != sizeof(value)) {
+                continue;
+            }
+            if (events[i].data.fd == exitFd_) {
+                return;
+            }
+            Tick(value);
+        }
+    }
+}
+
+void WatchDogTimerWheel::Tick(uint64_t ticks)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    for (uint64_t i = 0; i < ticks && !timers_.empty(); i++) {
+        cursor_ = (cursor_ + 1) % WHEEL_SLOT_COUNT;
+        TimerList& timers = slots_[cursor_];
+        for (auto it = timers.begin(); it != timers.end();) {
+            if (it->rounds > 0) {
+                it->rounds--;
+                it++;
+                continue;
+            }
+            timers_.erase(it->id);
+            auto next = std::next(it);
+            expired_.splice(expired_.end(), timers, it);
+            it = next;
+        }
+    }
+    if (timers_.empty() && ticking_) {
+        SetTicking(false);
+    }
+
+    while (!expired_.empty()) {
+        Timer timer = std::move(expired_.front());
+        expired_.pop_front();
+        firingId_ = timer.id;
+        l.unlock();
+        Expire(timer);
+        l.lock();
+        firingId_ = 0;
+        cv_.notify_all();
+    }
+}
+
+void WatchDogTimerWheel::Expire(const Timer& timer)
+{
+    CAMERA_LOGE("watchdog %{public}llu timeout after %{public}d ms", timer.id, timer.ms);
+    if (timer.executor) {
+        timer.executor();
+    }
+
+    if (timer.action == WATCHDOG_ACTION_DUMP) {
+        std::lock_guard<std::mutex> l(dumperLock_);
+        for (auto& it : dumpers_) {
+            it.second();
+        }
+    } else if (timer.action == WATCHDOG_ACTION_ABORT) {
+        std::abort();
+    }
+}
+
+WatchDog::WatchDog() {}
+
+void WatchDog::Init(int ms, std::function<void()> executor, bool isKill)
+{
+    Init(ms, executor, isKill ? WATCHDOG_ACTION_ABORT : WATCHDOG_ACTION_LOG);
+}
 
-    if (executor_) {
-        executor_();
+void WatchDog::Init(int ms, std::function<void()> executor, WatchDogAction action)
+{
+    if (timerId_ != 0) {
+        WatchDogTimerWheel::GetInstance().Disarm(timerId_);
     }
+    timerId_ = WatchDogTimerWheel::GetInstance().Arm(ms, executor, action);
+}
 
-    if (isKill_) {
-        KillProcess();
+WatchDog::~WatchDog()
+{
+    if (timerId_ != 0) {
+        WatchDogTimerWheel::GetInstance().Disarm(timerId_);
     }
-    return;
 }
 
-void WatchDog::KillProcess()
+uint32_t WatchDog::AddDumper(std::function<void()> dumper)
 {
-    raise(SIGKILL);
+    return WatchDogTimerWheel::GetInstance().AddDumper(dumper);
 }
 
-} // namespace Camera
+void WatchDog::RemoveDumper(uint32_t id)
+{
+    WatchDogTimerWheel::GetInstance().RemoveDumper(id);
+}
+} // namespace OHOS::Camera
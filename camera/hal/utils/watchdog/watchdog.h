@@ -16,42 +16,47 @@
 #ifndef HOS_CAMERA_WATCHDOG_H
 #define HOS_CAMERA_WATCHDOG_H
 
-#include <condition_variable>
-#include <memory>
-#include <mutex>
-#include <thread>
+#include <cstdint>
+#include <functional>
 
 namespace OHOS::Camera {
+// what a watchdog does after its executor on timeout.
+enum WatchDogAction {
+    WATCHDOG_ACTION_LOG = 0,
+    WATCHDOG_ACTION_DUMP,
+    WATCHDOG_ACTION_ABORT,
+};
+
+// A watchdog is armed by Init and disarmed when it's destroyed. All watchdogs of the process
+// share one timer wheel thread, arming and disarming one is O(1).
 class WatchDog {
 public:
     WatchDog();
     void Init(int ms, std::function<void()> executor, bool isKill = false);
+    void Init(int ms, std::function<void()> executor, WatchDogAction action);
     ~WatchDog();
 
-private:
-    void WaitForWakeUP();
-    void KillProcess();
+    // dumpers of the pipeline state, they are called on timeout of watchdogs with WATCHDOG_ACTION_DUMP.
+    static uint32_t AddDumper(std::function<void()> dumper);
+    static void RemoveDumper(uint32_t id);
 
 private:
-    int timeMs_ = 0;
-    std::function<void()> executor_ = nullptr;
-    std::condition_variable cv_;
-    std::mutex lock_;
-    std::unique_ptr<std::thread> handleThread_ = nullptr;
-    bool terminate_ = false;
-    bool isKill_ = false;
+    uint64_t timerId_ = 0;
 };
 
 #define WATCHDOG_TIMEOUT 10000
 
-#define PLACE_A_WATCHDOG(t, f, k) do { \
-    WatchDog _dog;                \
-    _dog.Init(t, f, k); \
-} while (0)
+#define WATCHDOG_CONCAT_INNER(a, b) a##b
+#define WATCHDOG_CONCAT(a, b) WATCHDOG_CONCAT_INNER(a, b)
+// the watchdog guards the rest of the enclosing scope.
+#define PLACE_A_WATCHDOG(t, f, k)             \
+    WatchDog WATCHDOG_CONCAT(_dog, __LINE__); \
+    WATCHDOG_CONCAT(_dog, __LINE__).Init(t, f, k)
 
 #define PLACE_A_WATCHDOG_DEFAULT_TIME(f, k) PLACE_A_WATCHDOG(WATCHDOG_TIMEOUT, f, k)
 #define PLACE_A_SELFKILL_WATCHDOG           PLACE_A_WATCHDOG_DEFAULT_TIME(nullptr, true)
 #define PLACE_A_NOKILL_WATCHDOG(f)          PLACE_A_WATCHDOG_DEFAULT_TIME(f, false);
+#define PLACE_A_DUMP_WATCHDOG(f)            PLACE_A_WATCHDOG_DEFAULT_TIME(f, WATCHDOG_ACTION_DUMP);
 } // namespace OHOS::Camera
 
 #endif
@@ -170,6 +170,27 @@ using EncodeType = enum _EncodeType : int32_t {
     ENCODE_TYPE_JPEG = 3,
 };
 
+/**
+ * @brief Enumerates the memory types used to exchange frames with the capture device.
+ */
+using StreamMemoryType = enum _StreamMemoryType : int32_t {
+    /**
+     * The device writes frames into the stream buffers directly.
+     */
+    MEMORY_TYPE_USERPTR = 0,
+
+    /**
+     * The device writes frames into its own mapped buffers, which are the buffers of the capture node and
+     * pass through the pipeline without copy. A frame is copied only into a stream buffer of other memory.
+     */
+    MEMORY_TYPE_MMAP = 1,
+
+    /**
+     * The device writes frames into the dma-buf fds of the stream buffers.
+     */
+    MEMORY_TYPE_DMABUF = 2,
+};
+
 /**
  * @brief Defines the stream information, which is used to pass configuration parameters during stream creation.
  */
@@ -229,6 +250,22 @@ using StreamInfo = struct _StreamInfo {
      * Encoding type.
      */
     EncodeType encodeType_;
+
+    /**
+     * Memory type used by the capture device for this stream.
+     */
+    StreamMemoryType memoryType_ = MEMORY_TYPE_USERPTR;
+
+    /**
+     * Number of buffers in the buffer queue. The value <b>0</b> means the default of the stream type.
+     */
+    int bufferCount_ = 0;
+
+    /**
+     * Adaptive buffer count. The value <b>true</b> means that the HAL grows or shrinks the buffer queue
+     * according to how often capture requests wait for a free buffer, and <b>false</b> means the opposite.
+     */
+    bool adaptiveBufferCount_ = false;
 };
 
 /**
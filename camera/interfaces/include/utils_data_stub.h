@@ -108,6 +108,10 @@ public:
         }
         bRet = (bRet && parcel.WriteInt32(static_cast<int32_t>(pInfo->minFrameDuration_)));
         bRet = (bRet && parcel.WriteInt32(pInfo->encodeType_));
+        bRet = (bRet && parcel.WriteInt32(STREAM_INFO_EXT_V1));
+        bRet = (bRet && parcel.WriteInt32(pInfo->memoryType_));
+        bRet = (bRet && parcel.WriteInt32(static_cast<int32_t>(pInfo->bufferCount_)));
+        bRet = (bRet && parcel.WriteBool(pInfo->adaptiveBufferCount_));
         return bRet;
     }
 
@@ -126,9 +130,22 @@ public:
         }
         pInfo->minFrameDuration_ = static_cast<int>(parcel.ReadInt32());
         pInfo->encodeType_ = static_cast<EncodeType>(parcel.ReadInt32());
+        // a peer of the first version ends the stream info here, the defaults are kept then.
+        size_t extPos = parcel.GetReadPosition();
+        if (parcel.ReadInt32() != STREAM_INFO_EXT_V1) {
+            parcel.RewindRead(extPos);
+            return;
+        }
+        pInfo->memoryType_ = static_cast<StreamMemoryType>(parcel.ReadInt32());
+        pInfo->bufferCount_ = static_cast<int>(parcel.ReadInt32());
+        pInfo->adaptiveBufferCount_ = parcel.ReadBool();
     }
 
 private:
+    // tag of the stream info fields after encodeType_: memoryType_, bufferCount_ and adaptiveBufferCount_.
+    // fields added later go behind them with a new tag.
+    static constexpr int32_t STREAM_INFO_EXT_V1 = 0x53490001;
+
     static int32_t GetDataSize(uint8_t type)
     {
         int32_t size = 0;